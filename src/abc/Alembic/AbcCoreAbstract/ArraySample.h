@@ -102,6 +102,12 @@ public:
     //! This is a calculation.
     Key getKey() const;
 
+    //! Compute the Key, hashing large POD samples in chunks when iChunked is
+    //! true regardless of SetChunkedArraySampleKeys.  iNumThreads 1 keeps
+    //! the chunks on the calling thread, otherwise they go to the pool given
+    //! to Util::SetParallelFor.
+    Key getKey( bool iChunked, size_t iNumThreads ) const;
+
     //! Return if it is valid.
     //! An empty ArraySample is valid.
     //! however, an ArraySample that is empty and has a scalar
@@ -149,6 +155,20 @@ ALEMBIC_EXPORT ArraySamplePtr
 AllocateArraySample( const DataType &iDtype,
                      const Dimensions &iDims );
 
+//-*****************************************************************************
+//! When enabled, ArraySample::getKey() hashes POD samples larger than
+//! Util::kMurmurHash3ChunkSize bytes with Util::MurmurHash3_x64_128_Chunked
+//! (iNumThreads 1 keeps the chunks on the calling thread).
+//! Those keys differ from the sequential ones but not between thread
+//! counts, so keep the setting unchanged while an archive is being written,
+//! or identical samples written before and after won't be shared.
+//! Disabled by default.  AbcCoreOgawa archives take the choice per archive
+//! from WriteArchive instead of this setting.
+ALEMBIC_EXPORT void
+SetChunkedArraySampleKeys( bool iEnabled, size_t iNumThreads = 0 );
+
+ALEMBIC_EXPORT bool GetChunkedArraySampleKeys();
+
 //-*****************************************************************************
 //-*****************************************************************************
 //-*****************************************************************************
@@ -37,12 +37,41 @@
 #include <Alembic/AbcCoreAbstract/ArraySample.h>
 #include <Alembic/Util/Murmur3.h>
 
+#include <atomic>
+
 namespace Alembic {
 namespace AbcCoreAbstract {
 namespace ALEMBIC_VERSION_NS {
 
+//-*****************************************************************************
+namespace {
+
+std::atomic< bool > g_chunkedKeys( false );
+std::atomic< size_t > g_chunkedKeyThreads( 0 );
+
+} // End anonymous namespace
+
+//-*****************************************************************************
+void SetChunkedArraySampleKeys( bool iEnabled, size_t iNumThreads )
+{
+    g_chunkedKeyThreads = iNumThreads;
+    g_chunkedKeys = iEnabled;
+}
+
+//-*****************************************************************************
+bool GetChunkedArraySampleKeys()
+{
+    return g_chunkedKeys;
+}
+
 //-*****************************************************************************
 ArraySample::Key ArraySample::getKey() const
+{
+    return getKey( g_chunkedKeys, g_chunkedKeyThreads );
+}
+
+//-*****************************************************************************
+ArraySample::Key ArraySample::getKey( bool iChunked, size_t iNumThreads ) const
 {
 
     // Depending on data type, loop over everything.
@@ -70,8 +99,17 @@ ArraySample::Key ArraySample::getKey() const
     case kFloat32POD:
     case kFloat64POD:
     {
-        MurmurHash3_x64_128( m_data, numBytes, PODNumBytes(m_dataType.getPod()),
-            k.digest.words );
+        if ( iChunked )
+        {
+            MurmurHash3_x64_128_Chunked( m_data, numBytes,
+                PODNumBytes(m_dataType.getPod()), k.digest.words,
+                iNumThreads );
+        }
+        else
+        {
+            MurmurHash3_x64_128( m_data, numBytes,
+                PODNumBytes(m_dataType.getPod()), k.digest.words );
+        }
     }
     break;
 
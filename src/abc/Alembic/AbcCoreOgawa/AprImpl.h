@@ -74,6 +74,9 @@ public:
     virtual void getAs( index_t iSample, void *iIntoLocation,
                         Alembic::Util::PlainOldDataType iPod );
 
+    // The header with the first and last changed sample index.
+    PropertyHeaderPtr getHeaderAndFriends() const { return m_header; }
+
 private:
 
     // Parent compound property writer. It must exist.
@@ -57,10 +57,14 @@ private:
     friend class WriteArchive;
 
     AwImpl( const std::string &iFileName,
-            const AbcA::MetaData &iMetaData );
+            const AbcA::MetaData &iMetaData,
+            bool iChunkedKeys,
+            size_t iNumKeyThreads );
 
     AwImpl( std::ostream * iStream,
-            const AbcA::MetaData & iMetaData );
+            const AbcA::MetaData & iMetaData,
+            bool iChunkedKeys,
+            size_t iNumKeyThreads );
 
 public:
     virtual ~AwImpl();
@@ -84,6 +88,11 @@ public:
         return m_writtenSampleMap;
     }
 
+    AbcA::ArraySample::Key getKey( const AbcA::ArraySample & iSamp ) const
+    {
+        return iSamp.getKey( m_chunkedKeys, m_numKeyThreads );
+    }
+
     MetaDataMapPtr getMetaDataMap()
     {
         return m_metaDataMap;
@@ -117,6 +126,9 @@ private:
 
     WrittenSampleMap m_writtenSampleMap;
     MetaDataMapPtr m_metaDataMap;
+
+    bool m_chunkedKeys;
+    size_t m_numKeyThreads;
 };
 
 } // End namespace ALEMBIC_VERSION_NS
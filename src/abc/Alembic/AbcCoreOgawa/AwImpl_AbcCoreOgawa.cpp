@@ -45,11 +45,15 @@ namespace ALEMBIC_VERSION_NS {
 
 //-*****************************************************************************
 AwImpl::AwImpl( const std::string &iFileName,
-                const AbcA::MetaData &iMetaData )
+                const AbcA::MetaData &iMetaData,
+                bool iChunkedKeys,
+                size_t iNumKeyThreads )
   : m_fileName( iFileName )
   , m_metaData( iMetaData )
   , m_archive( iFileName )
   , m_metaDataMap( new MetaDataMap() )
+  , m_chunkedKeys( iChunkedKeys )
+  , m_numKeyThreads( iNumKeyThreads )
 {
 
     // add default time sampling
@@ -67,10 +71,14 @@ AwImpl::AwImpl( const std::string &iFileName,
 
 //-*****************************************************************************
 AwImpl::AwImpl( std::ostream * iStream,
-                const AbcA::MetaData &iMetaData )
+                const AbcA::MetaData &iMetaData,
+                bool iChunkedKeys,
+                size_t iNumKeyThreads )
   : m_metaData( iMetaData )
   , m_archive( iStream )
   , m_metaDataMap( new MetaDataMap() )
+  , m_chunkedKeys( iChunkedKeys )
+  , m_numKeyThreads( iNumKeyThreads )
 {
     // add default time sampling
     AbcA::TimeSamplingPtr ts( new AbcA::TimeSampling() );
@@ -0,0 +1,127 @@
+//-*****************************************************************************
+//
+// Copyright (c) 2013,
+//  Sony Pictures Imageworks, Inc. and
+//  Industrial Light & Magic, a division of Lucasfilm Entertainment Company Ltd.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *       Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *       Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// *       Neither the name of Sony Pictures Imageworks, nor
+// Industrial Light & Magic nor the names of their contributors may be used
+// to endorse or promote products derived from this software without specific
+// prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//-*****************************************************************************
+
+#ifndef Alembic_AbcCoreOgawa_ConvertKernels_h
+#define Alembic_AbcCoreOgawa_ConvertKernels_h
+
+#include <Alembic/AbcCoreOgawa/Foundation.h>
+
+
+namespace Alembic {
+namespace AbcCoreOgawa {
+namespace ALEMBIC_VERSION_NS {
+
+//-*****************************************************************************
+//-*****************************************************************************
+// POD CONVERSION KERNELS
+//
+// Vectorized replacements for the hot float16/float32/float64 and int32
+// conversions done by ConvertData.  The results match the scalar ConvertData
+// templates, including the clamping of out of range values (but not NaN
+// payloads).  The instruction set is picked once at runtime, and large arrays
+// are split across threads when the source and destination do not overlap.
+//-*****************************************************************************
+
+//-*****************************************************************************
+enum ConvertKernelLevel
+{
+    kConvertScalar = 0,
+
+    // SSE2 for float32 <-> float64, float16 -> float32 and int32 -> float
+    kConvertSSE2,
+
+    // AVX2, plus F16C for the float16 kernels
+    kConvertAVX2
+};
+
+//-*****************************************************************************
+// The best level this CPU supports.
+ConvertKernelLevel GetSupportedConvertKernelLevel();
+
+//-*****************************************************************************
+// The level currently in use, defaults to the supported one.
+ConvertKernelLevel GetConvertKernelLevel();
+
+//-*****************************************************************************
+// Override the level, mostly for testing and benchmarks.  Requests above
+// what the CPU supports are clamped.
+void SetConvertKernelLevel( ConvertKernelLevel iLevel );
+
+//-*****************************************************************************
+// Maximum number of chunks one conversion is split into, 0 means use the
+// hardware concurrency and 1 disables the parallel path.  The chunks run on
+// the pool given to Util::SetParallelFor, or in order on the calling thread
+// when there is none.
+void SetConvertThreadCount( std::size_t iNumThreads );
+std::size_t GetConvertThreadCount();
+
+//-*****************************************************************************
+// Called after every POD conversion of ReadData with the number of source
+// bytes and the time it took.  Conversions are only timed while an observer
+// is set; by default there is none.
+typedef void ( *ConvertObserver )( std::size_t iSize,
+                                   Util::uint64_t iNanoseconds );
+void SetConvertObserver( ConvertObserver iObserver );
+ConvertObserver GetConvertObserver();
+
+//-*****************************************************************************
+// Convert iSize bytes worth of fromPod in fromBuffer into toPod in toBuffer.
+// The buffers may be the same (in-place widening, like ReadData does).
+// Returns false if there is no kernel for this pair, in which case nothing
+// was written and the caller should fall back to the generic conversion.
+bool
+ConvertDataFast( Util::PlainOldDataType fromPod,
+                 Util::PlainOldDataType toPod,
+                 const char * fromBuffer,
+                 void * toBuffer,
+                 std::size_t iSize );
+
+//-*****************************************************************************
+// Whether ConvertDataFast would split iSize bytes of fromPod across threads
+// given separate buffers.
+bool
+ConvertDataInParallel( Util::PlainOldDataType fromPod,
+                       Util::PlainOldDataType toPod,
+                       std::size_t iSize );
+
+} // End namespace ALEMBIC_VERSION_NS
+
+using namespace ALEMBIC_VERSION_NS;
+
+} // End namespace AbcCoreOgawa
+} // End namespace Alembic
+
+#endif
@@ -0,0 +1,740 @@
+//-*****************************************************************************
+//
+// Copyright (c) 2013,
+//  Sony Pictures Imageworks, Inc. and
+//  Industrial Light & Magic, a division of Lucasfilm Entertainment Company Ltd.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *       Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *       Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// *       Neither the name of Sony Pictures Imageworks, nor
+// Industrial Light & Magic nor the names of their contributors may be used
+// to endorse or promote products derived from this software without specific
+// prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//-*****************************************************************************
+
+#include <Alembic/AbcCoreOgawa/ConvertKernels.h>
+#include <Alembic/Util/ParallelFor.h>
+
+#if defined(_MSC_VER)
+#  if defined(max)
+#    undef max
+#  endif
+#  if defined(min)
+#    undef min
+#  endif
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || \
+    defined(__i386__)
+#  define ALEMBIC_CONVERT_X86 1
+#  include <immintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#    define ALEMBIC_TARGET_AVX2
+#  else
+#    define ALEMBIC_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#  endif
+#endif
+
+namespace Alembic {
+namespace AbcCoreOgawa {
+namespace ALEMBIC_VERSION_NS {
+
+namespace {
+
+typedef void ( *ConvertKernel )( const void * iFrom, void * oTo,
+                                 std::size_t iCount );
+
+// below this many elements threads cost more than they save
+const std::size_t kMinParallelElements = 1 << 18;
+const std::size_t kChunkAlignment = 64;
+
+//-*****************************************************************************
+// Clamping ranges, same as ConvertData in ReadUtil: always the range of the
+// narrower float type involved.
+const float kHalfMax = 65504.0f;
+const float kFloatMax = std::numeric_limits< Util::float32_t >::max();
+
+//-*****************************************************************************
+template < typename FROMPOD, typename TOPOD >
+inline TOPOD ClampCast( FROMPOD f, FROMPOD iMin, FROMPOD iMax )
+{
+    if ( f < iMin )
+    {
+        f = iMin;
+    }
+    else if ( f > iMax )
+    {
+        f = iMax;
+    }
+    return static_cast< TOPOD >( f );
+}
+
+//-*****************************************************************************
+// Scalar kernels, they run backwards when widening so in-place conversion
+// never clobbers unread input.  Values are clamped as CLAMPPOD, which is
+// float for float16 since half compares as float anyway.
+template < typename FROMPOD, typename TOPOD, typename CLAMPPOD >
+void ScalarConvert( const void * iFrom, void * oTo, std::size_t iCount,
+                    CLAMPPOD iMin, CLAMPPOD iMax )
+{
+    const FROMPOD * from = static_cast< const FROMPOD * >( iFrom );
+    TOPOD * to = static_cast< TOPOD * >( oTo );
+
+    if ( sizeof( TOPOD ) > sizeof( FROMPOD ) )
+    {
+        for ( std::size_t i = iCount; i > 0; --i )
+        {
+            CLAMPPOD f = static_cast< CLAMPPOD >( from[i-1] );
+            to[i-1] = ClampCast< CLAMPPOD, TOPOD >( f, iMin, iMax );
+        }
+    }
+    else
+    {
+        for ( std::size_t i = 0; i < iCount; ++i )
+        {
+            CLAMPPOD f = static_cast< CLAMPPOD >( from[i] );
+            to[i] = ClampCast< CLAMPPOD, TOPOD >( f, iMin, iMax );
+        }
+    }
+}
+
+void Float64ToFloat32Scalar( const void * iFrom, void * oTo, std::size_t n )
+{
+    ScalarConvert< Util::float64_t, Util::float32_t, Util::float64_t >(
+        iFrom, oTo, n, -kFloatMax, kFloatMax );
+}
+
+void Float32ToFloat64Scalar( const void * iFrom, void * oTo, std::size_t n )
+{
+    ScalarConvert< Util::float32_t, Util::float64_t, Util::float32_t >(
+        iFrom, oTo, n, -kFloatMax, kFloatMax );
+}
+
+void Float16ToFloat32Scalar( const void * iFrom, void * oTo, std::size_t n )
+{
+    ScalarConvert< Util::float16_t, Util::float32_t, float >(
+        iFrom, oTo, n, -kHalfMax, kHalfMax );
+}
+
+void Float32ToFloat16Scalar( const void * iFrom, void * oTo, std::size_t n )
+{
+    ScalarConvert< Util::float32_t, Util::float16_t, Util::float32_t >(
+        iFrom, oTo, n, -kHalfMax, kHalfMax );
+}
+
+void Float16ToFloat64Scalar( const void * iFrom, void * oTo, std::size_t n )
+{
+    ScalarConvert< Util::float16_t, Util::float64_t, float >(
+        iFrom, oTo, n, -kHalfMax, kHalfMax );
+}
+
+void Float64ToFloat16Scalar( const void * iFrom, void * oTo, std::size_t n )
+{
+    ScalarConvert< Util::float64_t, Util::float16_t, Util::float64_t >(
+        iFrom, oTo, n, -kHalfMax, kHalfMax );
+}
+
+void Int32ToFloat32Scalar( const void * iFrom, void * oTo, std::size_t n )
+{
+    ScalarConvert< Util::int32_t, Util::float32_t, Util::int32_t >(
+        iFrom, oTo, n, std::numeric_limits< Util::int32_t >::min(),
+        std::numeric_limits< Util::int32_t >::max() );
+}
+
+void Int32ToFloat64Scalar( const void * iFrom, void * oTo, std::size_t n )
+{
+    ScalarConvert< Util::int32_t, Util::float64_t, Util::int32_t >(
+        iFrom, oTo, n, std::numeric_limits< Util::int32_t >::min(),
+        std::numeric_limits< Util::int32_t >::max() );
+}
+
+#ifdef ALEMBIC_CONVERT_X86
+
+//-*****************************************************************************
+// NOTE: max( lo, x ) and min( hi, x ) return x when x is NaN, which keeps the
+// scalar "neither smaller nor bigger" behavior.
+
+//-*****************************************************************************
+// SSE2
+//-*****************************************************************************
+void Float64ToFloat32SSE2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const double * from = static_cast< const double * >( iFrom );
+    float * to = static_cast< float * >( oTo );
+
+    const __m128d lo = _mm_set1_pd( -kFloatMax );
+    const __m128d hi = _mm_set1_pd( kFloatMax );
+
+    std::size_t i = 0;
+    for ( ; i + 4 <= n; i += 4 )
+    {
+        __m128d a = _mm_loadu_pd( from + i );
+        __m128d b = _mm_loadu_pd( from + i + 2 );
+        a = _mm_min_pd( hi, _mm_max_pd( lo, a ) );
+        b = _mm_min_pd( hi, _mm_max_pd( lo, b ) );
+        _mm_storeu_ps( to + i,
+            _mm_movelh_ps( _mm_cvtpd_ps( a ), _mm_cvtpd_ps( b ) ) );
+    }
+    Float64ToFloat32Scalar( from + i, to + i, n - i );
+}
+
+void Float32ToFloat64SSE2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const float * from = static_cast< const float * >( iFrom );
+    double * to = static_cast< double * >( oTo );
+
+    const __m128 lo = _mm_set1_ps( -kFloatMax );
+    const __m128 hi = _mm_set1_ps( kFloatMax );
+
+    std::size_t i = n;
+    while ( i >= 4 )
+    {
+        i -= 4;
+        __m128 f = _mm_loadu_ps( from + i );
+        f = _mm_min_ps( hi, _mm_max_ps( lo, f ) );
+        __m128d a = _mm_cvtps_pd( f );
+        __m128d b = _mm_cvtps_pd( _mm_movehl_ps( f, f ) );
+        _mm_storeu_pd( to + i, a );
+        _mm_storeu_pd( to + i + 2, b );
+    }
+    Float32ToFloat64Scalar( from, to, i );
+}
+
+//-*****************************************************************************
+// halfToFloatBitwise is vectorized itself, clamp each block while it is still
+// in cache.  Not halfToFloat, which would pick F16C at this level.
+void Float16ToFloat32SSE2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const Util::float16_t * from =
+        static_cast< const Util::float16_t * >( iFrom );
+    float * to = static_cast< float * >( oTo );
+
+    const __m128 lo = _mm_set1_ps( -kHalfMax );
+    const __m128 hi = _mm_set1_ps( kHalfMax );
+    const std::size_t kBlock = 1024;
+
+    std::size_t i = n;
+    while ( i > 0 )
+    {
+        std::size_t count = std::min( i, kBlock );
+        i -= count;
+        halfToFloatBitwise( from + i, to + i, count );
+
+        float * block = to + i;
+        std::size_t j = 0;
+        for ( ; j + 4 <= count; j += 4 )
+        {
+            __m128 f = _mm_loadu_ps( block + j );
+            _mm_storeu_ps( block + j, _mm_min_ps( hi, _mm_max_ps( lo, f ) ) );
+        }
+        for ( ; j < count; ++j )
+        {
+            block[j] = ClampCast< float, float >( block[j], -kHalfMax,
+                                                  kHalfMax );
+        }
+    }
+}
+
+void Int32ToFloat32SSE2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const Util::int32_t * from = static_cast< const Util::int32_t * >( iFrom );
+    float * to = static_cast< float * >( oTo );
+
+    std::size_t i = 0;
+    for ( ; i + 4 <= n; i += 4 )
+    {
+        __m128i v = _mm_loadu_si128( ( const __m128i * )( from + i ) );
+        _mm_storeu_ps( to + i, _mm_cvtepi32_ps( v ) );
+    }
+    Int32ToFloat32Scalar( from + i, to + i, n - i );
+}
+
+void Int32ToFloat64SSE2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const Util::int32_t * from = static_cast< const Util::int32_t * >( iFrom );
+    double * to = static_cast< double * >( oTo );
+
+    std::size_t i = n;
+    while ( i >= 4 )
+    {
+        i -= 4;
+        __m128i v = _mm_loadu_si128( ( const __m128i * )( from + i ) );
+        __m128d a = _mm_cvtepi32_pd( v );
+        __m128d b = _mm_cvtepi32_pd( _mm_srli_si128( v, 8 ) );
+        _mm_storeu_pd( to + i, a );
+        _mm_storeu_pd( to + i + 2, b );
+    }
+    Int32ToFloat64Scalar( from, to, i );
+}
+
+//-*****************************************************************************
+// AVX2 + F16C
+//-*****************************************************************************
+ALEMBIC_TARGET_AVX2
+void Float64ToFloat32AVX2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const double * from = static_cast< const double * >( iFrom );
+    float * to = static_cast< float * >( oTo );
+
+    const __m256d lo = _mm256_set1_pd( -kFloatMax );
+    const __m256d hi = _mm256_set1_pd( kFloatMax );
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        __m256d a = _mm256_loadu_pd( from + i );
+        __m256d b = _mm256_loadu_pd( from + i + 4 );
+        a = _mm256_min_pd( hi, _mm256_max_pd( lo, a ) );
+        b = _mm256_min_pd( hi, _mm256_max_pd( lo, b ) );
+        __m256 f = _mm256_insertf128_ps(
+            _mm256_castps128_ps256( _mm256_cvtpd_ps( a ) ),
+            _mm256_cvtpd_ps( b ), 1 );
+        _mm256_storeu_ps( to + i, f );
+    }
+    Float64ToFloat32Scalar( from + i, to + i, n - i );
+}
+
+ALEMBIC_TARGET_AVX2
+void Float32ToFloat64AVX2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const float * from = static_cast< const float * >( iFrom );
+    double * to = static_cast< double * >( oTo );
+
+    const __m256 lo = _mm256_set1_ps( -kFloatMax );
+    const __m256 hi = _mm256_set1_ps( kFloatMax );
+
+    std::size_t i = n;
+    while ( i >= 8 )
+    {
+        i -= 8;
+        __m256 f = _mm256_loadu_ps( from + i );
+        f = _mm256_min_ps( hi, _mm256_max_ps( lo, f ) );
+        __m256d a = _mm256_cvtps_pd( _mm256_castps256_ps128( f ) );
+        __m256d b = _mm256_cvtps_pd( _mm256_extractf128_ps( f, 1 ) );
+        _mm256_storeu_pd( to + i, a );
+        _mm256_storeu_pd( to + i + 4, b );
+    }
+    Float32ToFloat64Scalar( from, to, i );
+}
+
+ALEMBIC_TARGET_AVX2
+void Float16ToFloat32AVX2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const Util::uint16_t * from =
+        static_cast< const Util::uint16_t * >( iFrom );
+    float * to = static_cast< float * >( oTo );
+
+    const __m256 lo = _mm256_set1_ps( -kHalfMax );
+    const __m256 hi = _mm256_set1_ps( kHalfMax );
+
+    std::size_t i = n;
+    while ( i >= 8 )
+    {
+        i -= 8;
+        __m128i h = _mm_loadu_si128( ( const __m128i * )( from + i ) );
+        __m256 f = _mm256_cvtph_ps( h );
+        f = _mm256_min_ps( hi, _mm256_max_ps( lo, f ) );
+        _mm256_storeu_ps( to + i, f );
+    }
+    Float16ToFloat32Scalar( from, to, i );
+}
+
+ALEMBIC_TARGET_AVX2
+void Float32ToFloat16AVX2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const float * from = static_cast< const float * >( iFrom );
+    Util::uint16_t * to = static_cast< Util::uint16_t * >( oTo );
+
+    const __m256 lo = _mm256_set1_ps( -kHalfMax );
+    const __m256 hi = _mm256_set1_ps( kHalfMax );
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        __m256 f = _mm256_loadu_ps( from + i );
+        f = _mm256_min_ps( hi, _mm256_max_ps( lo, f ) );
+        _mm_storeu_si128( ( __m128i * )( to + i ),
+            _mm256_cvtps_ph( f, _MM_FROUND_TO_NEAREST_INT ) );
+    }
+    Float32ToFloat16Scalar( from + i, to + i, n - i );
+}
+
+ALEMBIC_TARGET_AVX2
+void Float16ToFloat64AVX2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const Util::uint16_t * from =
+        static_cast< const Util::uint16_t * >( iFrom );
+    double * to = static_cast< double * >( oTo );
+
+    const __m256 lo = _mm256_set1_ps( -kHalfMax );
+    const __m256 hi = _mm256_set1_ps( kHalfMax );
+
+    std::size_t i = n;
+    while ( i >= 8 )
+    {
+        i -= 8;
+        __m128i h = _mm_loadu_si128( ( const __m128i * )( from + i ) );
+        __m256 f = _mm256_cvtph_ps( h );
+        f = _mm256_min_ps( hi, _mm256_max_ps( lo, f ) );
+        __m256d a = _mm256_cvtps_pd( _mm256_castps256_ps128( f ) );
+        __m256d b = _mm256_cvtps_pd( _mm256_extractf128_ps( f, 1 ) );
+        _mm256_storeu_pd( to + i, a );
+        _mm256_storeu_pd( to + i + 4, b );
+    }
+    Float16ToFloat64Scalar( from, to, i );
+}
+
+ALEMBIC_TARGET_AVX2
+void Float64ToFloat16AVX2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const double * from = static_cast< const double * >( iFrom );
+    Util::uint16_t * to = static_cast< Util::uint16_t * >( oTo );
+
+    const __m256d lo = _mm256_set1_pd( -kHalfMax );
+    const __m256d hi = _mm256_set1_pd( kHalfMax );
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        __m256d a = _mm256_loadu_pd( from + i );
+        __m256d b = _mm256_loadu_pd( from + i + 4 );
+        a = _mm256_min_pd( hi, _mm256_max_pd( lo, a ) );
+        b = _mm256_min_pd( hi, _mm256_max_pd( lo, b ) );
+        __m256 f = _mm256_insertf128_ps(
+            _mm256_castps128_ps256( _mm256_cvtpd_ps( a ) ),
+            _mm256_cvtpd_ps( b ), 1 );
+        _mm_storeu_si128( ( __m128i * )( to + i ),
+            _mm256_cvtps_ph( f, _MM_FROUND_TO_NEAREST_INT ) );
+    }
+    Float64ToFloat16Scalar( from + i, to + i, n - i );
+}
+
+ALEMBIC_TARGET_AVX2
+void Int32ToFloat32AVX2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const Util::int32_t * from = static_cast< const Util::int32_t * >( iFrom );
+    float * to = static_cast< float * >( oTo );
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        __m256i v = _mm256_loadu_si256( ( const __m256i * )( from + i ) );
+        _mm256_storeu_ps( to + i, _mm256_cvtepi32_ps( v ) );
+    }
+    Int32ToFloat32Scalar( from + i, to + i, n - i );
+}
+
+ALEMBIC_TARGET_AVX2
+void Int32ToFloat64AVX2( const void * iFrom, void * oTo, std::size_t n )
+{
+    const Util::int32_t * from = static_cast< const Util::int32_t * >( iFrom );
+    double * to = static_cast< double * >( oTo );
+
+    std::size_t i = n;
+    while ( i >= 8 )
+    {
+        i -= 8;
+        __m256i v = _mm256_loadu_si256( ( const __m256i * )( from + i ) );
+        __m256d a = _mm256_cvtepi32_pd( _mm256_castsi256_si128( v ) );
+        __m256d b = _mm256_cvtepi32_pd( _mm256_extracti128_si256( v, 1 ) );
+        _mm256_storeu_pd( to + i, a );
+        _mm256_storeu_pd( to + i + 4, b );
+    }
+    Int32ToFloat64Scalar( from, to, i );
+}
+
+//-*****************************************************************************
+ConvertKernelLevel DetectConvertKernelLevel()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid( info, 0 );
+    int numIds = info[0];
+
+    __cpuid( info, 1 );
+    bool sse2 = ( info[3] & ( 1 << 26 ) ) != 0;
+    bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+    bool avx = ( info[2] & ( 1 << 28 ) ) != 0;
+    bool f16c = ( info[2] & ( 1 << 29 ) ) != 0;
+
+    bool avx2 = false;
+    if ( numIds >= 7 )
+    {
+        __cpuidex( info, 7, 0 );
+        avx2 = ( info[1] & ( 1 << 5 ) ) != 0;
+    }
+
+    // the OS also has to save the ymm registers
+    bool ymm = osxsave && ( _xgetbv( 0 ) & 6 ) == 6;
+
+    if ( avx && avx2 && f16c && ymm )
+    {
+        return kConvertAVX2;
+    }
+    return sse2 ? kConvertSSE2 : kConvertScalar;
+#else
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "f16c" ) )
+    {
+        return kConvertAVX2;
+    }
+    return __builtin_cpu_supports( "sse2" ) ? kConvertSSE2 : kConvertScalar;
+#endif
+}
+
+#else
+
+ConvertKernelLevel DetectConvertKernelLevel()
+{
+    return kConvertScalar;
+}
+
+#endif
+
+//-*****************************************************************************
+ConvertKernelLevel & SupportedLevel()
+{
+    static ConvertKernelLevel level = DetectConvertKernelLevel();
+    return level;
+}
+
+// set from the host while readers may be converting, same as the observer
+std::atomic< int > g_levelOverride( -1 );
+std::atomic< std::size_t > g_numThreads( 0 );
+
+std::atomic< ConvertObserver > g_convertObserver( NULL );
+
+//-*****************************************************************************
+ConvertKernel
+FindKernel( Util::PlainOldDataType fromPod,
+            Util::PlainOldDataType toPod,
+            ConvertKernelLevel iLevel )
+{
+    // scalar, SSE2, AVX2
+    static const ConvertKernel kNone[3] = { 0, 0, 0 };
+
+#ifdef ALEMBIC_CONVERT_X86
+    static const ConvertKernel f64ToF32[3] = { Float64ToFloat32Scalar,
+        Float64ToFloat32SSE2, Float64ToFloat32AVX2 };
+    static const ConvertKernel f32ToF64[3] = { Float32ToFloat64Scalar,
+        Float32ToFloat64SSE2, Float32ToFloat64AVX2 };
+    static const ConvertKernel f16ToF32[3] = { Float16ToFloat32Scalar,
+        Float16ToFloat32SSE2, Float16ToFloat32AVX2 };
+    static const ConvertKernel f32ToF16[3] = { Float32ToFloat16Scalar,
+        Float32ToFloat16Scalar, Float32ToFloat16AVX2 };
+    static const ConvertKernel f16ToF64[3] = { Float16ToFloat64Scalar,
+        Float16ToFloat64Scalar, Float16ToFloat64AVX2 };
+    static const ConvertKernel f64ToF16[3] = { Float64ToFloat16Scalar,
+        Float64ToFloat16Scalar, Float64ToFloat16AVX2 };
+    static const ConvertKernel i32ToF32[3] = { Int32ToFloat32Scalar,
+        Int32ToFloat32SSE2, Int32ToFloat32AVX2 };
+    static const ConvertKernel i32ToF64[3] = { Int32ToFloat64Scalar,
+        Int32ToFloat64SSE2, Int32ToFloat64AVX2 };
+#else
+    static const ConvertKernel f64ToF32[3] = { Float64ToFloat32Scalar,
+        Float64ToFloat32Scalar, Float64ToFloat32Scalar };
+    static const ConvertKernel f32ToF64[3] = { Float32ToFloat64Scalar,
+        Float32ToFloat64Scalar, Float32ToFloat64Scalar };
+    static const ConvertKernel f16ToF32[3] = { Float16ToFloat32Scalar,
+        Float16ToFloat32Scalar, Float16ToFloat32Scalar };
+    static const ConvertKernel f32ToF16[3] = { Float32ToFloat16Scalar,
+        Float32ToFloat16Scalar, Float32ToFloat16Scalar };
+    static const ConvertKernel f16ToF64[3] = { Float16ToFloat64Scalar,
+        Float16ToFloat64Scalar, Float16ToFloat64Scalar };
+    static const ConvertKernel f64ToF16[3] = { Float64ToFloat16Scalar,
+        Float64ToFloat16Scalar, Float64ToFloat16Scalar };
+    static const ConvertKernel i32ToF32[3] = { Int32ToFloat32Scalar,
+        Int32ToFloat32Scalar, Int32ToFloat32Scalar };
+    static const ConvertKernel i32ToF64[3] = { Int32ToFloat64Scalar,
+        Int32ToFloat64Scalar, Int32ToFloat64Scalar };
+#endif
+
+    const ConvertKernel * kernels = kNone;
+    switch ( fromPod )
+    {
+        case Util::kFloat16POD:
+            kernels = ( toPod == Util::kFloat32POD ) ? f16ToF32 :
+                      ( toPod == Util::kFloat64POD ) ? f16ToF64 : kNone;
+        break;
+
+        case Util::kFloat32POD:
+            kernels = ( toPod == Util::kFloat16POD ) ? f32ToF16 :
+                      ( toPod == Util::kFloat64POD ) ? f32ToF64 : kNone;
+        break;
+
+        case Util::kFloat64POD:
+            kernels = ( toPod == Util::kFloat16POD ) ? f64ToF16 :
+                      ( toPod == Util::kFloat32POD ) ? f64ToF32 : kNone;
+        break;
+
+        case Util::kInt32POD:
+            kernels = ( toPod == Util::kFloat32POD ) ? i32ToF32 :
+                      ( toPod == Util::kFloat64POD ) ? i32ToF64 : kNone;
+        break;
+
+        default:
+        break;
+    }
+
+    return kernels[iLevel];
+}
+
+//-*****************************************************************************
+std::size_t NumConvertThreads( std::size_t iNumElements )
+{
+    if ( iNumElements < kMinParallelElements )
+    {
+        return 1;
+    }
+
+    std::size_t numThreads = g_numThreads.load( std::memory_order_relaxed );
+    if ( numThreads == 0 )
+    {
+        numThreads = std::max< std::size_t >(
+            std::thread::hardware_concurrency(), 1 );
+    }
+
+    // keep every thread busy with at least a quarter of the threshold
+    std::size_t maxThreads = iNumElements / ( kMinParallelElements / 4 );
+    return std::max< std::size_t >( std::min( numThreads, maxThreads ), 1 );
+}
+
+} // End anonymous namespace
+
+//-*****************************************************************************
+ConvertKernelLevel GetSupportedConvertKernelLevel()
+{
+    return SupportedLevel();
+}
+
+//-*****************************************************************************
+ConvertKernelLevel GetConvertKernelLevel()
+{
+    int level = g_levelOverride.load( std::memory_order_relaxed );
+    if ( level < 0 )
+    {
+        return SupportedLevel();
+    }
+    return static_cast< ConvertKernelLevel >( level );
+}
+
+//-*****************************************************************************
+void SetConvertKernelLevel( ConvertKernelLevel iLevel )
+{
+    g_levelOverride.store( std::min( iLevel, SupportedLevel() ) );
+}
+
+//-*****************************************************************************
+void SetConvertThreadCount( std::size_t iNumThreads )
+{
+    g_numThreads.store( iNumThreads );
+}
+
+//-*****************************************************************************
+std::size_t GetConvertThreadCount()
+{
+    return g_numThreads.load();
+}
+
+//-*****************************************************************************
+void SetConvertObserver( ConvertObserver iObserver )
+{
+    g_convertObserver.store( iObserver );
+}
+
+//-*****************************************************************************
+ConvertObserver GetConvertObserver()
+{
+    return g_convertObserver.load( std::memory_order_relaxed );
+}
+
+//-*****************************************************************************
+bool
+ConvertDataInParallel( Util::PlainOldDataType fromPod,
+                       Util::PlainOldDataType toPod,
+                       std::size_t iSize )
+{
+    if ( !FindKernel( fromPod, toPod, kConvertScalar ) )
+    {
+        return false;
+    }
+    return NumConvertThreads( iSize / PODNumBytes( fromPod ) ) > 1;
+}
+
+//-*****************************************************************************
+bool
+ConvertDataFast( Util::PlainOldDataType fromPod,
+                 Util::PlainOldDataType toPod,
+                 const char * fromBuffer,
+                 void * toBuffer,
+                 std::size_t iSize )
+{
+    ConvertKernel kernel = FindKernel( fromPod, toPod,
+                                       GetConvertKernelLevel() );
+    if ( !kernel )
+    {
+        return false;
+    }
+
+    std::size_t fromBytes = PODNumBytes( fromPod );
+    std::size_t toBytes = PODNumBytes( toPod );
+    std::size_t numConvert = iSize / fromBytes;
+
+    const char * fromEnd = fromBuffer + numConvert * fromBytes;
+    char * to = static_cast< char * >( toBuffer );
+    char * toEnd = to + numConvert * toBytes;
+    bool overlap = fromBuffer < toEnd && to < fromEnd;
+
+    std::size_t numThreads = overlap ? 1 : NumConvertThreads( numConvert );
+    if ( numThreads < 2 )
+    {
+        kernel( fromBuffer, toBuffer, numConvert );
+        return true;
+    }
+
+    std::size_t chunk = ( numConvert + numThreads - 1 ) / numThreads;
+    chunk = ( chunk + kChunkAlignment - 1 ) / kChunkAlignment *
+        kChunkAlignment;
+
+    // the chunks go to the pool of the host, see Util::SetParallelFor
+    std::size_t numChunks = ( numConvert + chunk - 1 ) / chunk;
+    Util::RunParallelFor( numChunks, [&]( std::size_t i )
+    {
+        std::size_t beg = i * chunk;
+        kernel( fromBuffer + beg * fromBytes, to + beg * toBytes,
+                std::min( chunk, numConvert - beg ) );
+    } );
+    return true;
+}
+
+} // End namespace ALEMBIC_VERSION_NS
+} // End namespace AbcCoreOgawa
+} // End namespace Alembic
@@ -64,6 +64,17 @@ ReadData( void * iIntoLocation,
           const AbcA::DataType &iDataType,
           Util::PlainOldDataType iAsPod );
 
+//-*****************************************************************************
+// The templated ConvertData conversions alone, without the vectorized kernels
+// of ConvertDataFast.  ReadData falls back to it for the pairs that have no
+// kernel, and it is the reference the kernels are tested against.
+void
+ConvertPodsGeneric( Util::PlainOldDataType fromPod,
+                    Util::PlainOldDataType toPod,
+                    char * fromBuffer,
+                    void * toBuffer,
+                    std::size_t iSize );
+
 //-*****************************************************************************
 void
 ReadArraySample( Ogawa::IDataPtr iDims,
@@ -35,6 +35,7 @@
 //-*****************************************************************************
 
 #include <Alembic/AbcCoreOgawa/ReadUtil.h>
+#include <Alembic/AbcCoreOgawa/ConvertKernels.h>
 
 #if defined(_MSC_VER)
 #  if defined(max)
@@ -47,6 +48,8 @@
 
 #include <halfLimits.h>
 
+#include <chrono>
+
 namespace Alembic {
 namespace AbcCoreOgawa {
 namespace ALEMBIC_VERSION_NS {
@@ -249,13 +252,12 @@ void ConvertData( char * fromBuffer, void * toBuffer, std::size_t iSize )
 
 //-*****************************************************************************
 void
-ConvertData( Alembic::Util::PlainOldDataType fromPod,
-             Alembic::Util::PlainOldDataType toPod,
-             char * fromBuffer,
-             void * toBuffer,
-             std::size_t iSize )
+ConvertPodsGeneric( Alembic::Util::PlainOldDataType fromPod,
+                    Alembic::Util::PlainOldDataType toPod,
+                    char * fromBuffer,
+                    void * toBuffer,
+                    std::size_t iSize )
 {
-
     switch (fromPod)
     {
         case Util::kBooleanPOD:
@@ -1307,6 +1309,46 @@ ConvertData( Alembic::Util::PlainOldDataType fromPod,
     }
 }
 
+//-*****************************************************************************
+void
+ConvertPods( Alembic::Util::PlainOldDataType fromPod,
+             Alembic::Util::PlainOldDataType toPod,
+             char * fromBuffer,
+             void * toBuffer,
+             std::size_t iSize )
+{
+    // the common float and int32 conversions have vectorized kernels
+    if ( ConvertDataFast( fromPod, toPod, fromBuffer, toBuffer, iSize ) )
+    {
+        return;
+    }
+
+    ConvertPodsGeneric( fromPod, toPod, fromBuffer, toBuffer, iSize );
+}
+
+//-*****************************************************************************
+void
+ConvertData( Alembic::Util::PlainOldDataType fromPod,
+             Alembic::Util::PlainOldDataType toPod,
+             char * fromBuffer,
+             void * toBuffer,
+             std::size_t iSize )
+{
+    ConvertObserver observer = GetConvertObserver();
+    if ( !observer )
+    {
+        ConvertPods( fromPod, toPod, fromBuffer, toBuffer, iSize );
+        return;
+    }
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    ConvertPods( fromPod, toPod, fromBuffer, toBuffer, iSize );
+    observer( iSize, ( Util::uint64_t )
+        std::chrono::duration_cast< std::chrono::nanoseconds >(
+            std::chrono::steady_clock::now() - start ).count() );
+}
+
 //-*****************************************************************************
 void
 ReadData( void * iIntoLocation,
@@ -1399,6 +1441,19 @@ ReadData( void * iIntoLocation,
         // don't read the key
         iData->read( dataSize - 16, iIntoLocation, 16, iThreadId );
     }
+    else if ( PODNumBytes( curPod ) <= PODNumBytes( iAsPod ) &&
+              ConvertDataInParallel( curPod, iAsPod, dataSize - 16 ) )
+    {
+        // - 16 to skip key
+        std::size_t numBytes = dataSize - 16;
+
+        // big enough to convert on several threads, which can't be done
+        // in place, so read into a temporary buffer first
+        std::vector< char > buf( numBytes );
+        iData->read( numBytes, &buf.front(), 16, iThreadId );
+
+        ConvertData( curPod, iAsPod, &buf.front(), iIntoLocation, numBytes );
+    }
     else if ( PODNumBytes( curPod ) <= PODNumBytes( iAsPod ) )
     {
         // - 16 to skip key
@@ -51,6 +51,13 @@ class ALEMBIC_EXPORT WriteArchive
 public:
     WriteArchive();
 
+    // When iChunkedKeys is true the keys used to share identical array
+    // samples are computed in chunks on the pool given to
+    // Util::SetParallelFor (iNumKeyThreads 1 keeps them on the writing
+    // thread), see AbcA::SetChunkedArraySampleKeys.  The choice holds for
+    // the whole archive.
+    WriteArchive( bool iChunkedKeys, size_t iNumKeyThreads = 0 );
+
     ::Alembic::AbcCoreAbstract::ArchiveWriterPtr
     operator()( const std::string &iFileName,
                 const ::Alembic::AbcCoreAbstract::MetaData &iMetaData ) const;
@@ -58,6 +65,10 @@ public:
     ::Alembic::AbcCoreAbstract::ArchiveWriterPtr
     operator()( std::ostream * iStream,
                 const ::Alembic::AbcCoreAbstract::MetaData &iMetaData ) const;
+
+private:
+    bool m_chunkedKeys;
+    size_t m_numKeyThreads;
 };
 
 //-*****************************************************************************
@@ -93,6 +104,18 @@ private:
     std::vector< std::istream * > m_streams;
 };
 
+//-*****************************************************************************
+//! The first and the last sample of a scalar or array property that differ
+//! from the sample before them, both 0 for a constant property.  Ogawa stores
+//! sample 0, then one sample per index from oFirst to oLast; the samples
+//! after oLast are not stored again.  Returns false when iProperty was not
+//! read from an Ogawa archive.
+ALEMBIC_EXPORT bool
+GetChangedSampleRange( ::Alembic::AbcCoreAbstract::BasePropertyReaderPtr
+                           iProperty,
+                       ::Alembic::Util::uint32_t & oFirst,
+                       ::Alembic::Util::uint32_t & oLast );
+
 } // End namespace ALEMBIC_VERSION_NS
 
 using namespace ALEMBIC_VERSION_NS;
@@ -38,6 +38,8 @@
 #include <Alembic/AbcCoreOgawa/Foundation.h>
 #include <Alembic/AbcCoreOgawa/AwImpl.h>
 #include <Alembic/AbcCoreOgawa/ArImpl.h>
+#include <Alembic/AbcCoreOgawa/AprImpl.h>
+#include <Alembic/AbcCoreOgawa/SprImpl.h>
 
 namespace Alembic {
 namespace AbcCoreOgawa {
@@ -45,6 +47,13 @@ namespace ALEMBIC_VERSION_NS {
 
 //-*****************************************************************************
 WriteArchive::WriteArchive()
+    : m_chunkedKeys( false ), m_numKeyThreads( 0 )
+{
+}
+
+//-*****************************************************************************
+WriteArchive::WriteArchive( bool iChunkedKeys, size_t iNumKeyThreads )
+    : m_chunkedKeys( iChunkedKeys ), m_numKeyThreads( iNumKeyThreads )
 {
 }
 
@@ -54,7 +63,7 @@ WriteArchive::operator()( const std::string &iFileName,
                           const AbcA::MetaData &iMetaData ) const
 {
     Alembic::Util::shared_ptr<AwImpl> archivePtr(
-        new AwImpl( iFileName, iMetaData ) );
+        new AwImpl( iFileName, iMetaData, m_chunkedKeys, m_numKeyThreads ) );
     return archivePtr;
 }
 
@@ -64,7 +73,7 @@ WriteArchive::operator()( std::ostream * iStream,
                           const AbcA::MetaData &iMetaData ) const
 {
     Alembic::Util::shared_ptr<AwImpl> archivePtr(
-        new AwImpl( iStream, iMetaData ) );
+        new AwImpl( iStream, iMetaData, m_chunkedKeys, m_numKeyThreads ) );
     return archivePtr;
 }
 
@@ -128,6 +137,31 @@ ReadArchive::operator()( const std::string &iFileName,
     return archivePtr;
 }
 
+//-*****************************************************************************
+bool GetChangedSampleRange( AbcA::BasePropertyReaderPtr iProperty,
+                            Util::uint32_t & oFirst,
+                            Util::uint32_t & oLast )
+{
+    PropertyHeaderPtr header;
+    if ( AprImpl * array = dynamic_cast< AprImpl * >( iProperty.get() ) )
+    {
+        header = array->getHeaderAndFriends();
+    }
+    else if ( SprImpl * scalar = dynamic_cast< SprImpl * >( iProperty.get() ) )
+    {
+        header = scalar->getHeaderAndFriends();
+    }
+
+    if ( !header )
+    {
+        return false;
+    }
+
+    oFirst = header->firstChangedIndex;
+    oLast = header->lastChangedIndex;
+    return true;
+}
+
 } // End namespace ALEMBIC_VERSION_NS
 } // End namespace AbcCoreOgawa
 } // End namespace Alembic
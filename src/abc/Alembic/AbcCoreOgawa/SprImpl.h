@@ -70,6 +70,9 @@ public:
     virtual std::pair<index_t, chrono_t> getCeilIndex( chrono_t iTime );
     virtual std::pair<index_t, chrono_t> getNearIndex( chrono_t iTime );
 
+    // The header with the first and last changed sample index.
+    PropertyHeaderPtr getHeaderAndFriends() const { return m_header; }
+
 private:
 
     // Parent compound property writer. It must exist.
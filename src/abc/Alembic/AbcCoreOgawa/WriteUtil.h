@@ -59,6 +59,11 @@ void HashDimensions( const AbcA::Dimensions & iDims,
 WrittenSampleMap& GetWrittenSampleMap(
     AbcA::ArchiveWriterPtr iArchive );
 
+//-*****************************************************************************
+// The key of iSamp, computed the way iArchive was configured to.
+AbcA::ArraySample::Key GetArraySampleKey(
+    AbcA::ArchiveWriterPtr iArchive, const AbcA::ArraySample & iSamp );
+
 //-*****************************************************************************
 void
 WriteDimensions( Ogawa::OGroupPtr iGroup,
@@ -72,6 +72,14 @@ private:
 };
 typedef Alembic::Util::shared_ptr< IStreams > IStreamsPtr;
 
+//-*****************************************************************************
+// Called after every IStreams::read with the number of bytes read and the
+// time it took, from the reading thread.  Reads are only timed while an
+// observer is set; by default there is none.
+typedef void ( *ReadObserver )( Alembic::Util::uint64_t iSize,
+                                Alembic::Util::uint64_t iNanoseconds );
+ALEMBIC_EXPORT void SetReadObserver( ReadObserver iObserver );
+
 } // End namespace ALEMBIC_VERSION_NS
 
 using namespace ALEMBIC_VERSION_NS;
@@ -34,6 +34,8 @@
 //-*****************************************************************************
 
 #include <Alembic/Ogawa/IStreams.h>
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <stdexcept>
 
@@ -685,6 +687,8 @@ Alembic::Util::uint16_t IStreams::getVersion()
     return mData->version;
 }
 
+static std::atomic< ReadObserver > g_readObserver(NULL);
+
 void IStreams::read(std::size_t iThreadId, Alembic::Util::uint64_t iPos,
                     Alembic::Util::uint64_t iSize, void * oBuf)
 {
@@ -693,12 +697,33 @@ void IStreams::read(std::size_t iThreadId, Alembic::Util::uint64_t iPos,
         return;
     }
 
+    ReadObserver observer = g_readObserver.load(std::memory_order_relaxed);
+    if (!observer)
+    {
+        if (!mData->reader->read(iThreadId, iPos, iSize, oBuf))
+        {
+            throw std::runtime_error(
+                "Ogawa IStreams::read failed.");
+        }
+        return;
+    }
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
     bool success = mData->reader->read(iThreadId, iPos, iSize, oBuf);
     if (!success)
     {
         throw std::runtime_error(
             "Ogawa IStreams::read failed.");
     }
+    observer(iSize, (Alembic::Util::uint64_t)
+        std::chrono::duration_cast< std::chrono::nanoseconds >(
+            std::chrono::steady_clock::now() - start).count());
+}
+
+void SetReadObserver(ReadObserver iObserver)
+{
+    g_readObserver.store(iObserver);
 }
 
 } // End namespace ALEMBIC_VERSION_NS
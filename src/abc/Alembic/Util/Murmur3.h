@@ -50,6 +50,21 @@ ALEMBIC_EXPORT void
 MurmurHash3_x64_128 ( const void * key, const size_t len,
                       const size_t podSize, void * out );
 
+//-*****************************************************************************
+//! Chunked variant for large buffers. The buffer is split into fixed
+//! kMurmurHash3ChunkSize byte chunks which are hashed on the pool given to
+//! SetParallelFor (numThreads 1 keeps them on the calling thread), and the
+//! chunk digests are hashed again in chunk order together with len.
+//! The digest only depends on the data, never on the thread count.
+//! Buffers up to one chunk get the same digest as MurmurHash3_x64_128,
+//! larger ones get a different one.
+static const size_t kMurmurHash3ChunkSize = 1 << 20;
+
+ALEMBIC_EXPORT void
+MurmurHash3_x64_128_Chunked ( const void * key, const size_t len,
+                              const size_t podSize, void * out,
+                              size_t numThreads = 0 );
+
 } // End namespace ALEMBIC_VERSION_NS
 
 using namespace ALEMBIC_VERSION_NS;
@@ -37,8 +37,12 @@
 // domain. The author hereby disclaims copyright to this source code.
 
 #include <Alembic/Util/Murmur3.h>
+#include <Alembic/Util/ParallelFor.h>
 #include <Alembic/Util/PlainOldDataType.h>
 
+#include <algorithm>
+#include <vector>
+
 #ifdef __APPLE__
 #include <machine/endian.h>
 #elif !defined(_MSC_VER)
@@ -262,6 +266,53 @@ void MurmurHash3_x64_128 ( const void * key, const size_t len,
     ((uint64_t*)out)[1] = h2;
 }
 
+//-*****************************************************************************
+void MurmurHash3_x64_128_Chunked ( const void * key, const size_t len,
+                                   const size_t podSize, void * out,
+                                   size_t numThreads )
+{
+    if ( len <= kMurmurHash3ChunkSize )
+    {
+        MurmurHash3_x64_128( key, len, podSize, out );
+        return;
+    }
+
+    // the chunk size is a multiple of 16, so every chunk but the last one
+    // only goes through the body of the hash and the byte swapping for
+    // big endian stays aligned with the pods
+    const uint8_t * data = (const uint8_t*)key;
+    const size_t numChunks = ( len + kMurmurHash3ChunkSize - 1 ) /
+        kMurmurHash3ChunkSize;
+
+    // chunk digests followed by the total length
+    std::vector< uint64_t > digests( numChunks * 2 + 1 );
+    digests.back() = len;
+
+    auto hashChunk = [&]( size_t i )
+    {
+        size_t beg = i * kMurmurHash3ChunkSize;
+        size_t end = std::min( beg + kMurmurHash3ChunkSize, len );
+        MurmurHash3_x64_128( data + beg, end - beg, podSize,
+                             &digests[i * 2] );
+    };
+
+    if ( numThreads == 1 )
+    {
+        for ( size_t i = 0; i < numChunks; ++i )
+        {
+            hashChunk( i );
+        }
+    }
+    else
+    {
+        RunParallelFor( numChunks, hashChunk );
+    }
+
+    MurmurHash3_x64_128( &digests.front(),
+                         digests.size() * sizeof( uint64_t ),
+                         sizeof( uint64_t ), out );
+}
+
 } // End namespace ALEMBIC_VERSION_NS
 } // End namespace Util
 } // End namespace Alembic
@@ -0,0 +1,74 @@
+//-*****************************************************************************
+//
+// Copyright (c) 2009-2015,
+//  Sony Pictures Imageworks Inc. and
+//  Industrial Light & Magic, a division of Lucasfilm Entertainment Company Ltd.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *       Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *       Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// *       Neither the name of Industrial Light & Magic nor the names of
+// its contributors may be used to endorse or promote products derived
+// from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//-*****************************************************************************
+
+
+#ifndef Alembic_Util_ParallelFor_h
+#define Alembic_Util_ParallelFor_h
+
+#include <Alembic/Util/Export.h>
+#include <Alembic/Util/Foundation.h>
+
+#include <functional>
+
+namespace Alembic {
+namespace Util {
+namespace ALEMBIC_VERSION_NS {
+
+//-*****************************************************************************
+//! Runs iBody( i ) for every i in [0, iCount) and returns when all are done.
+typedef std::function< void ( std::size_t iCount,
+    const std::function< void ( std::size_t ) > & iBody ) > ParallelFor;
+
+//-*****************************************************************************
+//! The task pool of the host, used by the chunked hash and the conversion
+//! kernels. The library never starts threads of its own: while no pool is
+//! set, or after an empty function is set, the bodies run on the calling
+//! thread.
+ALEMBIC_EXPORT void SetParallelFor( const ParallelFor & iParallelFor );
+
+//-*****************************************************************************
+//! Runs iBody on the pool when there is one and iCount > 1, otherwise in
+//! order on the calling thread.
+ALEMBIC_EXPORT void RunParallelFor( std::size_t iCount,
+    const std::function< void ( std::size_t ) > & iBody );
+
+} // End namespace ALEMBIC_VERSION_NS
+
+using namespace ALEMBIC_VERSION_NS;
+
+} // End namespace Util
+} // End namespace Alembic
+
+#endif
@@ -87,6 +87,7 @@
 
 #include "halfExport.h"    // for definition of HALF_EXPORT
 #include <iostream>
+#include <cstddef>
 
 class half
 {
@@ -107,6 +108,23 @@ class half
     operator		float () const;
 
 
+    //---------------------------------------------------------------
+    // Half-to-float conversion of a bit pattern:
+    //
+    //	toFloatBits(h)	branch-free bit manipulation, no table, so
+    //			it does not evict anything from the cache.
+    //			operator float() uses this unless compiled
+    //			with HALF_USE_TOFLOAT_LUT defined.
+    //
+    //	toFloatLut(h)	lookup in the 256 KB _toFloat table
+    //
+    // Both return the same bits for every half, including NANs.
+    //---------------------------------------------------------------
+
+    static float	toFloatBits (unsigned short h);
+    static float	toFloatLut (unsigned short h);
+
+
     //------------
     // Unary minus
     //------------
@@ -230,6 +248,29 @@ HALF_EXPORT std::ostream &      operator << (std::ostream &os, half  h);
 HALF_EXPORT std::istream &      operator >> (std::istream &is, half &h);
 
 
+//------------------------------------------------------------------
+// Array conversion
+//
+//	halfToFloat(src, dst, n)	converts n halfs with F16C when
+//					the CPU has it, with vectorized
+//					bit manipulation otherwise
+//
+//	halfToFloatBitwise(src, dst, n)	converts n halfs with vectorized
+//					bit manipulation, never F16C
+//
+//	halfToFloatLut(src, dst, n)	converts n halfs through the
+//					_toFloat table
+//
+// dst may point to the same memory as src; the arrays are converted
+// from back to front.  With F16C, signaling NANs come out quiet.
+//------------------------------------------------------------------
+
+HALF_EXPORT void	halfToFloat (const half *src, float *dst, size_t n);
+HALF_EXPORT void	halfToFloatBitwise (const half *src, float *dst,
+					    size_t n);
+HALF_EXPORT void	halfToFloatLut (const half *src, float *dst, size_t n);
+
+
 //----------
 // Debugging
 //----------
@@ -402,10 +443,11 @@ HALF_EXPORT void        printBits   (char  c[35], float f);
 //	slow, but the most common case is accelerated via table lookups.
 //
 //	Converting back from a half to a float is easier because we don't
-//	have to do any rounding.  In addition, there are only 65536
-//	different half numbers; we can convert each of those numbers once
-//	and store the results in a table.  Later, all conversions can be
-//	done using only simple table lookups.
+//	have to do any rounding.  A few integer operations on the bit
+//	pattern are enough.  There are also only 65536 different half
+//	numbers, so each of them can be converted once and stored in a
+//	table; that table is still available (toFloatLut()), but at
+//	256 KB it competes with the data being converted for the cache.
 //
 //---------------------------------------------------------------------------
 
@@ -485,14 +527,65 @@ half::half (float f)
 }
 
 
+//-------------------------------------------------------------
+// Half-to-float conversion by bit manipulation.
+//
+// The exponent and significand are shifted into place and the
+// exponent bias is corrected.  Infinities and NANs need a second
+// exponent correction, and zeroes and denormalized numbers are
+// renormalized by subtracting 2^-14 from a float whose exponent
+// is -14 and whose significand holds the half's significand.
+// Both special cases are computed unconditionally and selected
+// with masks, so there are no branches.
+//-------------------------------------------------------------
+
+inline float
+half::toFloatBits (unsigned short h)
+{
+    const unsigned int shiftedExp = 0x7c00 << 13;
+
+    uif o;
+    o.i = (h & 0x7fff) << 13;
+    unsigned int e = o.i & shiftedExp;
+    o.i += (127 - 15) << 23;
+
+    unsigned int infNan = 0u - (unsigned int) (e == shiftedExp);
+    o.i += infNan & ((128 - 16) << 23);
+
+    uif magic;
+    magic.i = 113 << 23;
+
+    uif d;
+    d.i = ((h & 0x03ff) << 13) | magic.i;
+    d.f -= magic.f;
+
+    unsigned int denormalized = 0u - (unsigned int) (e == 0);
+    o.i = (o.i & ~denormalized) | (d.i & denormalized);
+
+    o.i |= (unsigned int) (h & 0x8000) << 16;
+    return o.f;
+}
+
+
 //------------------------------------------
 // Half-to-float conversion via table lookup
 //------------------------------------------
 
+inline float
+half::toFloatLut (unsigned short h)
+{
+    return _toFloat[h].f;
+}
+
+
 inline
 half::operator float () const
 {
-    return _toFloat[_h].f;
+#if defined(HALF_USE_TOFLOAT_LUT)
+    return toFloatLut (_h);
+#else
+    return toFloatBits (_h);
+#endif
 }
 
 
@@ -47,6 +47,18 @@
 #include <assert.h>
 #include "half.h"
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || \
+    defined(__i386__)
+    #define HALF_HAVE_SSE2 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+	#include <intrin.h>
+	#define HALF_TARGET_F16C
+    #else
+	#define HALF_TARGET_F16C __attribute__((target("avx,f16c")))
+    #endif
+#endif
+
 using namespace std;
 
 //-------------------------------------------------------------
@@ -239,6 +251,157 @@ operator >> (istream &is, half &h)
 }
 
 
+//--------------------------------------------------------
+// Array conversion.  All variants work from back to front
+// so that dst may overlap src for in-place widening.
+//--------------------------------------------------------
+
+namespace {
+
+void
+halfToFloatScalar (const unsigned short *src, float *dst, size_t n)
+{
+    for (size_t i = n; i > 0; --i)
+	dst[i - 1] = half::toFloatBits (src[i - 1]);
+}
+
+
+#if defined(HALF_HAVE_SSE2)
+
+//
+// Four halfs (zero extended to 32 bits) at a time, same
+// steps as half::toFloatBits().
+//
+
+inline __m128i
+halfToFloatSSE2 (__m128i h)
+{
+    const __m128i shiftedExp = _mm_set1_epi32 (0x7c00 << 13);
+    const __m128i magic = _mm_set1_epi32 (113 << 23);
+
+    __m128i o = _mm_slli_epi32 (_mm_and_si128 (h, _mm_set1_epi32 (0x7fff)),
+				13);
+    __m128i e = _mm_and_si128 (o, shiftedExp);
+    o = _mm_add_epi32 (o, _mm_set1_epi32 ((127 - 15) << 23));
+
+    __m128i infNan = _mm_cmpeq_epi32 (e, shiftedExp);
+    o = _mm_add_epi32 (o, _mm_and_si128 (infNan,
+					  _mm_set1_epi32 ((128 - 16) << 23)));
+
+    __m128i m = _mm_slli_epi32 (_mm_and_si128 (h, _mm_set1_epi32 (0x03ff)),
+				13);
+    __m128 d = _mm_sub_ps (_mm_castsi128_ps (_mm_or_si128 (m, magic)),
+			   _mm_castsi128_ps (magic));
+
+    __m128i denormalized = _mm_cmpeq_epi32 (e, _mm_setzero_si128 ());
+    o = _mm_or_si128 (_mm_andnot_si128 (denormalized, o),
+		      _mm_and_si128 (denormalized, _mm_castps_si128 (d)));
+
+    __m128i s = _mm_slli_epi32 (_mm_and_si128 (h, _mm_set1_epi32 (0x8000)),
+				16);
+    return _mm_or_si128 (o, s);
+}
+
+
+void
+halfToFloatSSE2 (const unsigned short *src, float *dst, size_t n)
+{
+    size_t i = n;
+
+    while (i >= 8)
+    {
+	i -= 8;
+	__m128i h = _mm_loadu_si128 ((const __m128i *) (src + i));
+	__m128i lo = _mm_unpacklo_epi16 (h, _mm_setzero_si128 ());
+	__m128i hi = _mm_unpackhi_epi16 (h, _mm_setzero_si128 ());
+	lo = halfToFloatSSE2 (lo);
+	hi = halfToFloatSSE2 (hi);
+	_mm_storeu_si128 ((__m128i *) (dst + i), lo);
+	_mm_storeu_si128 ((__m128i *) (dst + i + 4), hi);
+    }
+
+    halfToFloatScalar (src, dst, i);
+}
+
+
+HALF_TARGET_F16C void
+halfToFloatF16C (const unsigned short *src, float *dst, size_t n)
+{
+    size_t i = n;
+
+    while (i >= 8)
+    {
+	i -= 8;
+	__m128i h = _mm_loadu_si128 ((const __m128i *) (src + i));
+	_mm256_storeu_ps (dst + i, _mm256_cvtph_ps (h));
+    }
+
+    halfToFloatScalar (src, dst, i);
+}
+
+
+bool
+cpuHasF16C ()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid (info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool f16c = (info[2] & (1 << 29)) != 0;
+    return osxsave && avx && f16c && (_xgetbv (0) & 6) == 6;
+#else
+    __builtin_cpu_init ();
+    return __builtin_cpu_supports ("avx") && __builtin_cpu_supports ("f16c");
+#endif
+}
+
+#endif
+
+} // namespace
+
+
+HALF_EXPORT void
+halfToFloat (const half *src, float *dst, size_t n)
+{
+    const unsigned short *bits = (const unsigned short *) src;
+
+#if defined(HALF_HAVE_SSE2)
+    static const bool f16c = cpuHasF16C ();
+
+    if (f16c)
+	halfToFloatF16C (bits, dst, n);
+    else
+	halfToFloatSSE2 (bits, dst, n);
+#else
+    halfToFloatScalar (bits, dst, n);
+#endif
+}
+
+
+HALF_EXPORT void
+halfToFloatBitwise (const half *src, float *dst, size_t n)
+{
+    const unsigned short *bits = (const unsigned short *) src;
+
+#if defined(HALF_HAVE_SSE2)
+    halfToFloatSSE2 (bits, dst, n);
+#else
+    halfToFloatScalar (bits, dst, n);
+#endif
+}
+
+
+HALF_EXPORT void
+halfToFloatLut (const half *src, float *dst, size_t n)
+{
+    const unsigned short *bits = (const unsigned short *) src;
+
+    for (size_t i = n; i > 0; --i)
+	dst[i - 1] = half::toFloatLut (bits[i - 1]);
+}
+
+
 //---------------------------------------
 // Functions to print the bit-layout of
 // floats and halfs, mostly for debugging
@@ -9,9 +9,12 @@ const ofColor kNormalColor = ofColor(32, 32, 255);
 inline void drawAlembicPolygon(const houdini_alembic::PolygonMeshObject *polygon) {
 	// auto P_Column = polygon->points.column_as_vector3("P");
 
-	bool isTriangleMesh = std::all_of(polygon->faceCounts.begin(), polygon->faceCounts.end(), [](int32_t f) { return f == 3; });
+	// 四角形やn角形も三角形に分けて描く。トポロジーが変わらない間は前のフレームの分割を使う
+	static houdini_alembic::TriangulationCache triangulations;
+	std::string error_message;
+	auto triangulation = triangulations.triangulate(*polygon, error_message);
 
-	if (isTriangleMesh) {
+	if (triangulation) {
 		static ofMesh mesh;
 		static ofMesh normalMesh;
 		mesh.clear();
@@ -24,7 +27,7 @@ inline void drawAlembicPolygon(const houdini_alembic::PolygonMeshObject *polygon
 			mesh.addVertex(glm::vec3(p.x, p.y, p.z));
 		}
 
-		for (auto index : polygon->indices) {
+		for (auto index : triangulation->indices) {
 			mesh.addIndex(index);
 		}
 
@@ -42,13 +45,13 @@ inline void drawAlembicPolygon(const houdini_alembic::PolygonMeshObject *polygon
 		}
 		// Vertices Normal
 		if (auto N = polygon->vertices.column_as_vector3("N")) {
-			for (int i = 0; i < polygon->indices.size(); i += 3) {
+			for (int i = 0; i < triangulation->indices.size(); i += 3) {
 				std::array<glm::vec3, 3> point;
 				std::array<glm::vec3, 3> normal;
 				for (int j = 0; j < 3; ++j) {
-					uint32_t index = polygon->indices[i + j];
+					uint32_t index = triangulation->indices[i + j];
 					point[j] = glm::vec3(polygon->P[index].x, polygon->P[index].y, polygon->P[index].z);
-					N->get(i + j, glm::value_ptr(normal[j]));
+					N->get(triangulation->vertices[i + j], glm::value_ptr(normal[j]));
 				}
 
 				glm::vec3 primitive_center;
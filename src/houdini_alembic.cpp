@@ -3,6 +3,25 @@
 #include <Alembic/Abc/All.h>
 #include <Alembic/AbcCoreOgawa/All.h>
 #include <Alembic/AbcGeom/All.h>
+#include <Alembic/AbcCoreLayer/Read.h>
+
+#include <Alembic/AbcCoreOgawa/ConvertKernels.h>
+
+#include <cfloat>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <list>
+#include <map>
+#include <shared_mutex>
+#include <thread>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define HOUDINI_ALEMBIC_SSE2 1
+#include <emmintrin.h>
+#endif
 
 namespace houdini_alembic {
 	using namespace Alembic::Abc;
@@ -52,162 +71,870 @@ namespace houdini_alembic {
 	typename ITypedProperty::sample_ptr_type get_typed_array_property(ICompoundProperty parent, const std::string &key, ISampleSelector selector) {
 		static_assert(std::is_base_of<IArrayProperty, ITypedProperty>::value, "ITypedProperty is must be derived IArrayProperty");
 
+		TraceSpan span("ReadArraySample", &key);
 		ITypedProperty typed_property(parent, key);
 		typename ITypedProperty::sample_ptr_type value;
 		typed_property.get(value, selector);
 		return value;
 	}
 
+	template <class ITypedProperty>
+	typename ITypedProperty::sample_ptr_type read_array_sample(ITypedProperty property, ISampleSelector selector) {
+		TraceSpan span("ReadArraySample", &property.getName());
+		return property.getValue(selector);
+	}
+	inline ArraySamplePtr read_array_sample(IArrayProperty property, ISampleSelector selector) {
+		TraceSpan span("ReadArraySample", &property.getName());
+		ArraySamplePtr values;
+		property.get(values, selector);
+		return values;
+	}
+
 	inline int getArrayExtent(const MetaData &meta)
 	{
 		std::string extent_s = meta.get("arrayExtent");
 		return (extent_s == "") ? 1 : atoi(extent_s.c_str());
 	}
 
-	class AttributeStraightforwardVector2Column : public AttributeVector2Column {
+	// 前のフレームのオブジェクトを使い回すときに中身を空にする。vectorの容量は残る
+	static void reset_object(SceneObject *object) {
+		object->xforms.clear();
+		object->details.clear();
+	}
+	static void reset_object(PolygonMeshObject *object) {
+		reset_object(static_cast<SceneObject *>(object));
+		object->points.clear();
+		object->vertices.clear();
+		object->primitives.clear();
+	}
+	static void reset_object(PointObject *object) {
+		reset_object(static_cast<SceneObject *>(object));
+		object->points.clear();
+	}
+	static void reset_object(CurveObject *object) {
+		reset_object(static_cast<SceneObject *>(object));
+		object->curvePrimitives.clear();
+		object->points.clear();
+		object->vertices.clear();
+		object->primitives.clear();
+	}
+
+	/*
+	 The spans kept by LoaderTrace, in one buffer per thread so that the threads do not contend.
+	 A buffer outlives its thread until its spans are cleared.
+	*/
+	struct TraceEvent {
+		const char *name = nullptr;
+		std::string label;
+		uint64_t begin = 0; // nanoseconds since the recorder was created
+		uint64_t duration = 0;
+		uint64_t bytes = 0; // of stream reads and conversions
+		uint32_t thread = 0;
+	};
+	struct TraceBuffer {
+		std::mutex mutex;
+		std::deque<TraceEvent> events;
+		uint32_t thread = 0;
+	};
+	class TraceRecorder {
 	public:
-		enum {
-			DIMENSIONS = 2
-		};
-		void get(uint32_t index, float *xs) const override {
-			const float *p = _floats->get();
-			uint32_t src_index = index * DIMENSIONS;
-			for (int i = 0; i < DIMENSIONS; ++i) {
-				xs[i] = p[src_index + i];
+		static TraceRecorder &instance() {
+			static TraceRecorder recorder;
+			return recorder;
+		}
+
+		uint64_t now() const {
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _epoch).count();
+		}
+
+		void add(const char *name, const std::string *label, uint64_t begin, uint64_t end, uint64_t bytes) {
+			TraceBuffer &buffer = thread_buffer();
+			std::lock_guard<std::mutex> lock(buffer.mutex);
+
+			// リングバッファなら、窓から外れた古いものを捨てる
+			uint64_t ring = ringNanoseconds;
+			while (ring && !buffer.events.empty() && buffer.events.front().begin + buffer.events.front().duration + ring < end) {
+				buffer.events.pop_front();
+			}
+
+			TraceEvent event;
+			event.name = name;
+			if (label) {
+				event.label = *label;
 			}
+			event.begin = begin;
+			event.duration = end - begin;
+			event.bytes = bytes;
+			event.thread = buffer.thread;
+			buffer.events.push_back(std::move(event));
 		}
-		virtual void get(uint32_t index, double *xs) const override {
-			const float *p = _floats->get();
-			uint32_t src_index = index * DIMENSIONS;
-			for (int i = 0; i < DIMENSIONS; ++i) {
-				xs[i] = (double)p[src_index + i];
+
+		// the spans within the window of the ring buffer, in the order they began
+		std::vector<TraceEvent> collect() {
+			uint64_t ring = ringNanoseconds;
+			uint64_t oldest = ring && ring < now() ? now() - ring : 0;
+
+			std::vector<TraceEvent> events;
+			std::lock_guard<std::mutex> lock(_buffersMutex);
+			for (auto &buffer : _buffers) {
+				std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+				for (const TraceEvent &event : buffer->events) {
+					if (oldest <= event.begin + event.duration) {
+						events.push_back(event);
+					}
+				}
 			}
+			std::sort(events.begin(), events.end(), [](const TraceEvent &a, const TraceEvent &b) {
+				return a.begin < b.begin;
+			});
+			return events;
 		}
-		uint32_t rowCount() const override {
-			return _size;
+
+		void clear() {
+			std::lock_guard<std::mutex> lock(_buffersMutex);
+			for (auto &buffer : _buffers) {
+				std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+				buffer->events.clear();
+			}
+			// 終わったスレッドのバッファはここで手放す
+			_buffers.erase(std::remove_if(_buffers.begin(), _buffers.end(), [](const std::shared_ptr<TraceBuffer> &buffer) {
+				return buffer.use_count() == 1;
+			}), _buffers.end());
 		}
-		int snprint(uint32_t index, char *buffer, uint32_t buffersize) const override {
-			float xs[DIMENSIONS];
-			get(index, xs);
-			return snprintf(buffer, buffersize, "(%f, %f)", xs[0], xs[1]);
+
+		/*
+		 Queues a dump of the kept spans for the writer thread, which collects them when it gets to it.
+		 A dump that has not started yet covers the frames after it as well, so at most one waits.
+		*/
+		void request_dump() {
+			std::lock_guard<std::mutex> lock(slowFrameMutex);
+			if (_dumpPending) {
+				return;
+			}
+			_dumpPending = true;
+			_dumpPath = slowFramePathPrefix + std::to_string(slowFrameDumpCount++) + ".json";
+			_dumpCallback = slowFrameCallback;
+			if (!_dumpThread.joinable()) {
+				_dumpThread = std::thread([this]() { write_dumps(); });
+			}
+			_dumpWake.notify_all();
+		}
+		void flush_dumps() {
+			std::unique_lock<std::mutex> lock(slowFrameMutex);
+			_dumpDone.wait(lock, [this]() { return !_dumpPending && !_dumpWriting; });
+		}
+
+		std::atomic<bool> recording{ false };
+		std::atomic<uint64_t> ringNanoseconds{ 0 };
+		std::atomic<uint64_t> slowFrameNanoseconds{ 0 };
+		std::atomic<uint32_t> slowFrameDumpCount{ 0 };
+		std::mutex slowFrameMutex;
+		std::string slowFramePathPrefix;
+		LoaderTrace::SlowFrameDumpCallback slowFrameCallback;
+	private:
+		~TraceRecorder() {
+			{
+				std::lock_guard<std::mutex> lock(slowFrameMutex);
+				_dumpQuit = true;
+			}
+			_dumpWake.notify_all();
+			if (_dumpThread.joinable()) {
+				_dumpThread.join();
+			}
+		}
+
+		// 読み込みのスレッドの外で書き出す。終了時は残りを書いてから止まる
+		void write_dumps() {
+			std::unique_lock<std::mutex> lock(slowFrameMutex);
+			for (;;) {
+				_dumpWake.wait(lock, [this]() { return _dumpQuit || _dumpPending; });
+				if (!_dumpPending) {
+					return;
+				}
+				std::string path = _dumpPath;
+				LoaderTrace::SlowFrameDumpCallback callback = _dumpCallback;
+				_dumpPending = false;
+				_dumpWriting = true;
+				lock.unlock();
+
+				std::string error_message;
+				LoaderTrace::write(path, error_message);
+				if (callback) {
+					callback(path, error_message);
+				}
+
+				lock.lock();
+				_dumpWriting = false;
+				_dumpDone.notify_all();
+			}
+		}
+
+		TraceBuffer &thread_buffer() {
+			static thread_local std::shared_ptr<TraceBuffer> t_buffer;
+			if (!t_buffer) {
+				t_buffer = std::make_shared<TraceBuffer>();
+				std::lock_guard<std::mutex> lock(_buffersMutex);
+				t_buffer->thread = _threadCount++;
+				_buffers.push_back(t_buffer);
+			}
+			return *t_buffer;
 		}
-		uint32_t _size = 0;
-		FloatArraySamplePtr _floats;
+
+		std::chrono::steady_clock::time_point _epoch = std::chrono::steady_clock::now();
+		std::mutex _buffersMutex;
+		std::vector<std::shared_ptr<TraceBuffer>> _buffers;
+		uint32_t _threadCount = 1;
+
+		// guarded by slowFrameMutex
+		std::thread _dumpThread;
+		std::condition_variable _dumpWake;
+		std::condition_variable _dumpDone;
+		bool _dumpPending = false;
+		bool _dumpWriting = false;
+		bool _dumpQuit = false;
+		std::string _dumpPath;
+		LoaderTrace::SlowFrameDumpCallback _dumpCallback;
 	};
-	class AttributeStraightforwardVector3Column : public AttributeVector3Column {
+
+	inline bool trace_recording() {
+		return TraceRecorder::instance().recording.load(std::memory_order_relaxed);
+	}
+
+	// Alembic のストリーム読み込みと変換は、統計を取るストレージか記録中のトレースがある間だけ知らされる
+	static void observe_read(uint64_t size, uint64_t nanoseconds);
+	static void observe_convert(std::size_t size, uint64_t nanoseconds);
+	static std::mutex &observersMutex() {
+		static std::mutex mutex;
+		return mutex;
+	}
+	static uint32_t &observerUsers() {
+		static uint32_t count = 0;
+		return count;
+	}
+	static void retain_observers() {
+		std::lock_guard<std::mutex> lock(observersMutex());
+		if (observerUsers()++ == 0) {
+			Alembic::Ogawa::SetReadObserver(observe_read);
+			Alembic::AbcCoreOgawa::SetConvertObserver(observe_convert);
+		}
+	}
+	static void release_observers() {
+		std::lock_guard<std::mutex> lock(observersMutex());
+		if (--observerUsers() == 0) {
+			Alembic::Ogawa::SetReadObserver(nullptr);
+			Alembic::AbcCoreOgawa::SetConvertObserver(nullptr);
+		}
+	}
+
+	/*
+	 The counters behind AlembicStorage::stats(). Totals are atomics, the bytes by name take a lock.
+	*/
+	class ReadStatsSink {
 	public:
-		enum {
-			DIMENSIONS = 3
-		};
-		void get(uint32_t index, float *xs) const override {
-			const float *p = _floats->get();
-			uint32_t src_index = index * DIMENSIONS;
-			for (int i = 0; i < DIMENSIONS; ++i) {
-				xs[i] = p[src_index + i];
+		ReadStatsSink() {
+			reset();
+			retain_observers();
+		}
+		ReadStatsSink(const ReadStatsSink &) = delete;
+		void operator=(const ReadStatsSink &) = delete;
+		~ReadStatsSink() {
+			release_observers();
+		}
+
+		void add_read(const std::string *object, const std::string *attribute, uint64_t size, uint64_t nanoseconds) {
+			bytesRead += size;
+			readCalls++;
+			ioNanoseconds += nanoseconds;
+			uint32_t bucket = 0;
+			while (bucket + 1 < ReadStats::kReadSizeBuckets && ReadStats::readSizeLimit(bucket) <= size) {
+				bucket++;
+			}
+			readSizeHistogram[bucket]++;
+
+			if (object) {
+				std::lock_guard<std::mutex> lock(_mutex);
+				_objectBytes[*object] += size;
+				if (attribute) {
+					_attributeBytes[*object + "/" + *attribute] += size;
+				}
 			}
 		}
-		virtual void get(uint32_t index, double *xs) const override {
-			const float *p = _floats->get();
-			uint32_t src_index = index * DIMENSIONS;
-			for (int i = 0; i < DIMENSIONS; ++i) {
-				xs[i] = (double)p[src_index + i];
+
+		ReadStats snapshot() const {
+			ReadStats stats;
+			stats.frames = frames;
+			stats.bytesRead = bytesRead;
+			stats.readCalls = readCalls;
+			for (uint32_t i = 0; i < ReadStats::kReadSizeBuckets; ++i) {
+				stats.readSizeHistogram[i] = readSizeHistogram[i];
 			}
+			stats.ioNanoseconds = ioNanoseconds;
+			stats.bytesConverted = bytesConverted;
+			stats.convertNanoseconds = convertNanoseconds;
+			stats.parseAttributesNanoseconds = parseAttributesNanoseconds;
+			stats.extractPNanoseconds = extractPNanoseconds;
+			stats.recycledObjects = recycledObjects;
+			stats.allocatedObjects = allocatedObjects;
+			stats.sharedColumns = sharedColumns;
+			stats.parsedColumns = parsedColumns;
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			stats.objectBytes = _objectBytes;
+			stats.attributeBytes = _attributeBytes;
+			return stats;
 		}
-		uint32_t rowCount() const override {
-			return _size;
+		void reset() {
+			frames = 0;
+			bytesRead = 0;
+			readCalls = 0;
+			for (auto &count : readSizeHistogram) {
+				count = 0;
+			}
+			ioNanoseconds = 0;
+			bytesConverted = 0;
+			convertNanoseconds = 0;
+			parseAttributesNanoseconds = 0;
+			extractPNanoseconds = 0;
+			recycledObjects = 0;
+			allocatedObjects = 0;
+			sharedColumns = 0;
+			parsedColumns = 0;
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			_objectBytes.clear();
+			_attributeBytes.clear();
 		}
-		int snprint(uint32_t index, char *buffer, uint32_t buffersize) const override {
-			float xs[DIMENSIONS];
-			get(index, xs);
-			return snprintf(buffer, buffersize, "(%f, %f, %f)", xs[0], xs[1], xs[2]);
+
+		std::atomic<uint64_t> frames;
+		std::atomic<uint64_t> bytesRead;
+		std::atomic<uint64_t> readCalls;
+		std::array<std::atomic<uint64_t>, ReadStats::kReadSizeBuckets> readSizeHistogram;
+		std::atomic<uint64_t> ioNanoseconds;
+		std::atomic<uint64_t> bytesConverted;
+		std::atomic<uint64_t> convertNanoseconds;
+		std::atomic<uint64_t> parseAttributesNanoseconds;
+		std::atomic<uint64_t> extractPNanoseconds;
+		std::atomic<uint64_t> recycledObjects;
+		std::atomic<uint64_t> allocatedObjects;
+		std::atomic<uint64_t> sharedColumns;
+		std::atomic<uint64_t> parsedColumns;
+	private:
+		mutable std::mutex _mutex;
+		std::map<std::string, uint64_t> _objectBytes;
+		std::map<std::string, uint64_t> _attributeBytes;
+	};
+
+	// 統計を取っている読み込みで、このスレッドが今どのオブジェクトのどの属性を読んでいるか
+	struct StatsContext {
+		ReadStatsSink *sink = nullptr;
+		const std::string *object = nullptr;
+		const std::string *attribute = nullptr;
+	};
+	static thread_local StatsContext t_statsContext;
+
+	static void observe_read(uint64_t size, uint64_t nanoseconds) {
+		const StatsContext &context = t_statsContext;
+		if (context.sink) {
+			context.sink->add_read(context.object, context.attribute, size, nanoseconds);
+		}
+		if (trace_recording()) {
+			TraceRecorder &recorder = TraceRecorder::instance();
+			uint64_t end = recorder.now();
+			recorder.add("IStreams::read", nullptr, end - std::min(end, nanoseconds), end, size);
+		}
+	}
+	static void observe_convert(std::size_t size, uint64_t nanoseconds) {
+		if (ReadStatsSink *sink = t_statsContext.sink) {
+			sink->bytesConverted += size;
+			sink->convertNanoseconds += nanoseconds;
+		}
+		if (trace_recording()) {
+			TraceRecorder &recorder = TraceRecorder::instance();
+			uint64_t end = recorder.now();
+			recorder.add("ConvertData", nullptr, end - std::min(end, nanoseconds), end, size);
+		}
+	}
+
+	TraceSpan::TraceSpan(const char *name, const std::string *label) : _name(name) {
+		if (trace_recording()) {
+			_active = true;
+			if (label) {
+				_label = *label;
+			}
+			_begin = TraceRecorder::instance().now();
+		}
+	}
+	TraceSpan::~TraceSpan() {
+		if (_active) {
+			TraceRecorder &recorder = TraceRecorder::instance();
+			recorder.add(_name, &_label, _begin, recorder.now(), 0);
+		}
+	}
+	uint64_t TraceSpan::elapsedNanoseconds() const {
+		return _active ? TraceRecorder::instance().now() - _begin : 0;
+	}
+
+	inline void write_json_string(std::ostream &stream, const std::string &value) {
+		stream << '"';
+		for (char c : value) {
+			switch (c) {
+			case '"': stream << "\\\""; break;
+			case '\\': stream << "\\\\"; break;
+			case '\n': stream << "\\n"; break;
+			case '\t': stream << "\\t"; break;
+			default:
+				if ((unsigned char)c < 0x20) {
+					char buffer[8];
+					snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned)c);
+					stream << buffer;
+				}
+				else {
+					stream << c;
+				}
+				break;
+			}
+		}
+		stream << '"';
+	}
+
+	void LoaderTrace::start(double ringSeconds) {
+		TraceRecorder &recorder = TraceRecorder::instance();
+		recorder.ringNanoseconds = (uint64_t)(std::max(ringSeconds, 0.0) * 1.0e9);
+		if (!recorder.recording.exchange(true)) {
+			retain_observers();
+		}
+	}
+	void LoaderTrace::stop() {
+		if (TraceRecorder::instance().recording.exchange(false)) {
+			release_observers();
+		}
+	}
+	bool LoaderTrace::isRecording() {
+		return trace_recording();
+	}
+	void LoaderTrace::clear() {
+		TraceRecorder::instance().clear();
+	}
+	bool LoaderTrace::write(const std::string &filePath, std::string &error_message) {
+		std::vector<TraceEvent> events = TraceRecorder::instance().collect();
+
+		std::ofstream stream(filePath, std::ios::binary | std::ios::trunc);
+		if (!stream) {
+			error_message = "can't open " + filePath;
+			return false;
+		}
+
+		// Chrome trace event format. ts と dur はマイクロ秒
+		char buffer[128];
+		stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		for (std::size_t i = 0; i < events.size(); ++i) {
+			const TraceEvent &event = events[i];
+			stream << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+			write_json_string(stream, event.name);
+			snprintf(buffer, sizeof(buffer), ",\"cat\":\"houdini_alembic\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+				event.thread, event.begin * 1.0e-3, event.duration * 1.0e-3);
+			stream << buffer;
+			if (!event.label.empty() || event.bytes) {
+				stream << ",\"args\":{";
+				if (!event.label.empty()) {
+					stream << "\"label\":";
+					write_json_string(stream, event.label);
+				}
+				if (event.bytes) {
+					stream << (event.label.empty() ? "" : ",") << "\"bytes\":" << event.bytes;
+				}
+				stream << "}";
+			}
+			stream << "}";
+		}
+		stream << "\n]}\n";
+		if (!stream) {
+			error_message = "failed to write " + filePath;
+			return false;
+		}
+		return true;
+	}
+	void LoaderTrace::setSlowFrameDump(double thresholdSeconds, const std::string &pathPrefix, SlowFrameDumpCallback callback) {
+		TraceRecorder &recorder = TraceRecorder::instance();
+		std::lock_guard<std::mutex> lock(recorder.slowFrameMutex);
+		recorder.slowFramePathPrefix = pathPrefix;
+		recorder.slowFrameCallback = std::move(callback);
+		recorder.slowFrameNanoseconds = (uint64_t)(std::max(thresholdSeconds, 0.0) * 1.0e9);
+	}
+	uint32_t LoaderTrace::slowFrameDumpCount() {
+		return TraceRecorder::instance().slowFrameDumpCount;
+	}
+	void LoaderTrace::flushSlowFrameDumps() {
+		TraceRecorder::instance().flush_dumps();
+	}
+
+	/*
+	 The span of reading one or more frames. When it took longer than LoaderTrace::setSlowFrameDump() allows,
+	 it asks the writer thread of the recorder to write out the spans kept so far, and does not wait for it.
+	*/
+	class FrameTraceSpan {
+	public:
+		FrameTraceSpan(const char *name, uint32_t index) {
+			if (trace_recording()) {
+				_label = "frame " + std::to_string(index);
+				_span.reset(new TraceSpan(name, &_label));
+			}
+		}
+		FrameTraceSpan(const FrameTraceSpan &) = delete;
+		void operator=(const FrameTraceSpan &) = delete;
+		~FrameTraceSpan() {
+			if (!_span) {
+				return;
+			}
+			uint64_t elapsed = _span->elapsedNanoseconds();
+			_span.reset();
+
+			TraceRecorder &recorder = TraceRecorder::instance();
+			uint64_t threshold = recorder.slowFrameNanoseconds;
+			if (threshold == 0 || elapsed <= threshold) {
+				return;
+			}
+			recorder.request_dump();
 		}
-		uint32_t _size = 0;
-		FloatArraySamplePtr _floats;
+	private:
+		std::string _label;
+		std::unique_ptr<TraceSpan> _span;
 	};
-	class AttributeStraightforwardVector4Column : public AttributeVector4Column {
+
+	// sink が null なら何もしない
+	class StatsScope {
 	public:
-		enum {
-			DIMENSIONS = 4
-		};
-		void get(uint32_t index, float *xs) const override {
-			const float *p = _floats->get();
-			uint32_t src_index = index * DIMENSIONS;
-			for (int i = 0; i < DIMENSIONS; ++i) {
-				xs[i] = p[src_index + i];
+		StatsScope(const StatsContext &context) : _active(context.sink != nullptr) {
+			if (_active) {
+				_saved = t_statsContext;
+				t_statsContext = context;
 			}
 		}
-		virtual void get(uint32_t index, double *xs) const override {
-			const float *p = _floats->get();
-			uint32_t src_index = index * DIMENSIONS;
-			for (int i = 0; i < DIMENSIONS; ++i) {
-				xs[i] = (double)p[src_index + i];
+		// object が null なら今のオブジェクトのまま
+		StatsScope(ReadStatsSink *sink, const std::string *object, const std::string *attribute) : _active(sink != nullptr) {
+			if (_active) {
+				_saved = t_statsContext;
+				t_statsContext.sink = sink;
+				if (object) {
+					t_statsContext.object = object;
+				}
+				t_statsContext.attribute = attribute;
 			}
 		}
-		uint32_t rowCount() const override {
-			return _size;
+		StatsScope(const StatsScope &) = delete;
+		void operator=(const StatsScope &) = delete;
+		~StatsScope() {
+			if (_active) {
+				t_statsContext = _saved;
+			}
 		}
-		int snprint(uint32_t index, char *buffer, uint32_t buffersize) const override {
-			float xs[DIMENSIONS];
-			get(index, xs);
-			return snprintf(buffer, buffersize, "(%f, %f, %f, %f)", xs[0], xs[1], xs[2], xs[3]);
+	private:
+		bool _active;
+		StatsContext _saved;
+	};
+
+	// sink が null なら時計も読まない
+	class StatsTimer {
+	public:
+		StatsTimer(ReadStatsSink *sink, std::atomic<uint64_t> ReadStatsSink::*counter) : _sink(sink), _counter(counter) {
+			if (_sink) {
+				_start = std::chrono::steady_clock::now();
+			}
+		}
+		StatsTimer(const StatsTimer &) = delete;
+		void operator=(const StatsTimer &) = delete;
+		~StatsTimer() {
+			if (_sink) {
+				(_sink->*_counter) += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+			}
 		}
-		uint32_t _size = 0;
-		FloatArraySamplePtr _floats;
+	private:
+		ReadStatsSink *_sink;
+		std::atomic<uint64_t> ReadStatsSink::*_counter;
+		std::chrono::steady_clock::time_point _start;
 	};
 
-	class AttributeIndexedVector2Column : public AttributeVector2Column {
+	/*
+	 Where the objects and columns of a frame come from.
+	 An object of the recycled scene at the same position and of the same type is reset and reused, otherwise a new one is allocated from the arena.
+	 Objects at different positions may be requested from different tasks at once.
+	*/
+	class SceneBuilder {
 	public:
-		void get(uint32_t index, float *xs) const override {
-			const V2f *vector2 = _indexed_vector2->get();
-			const uint32_t *indices = _indices->get();
-			const V2f &value = vector2[indices[index]];
-			xs[0] = value.x;
-			xs[1] = value.y;
+		template <class T>
+		std::shared_ptr<T> object(std::size_t index) {
+			if (index < recycled.size()) {
+				if (auto object = std::dynamic_pointer_cast<T>(recycled[index])) {
+					recycled[index].reset();
+					reset_object(object.get());
+					if (stats) {
+						stats->recycledObjects++;
+					}
+					return object;
+				}
+			}
+			if (stats) {
+				stats->allocatedObjects++;
+			}
+			return allocate_scene_object<T>(arena);
 		}
-		virtual void get(uint32_t index, double *xs) const override {
-			const V2f *vector2 = _indexed_vector2->get();
-			const uint32_t *indices = _indices->get();
-			const V2f &value = vector2[indices[index]];
-			xs[0] = value.x;
-			xs[1] = value.y;
+
+		template <class T>
+		std::shared_ptr<T> column() const {
+			return allocate_scene_object<T>(arena);
+		}
+
+		// runs inline without an executor
+		void parallelFor(uint32_t count, const std::function<void(uint32_t)> &body) const {
+			if (executor && 1 < count) {
+				if (stats) {
+					// タスクを実行するスレッドにも、何を読んでいるかを引き継ぐ
+					StatsContext context = t_statsContext;
+					executor->parallelFor(count, [&](uint32_t i) {
+						StatsScope scope(context);
+						body(i);
+					});
+					return;
+				}
+				executor->parallelFor(count, body);
+				return;
+			}
+			for (uint32_t i = 0; i < count; ++i) {
+				body(i);
+			}
+		}
+
+		std::shared_ptr<SceneArena> arena;
+		std::shared_ptr<StringTable> strings;
+		float pointQuantization = 0.0f;
+		TaskExecutor *executor = nullptr;
+		const ReadCancellation *cancellation = nullptr;
+		ReadStatsSink *stats = nullptr;
+
+		bool cancelled() const {
+			return cancellation && cancellation->isCancelled();
+		}
+
+		// read_range: the same object in the frame before. What did not change since then is taken from it
+		const SceneObject *previous = nullptr;
+		ISampleSelector previousSelector;
+
+		// null where the object is still referred to from outside
+		std::vector<std::shared_ptr<SceneObject>> recycled;
+	};
+
+	// サンプルは読み直しやread_rangeで別の列からも参照されうるので、参照数ごと数える
+	inline void count_array_sample(MemoryCounter &counter, const ArraySamplePtr &sample) {
+		if (sample && sample->getData()) {
+			counter.add(sample->getData(), sample->size() * sample->getDataType().getNumBytes(), sample.use_count());
+		}
+	}
+	template <class T>
+	void count_array_sample(MemoryCounter &counter, const std::shared_ptr<Alembic::Abc::TypedArraySample<T>> &sample) {
+		if (sample && sample->getData()) {
+			counter.add(sample->getData(), sample->size() * sample->getDataType().getNumBytes(), sample.use_count());
+		}
+	}
+	inline void count_array_sample(MemoryCounter &counter, const StringArraySamplePtr &sample) {
+		if (sample && sample->getData()) {
+			uint64_t bytes = sample->size() * sizeof(std::string);
+			for (std::size_t i = 0; i < sample->size(); ++i) {
+				bytes += MemoryCounter::heapBytes(sample->get()[i]);
+			}
+			counter.add(sample->getData(), bytes, sample.use_count());
+		}
+	}
+
+	/*
+	 Columns that keep the sample in the type it is stored with.
+	 With _indices the rows are looked up through them (indexed GeomParam), otherwise the sample is read row by row.
+	 A column whose rows are all the same keeps one row and broadcasts it.
+	*/
+	static_assert((int)AttributeStorageType_Float16 == (int)Alembic::Util::kFloat16POD, "AttributeStorageType must follow PlainOldDataType");
+	static_assert((int)AttributeStorageType_String == (int)Alembic::Util::kStringPOD, "AttributeStorageType must follow PlainOldDataType");
+
+	template <class Base, Alembic::Util::PlainOldDataType POD>
+	class AttributeNativeColumn : public Base {
+	public:
+		typedef typename Alembic::Util::PODTraitsFromEnum<POD>::value_type value_type;
+
+		AttributeStorageType storageType() const override {
+			return (AttributeStorageType)POD;
+		}
+		uint32_t componentCount() const override {
+			return _componentCount;
 		}
 		uint32_t rowCount() const override {
-			return (uint32_t)_indices->size();
+			return _rowCount;
 		}
-		int snprint(uint32_t index, char *buffer, uint32_t buffersize) const override {
-			float xs[2];
-			get(index, xs);
-			return snprintf(buffer, buffersize, "(%f, %f)", xs[0], xs[1]);
+		const void *storage() const override {
+			return _indices || _broadcast ? nullptr : _values->getData();
+		}
+		bool isBroadcast() const override {
+			return _broadcast;
+		}
+
+		const value_type *row(uint32_t index) const {
+			if (_broadcast) {
+				return _broadcastValue;
+			}
+			uint32_t i = _indices ? _indices->get()[index] : index;
+			return static_cast<const value_type *>(_values->getData()) + (std::size_t)i * _componentCount;
 		}
+
+		// 全行が同じ値 (Houdiniが定数を昇格したものなど) なら1行だけ残してサンプルを手放す
+		void broadcast_if_constant() {
+			if (_rowCount < 2) {
+				return;
+			}
+			const value_type *first = row(0);
+			std::size_t rowBytes = sizeof(value_type) * _componentCount;
+			for (uint32_t i = 1; i < _rowCount; ++i) {
+				if (memcmp(first, row(i), rowBytes) != 0) {
+					return;
+				}
+			}
+			std::copy(first, first + _componentCount, _broadcastValue);
+			_broadcast = true;
+			_values.reset();
+			_indices.reset();
+		}
+		template <class T>
+		void get_as(uint32_t index, T *xs) const {
+			const value_type *p = row(index);
+			for (uint32_t i = 0; i < _componentCount; ++i) {
+				xs[i] = static_cast<T>(p[i]);
+			}
+		}
+
+		void countMemory(MemoryCounter &counter, long useCount) const override {
+			MemoryCounter::Scope scope(counter, this, sizeof(*this), useCount);
+			if (scope.first()) {
+				count_array_sample(counter, _values);
+				count_array_sample(counter, _indices);
+			}
+		}
+
+		ArraySamplePtr _values;
 		UInt32ArraySamplePtr _indices;
-		V2fArraySamplePtr _indexed_vector2;
+		uint32_t _rowCount = 0;
+		uint32_t _componentCount = 0;
+
+		bool _broadcast = false;
+		value_type _broadcastValue[4];
 	};
-	class AttributeStraightforwardFloatColumn : public AttributeFloatColumn {
+
+	template <Alembic::Util::PlainOldDataType POD>
+	class AttributeNativeFloatColumn : public AttributeNativeColumn<AttributeFloatColumn, POD> {
 	public:
 		float get(uint32_t index) const override {
-			return _floats->get()[index];
+			return static_cast<float>(this->row(index)[0]);
 		}
-		uint32_t rowCount() const override {
-			return (uint32_t)_floats->size();
+		void get(uint32_t index, double *x) const override {
+			this->get_as(index, x);
 		}
 		int snprint(uint32_t index, char *buffer, uint32_t buffersize) const override {
 			return snprintf(buffer, buffersize, "%f", get(index));
 		}
-		FloatArraySamplePtr _floats;
 	};
-	class AttributeStraightforwardIntColumn : public AttributeIntColumn {
+	template <Alembic::Util::PlainOldDataType POD>
+	class AttributeNativeIntColumn : public AttributeNativeColumn<AttributeIntColumn, POD> {
 	public:
 		int32_t get(uint32_t index) const override {
-			return _ints->get()[index];
+			return static_cast<int32_t>(this->row(index)[0]);
 		}
-		uint32_t rowCount() const override {
-			return (uint32_t)_ints->size();
+		void get(uint32_t index, int64_t *x) const override {
+			this->get_as(index, x);
+		}
+		int snprint(uint32_t index, char *buffer, uint32_t buffersize) const override {
+			int64_t x;
+			get(index, &x);
+			return snprintf(buffer, buffersize, "%lld", (long long)x);
+		}
+	};
+	template <class Base, Alembic::Util::PlainOldDataType POD>
+	class AttributeNativeVectorColumn : public AttributeNativeColumn<Base, POD> {
+	public:
+		void get(uint32_t index, float *xs) const override {
+			this->get_as(index, xs);
+		}
+		void get(uint32_t index, double *xs) const override {
+			this->get_as(index, xs);
 		}
 		int snprint(uint32_t index, char *buffer, uint32_t buffersize) const override {
-			return snprintf(buffer, buffersize, "%d", get(index));
+			float xs[4];
+			get(index, xs);
+			switch (this->_componentCount) {
+			case 2: return snprintf(buffer, buffersize, "(%f, %f)", xs[0], xs[1]);
+			case 3: return snprintf(buffer, buffersize, "(%f, %f, %f)", xs[0], xs[1], xs[2]);
+			default: return snprintf(buffer, buffersize, "(%f, %f, %f, %f)", xs[0], xs[1], xs[2], xs[3]);
+			}
 		}
-		Int32ArraySamplePtr _ints;
 	};
+
+	template <Alembic::Util::PlainOldDataType POD>
+	class AttributeNativeVector3Column : public AttributeNativeVectorColumn<AttributeVector3Column, POD> {
+	public:
+		void getRows(uint32_t begin, uint32_t count, float *xyz) const override {
+			if (POD == Alembic::Util::kFloat32POD && this->storage()) {
+				memcpy(xyz, static_cast<const float *>(this->storage()) + (std::size_t)begin * 3, (std::size_t)count * 3 * sizeof(float));
+				return;
+			}
+			AttributeNativeVectorColumn<AttributeVector3Column, POD>::getRows(begin, count, xyz);
+		}
+	};
+
+	template <class Column>
+	std::shared_ptr<AttributeColumn> native_column(const SceneBuilder &builder, ArraySamplePtr values, UInt32ArraySamplePtr indices, uint32_t rowCount, uint32_t componentCount) {
+		auto column = builder.column<Column>();
+		column->_values = values;
+		column->_indices = indices;
+		column->_rowCount = rowCount;
+		column->_componentCount = componentCount;
+		column->broadcast_if_constant();
+		return column;
+	}
+
+	// 1成分なら整数はInt、浮動小数点はFloat、2〜4成分はVectorの列にする
+	template <Alembic::Util::PlainOldDataType POD>
+	std::shared_ptr<AttributeColumn> native_column(const SceneBuilder &builder, ArraySamplePtr values, UInt32ArraySamplePtr indices, uint32_t rowCount, uint32_t componentCount) {
+		const bool integer = POD < Alembic::Util::kFloat16POD;
+		switch (componentCount) {
+		case 1:
+			if (integer) {
+				return native_column<AttributeNativeIntColumn<POD>>(builder, values, indices, rowCount, componentCount);
+			}
+			return native_column<AttributeNativeFloatColumn<POD>>(builder, values, indices, rowCount, componentCount);
+		case 2:
+			return native_column<AttributeNativeVectorColumn<AttributeVector2Column, POD>>(builder, values, indices, rowCount, componentCount);
+		case 3:
+			return native_column<AttributeNativeVector3Column<POD>>(builder, values, indices, rowCount, componentCount);
+		case 4:
+			return native_column<AttributeNativeVectorColumn<AttributeVector4Column, POD>>(builder, values, indices, rowCount, componentCount);
+		default:
+			return std::shared_ptr<AttributeColumn>();
+		}
+	}
+	inline std::shared_ptr<AttributeColumn> native_column(const SceneBuilder &builder, Alembic::Util::PlainOldDataType pod, ArraySamplePtr values, UInt32ArraySamplePtr indices, uint32_t rowCount, uint32_t componentCount) {
+		using namespace Alembic::Util;
+		switch (pod) {
+		case kBooleanPOD: return native_column<kBooleanPOD>(builder, values, indices, rowCount, componentCount);
+		case kUint8POD:   return native_column<kUint8POD>(builder, values, indices, rowCount, componentCount);
+		case kInt8POD:    return native_column<kInt8POD>(builder, values, indices, rowCount, componentCount);
+		case kUint16POD:  return native_column<kUint16POD>(builder, values, indices, rowCount, componentCount);
+		case kInt16POD:   return native_column<kInt16POD>(builder, values, indices, rowCount, componentCount);
+		case kUint32POD:  return native_column<kUint32POD>(builder, values, indices, rowCount, componentCount);
+		case kInt32POD:   return native_column<kInt32POD>(builder, values, indices, rowCount, componentCount);
+		case kUint64POD:  return native_column<kUint64POD>(builder, values, indices, rowCount, componentCount);
+		case kInt64POD:   return native_column<kInt64POD>(builder, values, indices, rowCount, componentCount);
+		case kFloat16POD: return native_column<kFloat16POD>(builder, values, indices, rowCount, componentCount);
+		case kFloat32POD: return native_column<kFloat32POD>(builder, values, indices, rowCount, componentCount);
+		case kFloat64POD: return native_column<kFloat64POD>(builder, values, indices, rowCount, componentCount);
+		default:
+			return std::shared_ptr<AttributeColumn>();
+		}
+	}
+
 	class AttributeStraightforwardStringColumn : public AttributeStringColumn {
 	public:
 		const std::string &get(uint32_t index) const override {
@@ -221,7 +948,23 @@ namespace houdini_alembic {
 			const std::string &value = get(index);
 			return snprintf(buffer, buffersize, "%s", value.c_str());
 		}
+		uint32_t id(uint32_t index) const override {
+			return _ids[index];
+		}
+		const StringTable &stringTable() const override {
+			return *_table;
+		}
+		void countMemory(MemoryCounter &counter, long useCount) const override {
+			MemoryCounter::Scope scope(counter, this, sizeof(*this), useCount);
+			if (scope.first()) {
+				count_array_sample(counter, _strings);
+				counter.add(_ids);
+				counter.add(_table.get(), _table->memoryBytes(), _table.use_count());
+			}
+		}
 		StringArraySamplePtr _strings;
+		std::vector<uint32_t> _ids;
+		std::shared_ptr<StringTable> _table;
 	};
 
 	class AttributeIndexedStringColumn : public AttributeStringColumn {
@@ -238,100 +981,170 @@ namespace houdini_alembic {
 			const std::string &value = get(index);
 			return snprintf(buffer, buffersize, "%s", value.c_str());
 		}
+		uint32_t id(uint32_t index) const override {
+			return _ids[index];
+		}
+		const StringTable &stringTable() const override {
+			return *_table;
+		}
+		void countMemory(MemoryCounter &counter, long useCount) const override {
+			MemoryCounter::Scope scope(counter, this, sizeof(*this), useCount);
+			if (scope.first()) {
+				count_array_sample(counter, _indices);
+				count_array_sample(counter, _indexed_strings);
+				counter.add(_ids);
+				counter.add(_table.get(), _table->memoryBytes(), _table.use_count());
+			}
+		}
 		UInt32ArraySamplePtr _indices;
 		StringArraySamplePtr _indexed_strings;
+		std::vector<uint32_t> _ids;
+		std::shared_ptr<StringTable> _table;
 	};
 
-	inline bool parse_attributes(ICompoundProperty parent, const std::string &key, ISampleSelector selector, std::shared_ptr<AttributeColumn> &attributeColumn, std::string &geoScope) {
-		auto header = parent.getPropertyHeader(key);
-		auto metaData = header->getMetaData();
-		for (auto meta : metaData) {
-			if (meta.first == "geoScope") {
-				geoScope = meta.second;
+	// 前のフレームと同じサンプルか。読むのは鍵 (ダイジェスト) だけ
+	inline bool unchanged_since_previous(IArrayProperty property, ISampleSelector selector, const SceneBuilder &builder) {
+		if (builder.previous == nullptr) {
+			return false;
+		}
+		if (property.isConstant()) {
+			return true;
+		}
+		ArraySampleKey previousKey;
+		ArraySampleKey key;
+		return property.getKey(previousKey, builder.previousSelector) && property.getKey(key, selector) && previousKey == key;
+	}
+	inline bool unchanged_since_previous(ICompoundProperty parent, const PropertyHeader &header, ISampleSelector selector, const SceneBuilder &builder) {
+		if (builder.previous == nullptr) {
+			return false;
+		}
+		if (header.isCompound()) {
+			// .vals と .indices のどちらも変わっていないこと
+			ICompoundProperty compound(parent, header.getName());
+			const PropertyHeader *vals = compound.getPropertyHeader(".vals");
+			const PropertyHeader *indices = compound.getPropertyHeader(".indices");
+			if (vals == nullptr || indices == nullptr || vals->isArray() == false || indices->isArray() == false) {
+				return false;
 			}
+			return unchanged_since_previous(IArrayProperty(compound, ".vals"), selector, builder) && unchanged_since_previous(IArrayProperty(compound, ".indices"), selector, builder);
 		}
+		if (header.isArray()) {
+			return unchanged_since_previous(IArrayProperty(parent, header.getName()), selector, builder);
+		}
+		return false;
+	}
 
-		if (header->isCompound() && metaData.get("podName") == "string") {
-			ICompoundProperty string_compound(parent, key);
-
-			auto attributes = std::shared_ptr<AttributeIndexedStringColumn>(new AttributeIndexedStringColumn());
-			attributes->_indexed_strings = get_typed_array_property<IStringArrayProperty>(string_compound, ".vals", selector);
-			attributes->_indices = get_typed_array_property<IUInt32ArrayProperty>(string_compound, ".indices", selector);
-			attributeColumn = attributes;
-
-			return true;
-		} 
-		else if (header->isCompound() && metaData.get("podName") == "float32_t" && metaData.get("podExtent") == "2") {
-			ICompoundProperty string_compound(parent, key);
-
-			auto attributes = std::shared_ptr<AttributeIndexedVector2Column>(new AttributeIndexedVector2Column());
-			attributes->_indices = get_typed_array_property<IUInt32ArrayProperty>(string_compound, ".indices", selector);
-			attributes->_indexed_vector2 = get_typed_array_property<IV2fArrayProperty>(string_compound, ".vals", selector);
-			
-			attributeColumn = attributes;
-			return true;
-		}
-		else if (IV2fArrayProperty::matches(*header)) {
-			V2fArraySamplePtr value = get_typed_array_property<IV2fArrayProperty>(parent, key, selector);
-			auto value_ptr = value->get();
+	// 前のフレームのオブジェクトで、geoScope に応じた表から key の列を探す
+	inline std::shared_ptr<AttributeColumn> previous_column(const SceneObject *previous, const std::string &geoScope, const std::string &key) {
+		const AttributeSpreadSheet *sheet = nullptr;
+		if (geoScope == "con") {
+			sheet = &previous->details;
 		}
-		else if (IFloatArrayProperty::matches(*header, kNoMatching)) {
-			// float, vector2, vector3, vector4 handling
-			FloatArraySamplePtr value = get_typed_array_property<IFloatArrayProperty>(parent, key, selector);
-			uint8_t extent = header->getDataType().getExtent();
-			int arrayExtent = getArrayExtent(metaData);
-
-			int compornent_size = extent * arrayExtent;
-			int size = 0;
-
-			if (1 < arrayExtent) {
-				size = value->size() / arrayExtent;
+		else {
+			switch (previous->type()) {
+			case SceneObjectType_PolygonMesh: {
+				auto object = static_cast<const PolygonMeshObject *>(previous);
+				sheet = geoScope == "fvr" ? &object->vertices : geoScope == "uni" ? &object->primitives : &object->points;
+				break;
 			}
-			else {
-				size = value->size();
+			case SceneObjectType_Point:
+				sheet = &static_cast<const PointObject *>(previous)->points;
+				break;
+			case SceneObjectType_Curve: {
+				auto object = static_cast<const CurveObject *>(previous);
+				sheet = geoScope == "fvr" ? &object->vertices : geoScope == "uni" ? &object->primitives : &object->points;
+				break;
 			}
-			switch (compornent_size)
-			{
-			case 1: {
-				auto attributes = std::shared_ptr<AttributeStraightforwardFloatColumn>(new AttributeStraightforwardFloatColumn());
-				attributes->_floats = value;
-				attributeColumn = attributes;
-				return true;
+			default:
+				return std::shared_ptr<AttributeColumn>();
 			}
-			case 2: {
-				auto attributes = std::shared_ptr<AttributeStraightforwardVector2Column>(new AttributeStraightforwardVector2Column());
-				attributes->_floats = value;
-				attributes->_size = size;
-				attributeColumn = attributes;
-				return true;
+		}
+		for (const AttributeSpreadSheet::Attribute &attribute : sheet->sheet) {
+			if (attribute.key == key) {
+				return attribute.column;
 			}
-			case 3: {
-				auto attributes = std::shared_ptr<AttributeStraightforwardVector3Column>(new AttributeStraightforwardVector3Column());
-				attributes->_floats = value;
-				attributes->_size = size;
-				attributeColumn = attributes;
-				return true;
+		}
+		return std::shared_ptr<AttributeColumn>();
+	}
+
+	inline bool parse_attributes(ICompoundProperty parent, const std::string &key, ISampleSelector selector, const SceneBuilder &builder, std::shared_ptr<AttributeColumn> &attributeColumn, std::string &geoScope) {
+		auto header = parent.getPropertyHeader(key);
+		auto metaData = header->getMetaData();
+		for (auto meta : metaData) {
+			if (meta.first == "geoScope") {
+				geoScope = meta.second;
 			}
-			case 4: {
-				auto attributes = std::shared_ptr<AttributeStraightforwardVector4Column>(new AttributeStraightforwardVector4Column());
-				attributes->_floats = value;
-				attributes->_size = size;
-				attributeColumn = attributes;
+		}
+
+		TraceSpan span("parse_attributes", &key);
+		StatsScope scope(builder.stats, nullptr, &key);
+		if (builder.previous) {
+			auto previous = previous_column(builder.previous, geoScope, key);
+			if (previous && unchanged_since_previous(parent, *header, selector, builder)) {
+				if (builder.stats) {
+					builder.stats->sharedColumns++;
+				}
+				attributeColumn = previous;
 				return true;
 			}
-			default:
-				break;
-			}
 		}
-		else if (IInt32ArrayProperty::matches(*header)) {
-			auto attributes = std::shared_ptr<AttributeStraightforwardIntColumn>(new AttributeStraightforwardIntColumn());
-			attributes->_ints = get_typed_array_property<IInt32ArrayProperty>(parent, key, selector);
+		if (builder.stats) {
+			builder.stats->parsedColumns++;
+		}
+
+		if (header->isCompound() && metaData.get("podName") == "string") {
+			ICompoundProperty string_compound(parent, key);
+
+			auto attributes = builder.column<AttributeIndexedStringColumn>();
+			attributes->_indexed_strings = get_typed_array_property<IStringArrayProperty>(string_compound, ".vals", selector);
+			attributes->_indices = get_typed_array_property<IUInt32ArrayProperty>(string_compound, ".indices", selector);
+
+			// 値の表だけを登録し、行のidは添字から引く
+			std::vector<uint32_t> valueIds(attributes->_indexed_strings->size());
+			builder.strings->intern(attributes->_indexed_strings->get(), (uint32_t)valueIds.size(), valueIds.data());
+			const uint32_t *indices = attributes->_indices->get();
+			attributes->_ids.resize(attributes->_indices->size());
+			for (std::size_t i = 0; i < attributes->_ids.size(); ++i) {
+				attributes->_ids[i] = valueIds[indices[i]];
+			}
+			attributes->_table = builder.strings;
 			attributeColumn = attributes;
+
 			return true;
+		} 
+		else if (header->isCompound()) {
+			// indexed GeomParam (.vals + .indices)
+			ICompoundProperty indexed_compound(parent, key);
+			const PropertyHeader *vals = indexed_compound.getPropertyHeader(".vals");
+			const PropertyHeader *indices = indexed_compound.getPropertyHeader(".indices");
+			if (vals == nullptr || indices == nullptr || vals->isArray() == false || kStringPOD <= vals->getDataType().getPod()) {
+				return false;
+			}
+			ArraySamplePtr values = read_array_sample(IArrayProperty(indexed_compound, ".vals"), selector);
+			UInt32ArraySamplePtr rowIndices = get_typed_array_property<IUInt32ArrayProperty>(indexed_compound, ".indices", selector);
+
+			uint32_t componentCount = vals->getDataType().getExtent() * getArrayExtent(vals->getMetaData());
+			attributeColumn = native_column(builder, vals->getDataType().getPod(), values, rowIndices, (uint32_t)rowIndices->size(), componentCount);
+			return (bool)attributeColumn;
+		}
+		else if (header->isArray() && header->getDataType().getPod() < kStringPOD) {
+			// float, vector2, vector3, vector4 handling
+			// 整数や半精度も格納されている型のまま持つ
+			ArraySamplePtr values = read_array_sample(IArrayProperty(parent, key), selector);
+
+			uint8_t extent = header->getDataType().getExtent();
+			int arrayExtent = getArrayExtent(metaData);
+			uint32_t componentCount = extent * arrayExtent;
+			uint32_t rowCount = (uint32_t)(values->size() * extent / componentCount);
+			attributeColumn = native_column(builder, header->getDataType().getPod(), values, UInt32ArraySamplePtr(), rowCount, componentCount);
+			return (bool)attributeColumn;
 		}
 		else if (IStringArrayProperty::matches(*header)) {
-			auto attributes = std::shared_ptr<AttributeStraightforwardStringColumn>(new AttributeStraightforwardStringColumn());
+			auto attributes = builder.column<AttributeStraightforwardStringColumn>();
 			attributes->_strings = get_typed_array_property<IStringArrayProperty>(parent, key, selector);
+			attributes->_ids.resize(attributes->_strings->size());
+			builder.strings->intern(attributes->_strings->get(), (uint32_t)attributes->_ids.size(), attributes->_ids.data());
+			attributes->_table = builder.strings;
 			attributeColumn = attributes;
 			return true;
 		}
@@ -341,9 +1154,13 @@ namespace houdini_alembic {
 	}
 
 	static void parse_attributes(
-		AttributeSpreadSheet *points, AttributeSpreadSheet *vertices, AttributeSpreadSheet *primitives,
-		ICompoundProperty compound_prop, ISampleSelector selector
+		AttributeSpreadSheet *points, AttributeSpreadSheet *vertices, AttributeSpreadSheet *primitives, AttributeSpreadSheet *details,
+		ICompoundProperty compound_prop, ISampleSelector selector, const SceneBuilder &builder
 	) {
+		TraceSpan span("parse_attributes");
+		StatsTimer timer(builder.stats, &ReadStatsSink::parseAttributesNanoseconds);
+
+		std::vector<std::string> keys;
 		for (int i = 0; i < compound_prop.getNumProperties(); ++i) {
 			auto child_header = compound_prop.getPropertyHeader(i);
 			auto key = child_header.getName();
@@ -353,10 +1170,22 @@ namespace houdini_alembic {
 			if (key[0] == '.') {
 				continue;
 			}
+			keys.push_back(key);
+		}
 
-			std::shared_ptr<AttributeColumn> attributes;
-			std::string geoScope;
-			if (parse_attributes(compound_prop, key, selector, attributes, geoScope)) {
+		// 列ごとに独立しているのでタスクに分ける
+		std::vector<std::shared_ptr<AttributeColumn>> columns(keys.size());
+		std::vector<std::string> geoScopes(keys.size());
+		std::vector<char> parsed(keys.size());
+		builder.parallelFor((uint32_t)keys.size(), [&](uint32_t i) {
+			parsed[i] = parse_attributes(compound_prop, keys[i], selector, builder, columns[i], geoScopes[i]);
+		});
+
+		for (std::size_t i = 0; i < keys.size(); ++i) {
+			const std::string &key = keys[i];
+			const std::shared_ptr<AttributeColumn> &attributes = columns[i];
+			const std::string &geoScope = geoScopes[i];
+			if (parsed[i]) {
 				if (points && geoScope == "var" || geoScope == "vtx") {
 					points->sheet.emplace_back(key, attributes);
 				}
@@ -366,117 +1195,327 @@ namespace houdini_alembic {
 				else if (primitives && geoScope == "uni") {
 					primitives->sheet.emplace_back(key, attributes);
 				}
+				else if (details && geoScope == "con") {
+					details->sheet.emplace_back(key, attributes);
+				}
 			}
 		}
 		
 		if (points) {
 			std::sort(points->sheet.begin(), points->sheet.end());
+			points->index();
 		}
 		if (vertices) {
 			std::sort(vertices->sheet.begin(), vertices->sheet.end());
+			vertices->index();
 		}
 		if (primitives) {
 			std::sort(primitives->sheet.begin(), primitives->sheet.end());
+			primitives->index();
+		}
+		if (details) {
+			std::sort(details->sheet.begin(), details->sheet.end());
+			details->index();
 		}
 	}
 
-	inline void parse_polymesh(IPolyMesh polyMesh, std::shared_ptr<PolygonMeshObject> polymeshObject, ISampleSelector selector) {
+	/*
+	 P and v of huge point clouds, quantized to 16 bits per component relative to the bounds of each block of rows.
+	 A block that can not meet the error bound keeps its floats.
+	*/
+	class AttributeQuantizedVector3Column : public AttributeVector3Column {
+	public:
+		enum {
+			BLOCK_ROWS = 4096
+		};
+		struct Block {
+			float origin[3];
+			float step[3];
+			uint32_t offset = 0; // into _quantized or _floats, in components
+			bool quantized = false;
+		};
+
+		void get(uint32_t index, float *xyz) const override {
+			const Block &block = _blocks[index / BLOCK_ROWS];
+			uint32_t component = block.offset + index % BLOCK_ROWS * 3;
+			for (int i = 0; i < 3; ++i) {
+				xyz[i] = block.quantized ? block.origin[i] + _quantized[component + i] * block.step[i] : _floats[component + i];
+			}
+		}
+		void get(uint32_t index, double *xyz) const override {
+			float xs[3];
+			get(index, xs);
+			for (int i = 0; i < 3; ++i) {
+				xyz[i] = xs[i];
+			}
+		}
+		void getRows(uint32_t begin, uint32_t count, float *xyz) const override {
+			uint32_t end = begin + count;
+			while (begin < end) {
+				const Block &block = _blocks[begin / BLOCK_ROWS];
+				uint32_t row = begin % BLOCK_ROWS;
+				uint32_t n = std::min<uint32_t>(end - begin, BLOCK_ROWS - row);
+				uint32_t component = block.offset + row * 3;
+				if (block.quantized) {
+					decode(block, _quantized.data() + component, n, xyz);
+				}
+				else {
+					memcpy(xyz, _floats.data() + component, n * 3 * sizeof(float));
+				}
+				xyz += n * 3;
+				begin += n;
+			}
+		}
+		uint32_t rowCount() const override {
+			return _rowCount;
+		}
+		int snprint(uint32_t index, char *buffer, uint32_t buffersize) const override {
+			float xs[3];
+			get(index, xs);
+			return snprintf(buffer, buffersize, "(%f, %f, %f)", xs[0], xs[1], xs[2]);
+		}
+		AttributeStorageType storageType() const override {
+			return AttributeStorageType_UInt16;
+		}
+		uint32_t componentCount() const override {
+			return 3;
+		}
+
+		void encode(const AttributeVector3Column *column, float maxError) {
+			_rowCount = column->rowCount();
+			_blocks.resize((_rowCount + BLOCK_ROWS - 1) / BLOCK_ROWS);
+
+			std::vector<float> xyz(std::min<uint32_t>(_rowCount, BLOCK_ROWS) * 3);
+			for (uint32_t b = 0; b < _blocks.size(); ++b) {
+				uint32_t begin = b * BLOCK_ROWS;
+				uint32_t n = std::min<uint32_t>(_rowCount - begin, BLOCK_ROWS);
+				column->getRows(begin, n, xyz.data());
+
+				Block &block = _blocks[b];
+				float lower[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+				float upper[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+				bool finite = true;
+				for (uint32_t i = 0; i < n * 3; ++i) {
+					finite = finite && std::isfinite(xyz[i]);
+					lower[i % 3] = std::min(lower[i % 3], xyz[i]);
+					upper[i % 3] = std::max(upper[i % 3], xyz[i]);
+				}
+
+				// 丸めの誤差は半ステップまで。NaNやinfを含むブロックは量子化しない
+				block.quantized = finite;
+				for (int i = 0; i < 3; ++i) {
+					block.origin[i] = lower[i];
+					block.step[i] = (upper[i] - lower[i]) / 65535.0f;
+					if (!(block.step[i] * 0.5f <= maxError) || std::isinf(block.step[i])) {
+						block.quantized = false;
+					}
+				}
+
+				if (block.quantized) {
+					block.offset = (uint32_t)_quantized.size();
+					_quantized.resize(_quantized.size() + n * 3);
+					uint16_t *q = _quantized.data() + block.offset;
+					for (uint32_t i = 0; i < n * 3; ++i) {
+						float step = block.step[i % 3];
+						float x = step == 0.0f ? 0.0f : (xyz[i] - block.origin[i % 3]) / step + 0.5f;
+						q[i] = (uint16_t)std::min(x, 65535.0f);
+					}
+				}
+				else {
+					block.offset = (uint32_t)_floats.size();
+					_floats.insert(_floats.end(), xyz.begin(), xyz.begin() + n * 3);
+				}
+			}
+			_quantized.shrink_to_fit();
+			_floats.shrink_to_fit();
+		}
+
+		void countMemory(MemoryCounter &counter, long useCount) const override {
+			MemoryCounter::Scope scope(counter, this, sizeof(*this), useCount);
+			if (scope.first()) {
+				counter.add(_blocks);
+				counter.add(_quantized);
+				counter.add(_floats);
+			}
+		}
+
+		std::vector<Block> _blocks;
+		std::vector<uint16_t> _quantized;
+		std::vector<float> _floats;
+		uint32_t _rowCount = 0;
+	private:
+		static void decode(const Block &block, const uint16_t *q, uint32_t rows, float *xyz) {
+			uint32_t n = rows * 3;
+			uint32_t i = 0;
+#if defined(HOUDINI_ALEMBIC_SSE2)
+			// 4成分ずつ変換する。x, y, zの並びは3ベクタごとに一巡する
+			const __m128 steps[3] = {
+				_mm_setr_ps(block.step[0], block.step[1], block.step[2], block.step[0]),
+				_mm_setr_ps(block.step[1], block.step[2], block.step[0], block.step[1]),
+				_mm_setr_ps(block.step[2], block.step[0], block.step[1], block.step[2]),
+			};
+			const __m128 origins[3] = {
+				_mm_setr_ps(block.origin[0], block.origin[1], block.origin[2], block.origin[0]),
+				_mm_setr_ps(block.origin[1], block.origin[2], block.origin[0], block.origin[1]),
+				_mm_setr_ps(block.origin[2], block.origin[0], block.origin[1], block.origin[2]),
+			};
+			const __m128i zero = _mm_setzero_si128();
+			for (; i + 24 <= n; i += 24) {
+				for (int j = 0; j < 3; ++j) {
+					__m128i v = _mm_loadu_si128((const __m128i *)(q + i + j * 8));
+					__m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+					__m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero));
+					int k = j * 2;
+					_mm_storeu_ps(xyz + i + k * 4, _mm_add_ps(_mm_mul_ps(lo, steps[k % 3]), origins[k % 3]));
+					_mm_storeu_ps(xyz + i + k * 4 + 4, _mm_add_ps(_mm_mul_ps(hi, steps[(k + 1) % 3]), origins[(k + 1) % 3]));
+				}
+			}
+#endif
+			for (; i < n; ++i) {
+				xyz[i] = block.origin[i % 3] + q[i] * block.step[i % 3];
+			}
+		}
+	};
+
+	inline void quantize_points(AttributeSpreadSheet &points, const SceneBuilder &builder) {
+		StatsTimer timer(builder.stats, &ReadStatsSink::extractPNanoseconds);
+		for (auto &attribute : points.sheet) {
+			if (attribute.key != "P" && attribute.key != "v") {
+				continue;
+			}
+			if (attribute.column->attributeType() != AttributeType_Vector3) {
+				continue;
+			}
+			// 前のフレームから引き継いだ列は量子化済み
+			if (dynamic_cast<const AttributeQuantizedVector3Column *>(attribute.column.get())) {
+				continue;
+			}
+			auto column = builder.column<AttributeQuantizedVector3Column>();
+			column->encode(static_cast<const AttributeVector3Column *>(attribute.column.get()), builder.pointQuantization);
+
+			// 元のサンプルはここで手放す
+			attribute.column = column;
+		}
+	}
+
+	inline void copy_P(const AttributeSpreadSheet &points, std::vector<Vector3f> &P, const SceneBuilder &builder) {
+		StatsTimer timer(builder.stats, &ReadStatsSink::extractPNanoseconds);
+		static const TypedAttributeHandle<AttributeVector3Column> kP("P");
+		auto p = points.column(kP);
+		P.resize(p->rowCount());
+		p->getRows(0, (uint32_t)P.size(), (float *)P.data());
+	}
+
+	inline void parse_polymesh(IPolyMesh polyMesh, std::shared_ptr<PolygonMeshObject> polymeshObject, ISampleSelector selector, const SceneBuilder &builder) {
+		TraceSpan span("parse_polymesh");
 		auto schema = polyMesh.getSchema();
-		IPolyMeshSchema::Sample sample;
-		schema.get(sample, selector);
-		
-		Int32ArraySamplePtr faceCounts = sample.getFaceCounts();
-		polymeshObject->faceCounts = std::vector<uint32_t>(faceCounts->get(), faceCounts->get() + faceCounts->size());
+		auto previous = static_cast<const PolygonMeshObject *>(builder.previous);
 
-		Int32ArraySamplePtr indices = sample.getFaceIndices();
-		polymeshObject->indices = std::vector<uint32_t>(indices->get(), indices->get() + indices->size());
+		// トポロジは変わらないことが多い
+		if (unchanged_since_previous(schema.getFaceCountsProperty(), selector, builder)) {
+			polymeshObject->faceCounts = previous->faceCounts;
+		}
+		else {
+			Int32ArraySamplePtr faceCounts = read_array_sample(schema.getFaceCountsProperty(), selector);
+			polymeshObject->faceCounts.assign(faceCounts->get(), faceCounts->get() + faceCounts->size());
+		}
+		if (unchanged_since_previous(schema.getFaceIndicesProperty(), selector, builder)) {
+			polymeshObject->indices = previous->indices;
+		}
+		else {
+			Int32ArraySamplePtr indices = read_array_sample(schema.getFaceIndicesProperty(), selector);
+			polymeshObject->indices.assign(indices->get(), indices->get() + indices->size());
+		}
 
 		parse_attributes(
-			&polymeshObject->points, &polymeshObject->vertices, &polymeshObject->primitives,
-			schema.getArbGeomParams(), selector
+			&polymeshObject->points, &polymeshObject->vertices, &polymeshObject->primitives, &polymeshObject->details,
+			schema.getArbGeomParams(), selector, builder
 		);
 		parse_attributes(
-			&polymeshObject->points, &polymeshObject->vertices, &polymeshObject->primitives,
-			ICompoundProperty(polyMesh.getProperties(), ".geom"), selector
+			&polymeshObject->points, &polymeshObject->vertices, &polymeshObject->primitives, &polymeshObject->details,
+			ICompoundProperty(polyMesh.getProperties(), ".geom"), selector, builder
 		);
 
 		// Pは流石に登場頻度が高いので予め入れておく
-		auto p = polymeshObject->points.column_as_vector3("P");
-		polymeshObject->P.resize(p->rowCount());
-		for (int i = 0; i < polymeshObject->P.size() ; ++i) {
-			float *xyz = (float *)&polymeshObject->P[i];
-			p->get(i, xyz);
-		}
+		copy_P(polymeshObject->points, polymeshObject->P, builder);
 	}
 
-	inline void parse_points(IPoints points, std::shared_ptr<PointObject> pointObject, ISampleSelector selector) {
+	inline void parse_points(IPoints points, std::shared_ptr<PointObject> pointObject, ISampleSelector selector, const SceneBuilder &builder) {
+		TraceSpan span("parse_points");
 		auto schema = points.getSchema();
-		IPointsSchema::Sample sample;
-		schema.get(sample, selector);
+		auto previous = static_cast<const PointObject *>(builder.previous);
 
-		auto pointIds = sample.getIds();
-		pointObject->pointIds = std::vector<uint64_t>(pointIds->get(), pointIds->get() + pointIds->size());
+		if (unchanged_since_previous(schema.getIdsProperty(), selector, builder)) {
+			pointObject->pointIds = previous->pointIds;
+		}
+		else {
+			auto pointIds = read_array_sample(schema.getIdsProperty(), selector);
+			pointObject->pointIds.assign(pointIds->get(), pointIds->get() + pointIds->size());
+		}
 		
 		parse_attributes(
-			&pointObject->points, nullptr, nullptr,
-			schema.getArbGeomParams(), selector
+			&pointObject->points, nullptr, nullptr, &pointObject->details,
+			schema.getArbGeomParams(), selector, builder
 		);
 		parse_attributes(
-			&pointObject->points, nullptr, nullptr,
-			ICompoundProperty(points.getProperties(), ".geom"), selector
+			&pointObject->points, nullptr, nullptr, &pointObject->details,
+			ICompoundProperty(points.getProperties(), ".geom"), selector, builder
 		);
 
-		// Pは流石に登場頻度が高いので予め入れておく
-		auto p = pointObject->points.column_as_vector3("P");
-		pointObject->P.resize(p->rowCount());
-		for (int i = 0; i < pointObject->P.size(); ++i) {
-			float *xyz = (float *)&pointObject->P[i];
-			p->get(i, xyz);
+		if (0.0f < builder.pointQuantization) {
+			quantize_points(pointObject->points, builder);
+			pointObject->P.clear();
+			return;
 		}
+
+		// Pは流石に登場頻度が高いので予め入れておく
+		copy_P(pointObject->points, pointObject->P, builder);
 	}
 
-	inline void parse_curves(ICurves curves, std::shared_ptr<CurveObject> curveObject, ISampleSelector selector) {
+	inline void parse_curves(ICurves curves, std::shared_ptr<CurveObject> curveObject, ISampleSelector selector, const SceneBuilder &builder) {
+		TraceSpan span("parse_curves");
 		auto schema = curves.getSchema();
-		ICurvesSchema::Sample sample;
-		schema.get(sample, selector);
+		auto previous = static_cast<const CurveObject *>(builder.previous);
 
 		parse_attributes(
-			&curveObject->points, &curveObject->vertices, &curveObject->primitives,
-			schema.getArbGeomParams(), selector
+			&curveObject->points, &curveObject->vertices, &curveObject->primitives, &curveObject->details,
+			schema.getArbGeomParams(), selector, builder
 		);
 		parse_attributes(
-			&curveObject->points, &curveObject->vertices, &curveObject->primitives,
-			ICompoundProperty(curves.getProperties(), ".geom"), selector
+			&curveObject->points, &curveObject->vertices, &curveObject->primitives, &curveObject->details,
+			ICompoundProperty(curves.getProperties(), ".geom"), selector, builder
 		);
 
-		Int32ArraySamplePtr curvePointCounts = sample.getCurvesNumVertices();
-		curveObject->curvePrimitives.reserve(curvePointCounts->size());
+		if (unchanged_since_previous(schema.getNumVerticesProperty(), selector, builder)) {
+			curveObject->curvePrimitives = previous->curvePrimitives;
+		}
+		else {
+			Int32ArraySamplePtr curvePointCounts = read_array_sample(schema.getNumVerticesProperty(), selector);
+			curveObject->curvePrimitives.reserve(curvePointCounts->size());
 
-		int32_t P_index_Head = 0;
-		for (int i = 0; i < curvePointCounts->size(); ++i) {
-			auto N = curvePointCounts->get()[i];
+			int32_t P_index_Head = 0;
+			for (int i = 0; i < curvePointCounts->size(); ++i) {
+				auto N = curvePointCounts->get()[i];
 
-			CurveObject::CurvePrimitive primitive;
-			primitive.P_beg_index = P_index_Head;
-			primitive.P_end_index = P_index_Head + N;
-			curveObject->curvePrimitives.emplace_back(primitive);
+				CurveObject::CurvePrimitive primitive;
+				primitive.P_beg_index = P_index_Head;
+				primitive.P_end_index = P_index_Head + N;
+				curveObject->curvePrimitives.emplace_back(primitive);
 
-			P_index_Head += N;
+				P_index_Head += N;
+			}
 		}
 
 		// Pは流石に登場頻度が高いので予め入れておく
-		auto p = curveObject->points.column_as_vector3("P");
-		curveObject->P.resize(p->rowCount());
-		for (int i = 0; i < curveObject->P.size(); ++i) {
-			float *xyz = (float *)&curveObject->P[i];
-			p->get(i, xyz);
-		}
+		copy_P(curveObject->points, curveObject->P, builder);
 	}
 
 	static void parse_common_property(IObject o, SceneObject *object, const std::vector<M44d> &xforms, ISampleSelector selector) {
+		TraceSpan span("parse_common_property");
 		IXform parentXForm(o.getParent());
 		object->name = parentXForm.getFullName();
 
+		object->xforms.reserve(xforms.size());
 		for (int i = 0; i < xforms.size(); ++i) {
 			object->xforms.push_back(to(xforms[i]));
 		}
@@ -493,45 +1532,73 @@ namespace houdini_alembic {
 		}
 	}
 
-	static void parse_object(IObject o, ISampleSelector selector, std::vector<M44d> xforms, std::vector<SceneObjectPointer> &objects) {
-		auto header = o.getHeader();
-		std::string fullname = header.getFullName();
-
+	// 階層をたどるときにオブジェクトをどう扱うか
+	enum ObjectKind {
+		ObjectKind_Group,
+		ObjectKind_Xform,
+		ObjectKind_PolygonMesh,
+		ObjectKind_Point,
+		ObjectKind_Curve,
+		ObjectKind_Camera,
+	};
+	inline ObjectKind kind_of(const ObjectHeader &header) {
 		if (IPolyMesh::matches(header)) {
+			return ObjectKind_PolygonMesh;
+		}
+		if (IPoints::matches(header)) {
+			return ObjectKind_Point;
+		}
+		if (ICurves::matches(header)) {
+			return ObjectKind_Curve;
+		}
+		if (ICamera::matches(header)) {
+			return ObjectKind_Camera;
+		}
+		if (IXform::matches(header)) {
+			return ObjectKind_Xform;
+		}
+		return ObjectKind_Group;
+	}
+
+	// 子を持たない、シーンのオブジェクトになるもの
+	static std::shared_ptr<SceneObject> parse_leaf(ObjectKind kind, IObject o, ISampleSelector selector, const std::vector<M44d> &xforms, SceneBuilder &builder, std::size_t index) {
+		switch (kind) {
+		case ObjectKind_PolygonMesh: {
 			IPolyMesh polyMesh(o);
-			std::shared_ptr<PolygonMeshObject> object(new PolygonMeshObject());
+			auto object = builder.object<PolygonMeshObject>(index);
 
 			parse_common_property(o, object.get(), xforms, selector);
-			parse_polymesh(polyMesh, object, selector);
+			parse_polymesh(polyMesh, object, selector, builder);
 
-			objects.emplace_back(object);
+			return object;
 		}
-		else if (IPoints::matches(header)) {
+		case ObjectKind_Point: {
 			IPoints points(o);
-			std::shared_ptr<PointObject> object(new PointObject());
+			auto object = builder.object<PointObject>(index);
 
 			parse_common_property(o, object.get(), xforms, selector);
-			parse_points(points, object, selector);
+			parse_points(points, object, selector, builder);
 
-			objects.emplace_back(object);
+			return object;
 		}
-		else if (ICurves::matches(header)) {
+		case ObjectKind_Curve: {
 			ICurves curves(o);
-			std::shared_ptr<CurveObject> object(new CurveObject());
+			auto object = builder.object<CurveObject>(index);
 
 			parse_common_property(o, object.get(), xforms, selector);
-			parse_curves(curves, object, selector);
+			parse_curves(curves, object, selector, builder);
 
-			objects.emplace_back(object);
+			return object;
 		}
-		else if (ICamera::matches(header)) {
+		case ObjectKind_Camera: {
 			// Implementation Notes
 			https://docs.google.com/presentation/d/1f5EVQTul15x4Q30IbeA7hP9_Xc0AgDnWsOacSQmnNT8/edit?usp=sharing
 
+			TraceSpan span("parse_camera");
 			ICamera camera(o);
 			auto schema = camera.getSchema();
 
-			std::shared_ptr<CameraObject> object(new CameraObject());
+			auto object = builder.object<CameraObject>(index);
 
 			IXform parentXForm(o.getParent());
 			object->name = parentXForm.getFullName();
@@ -602,49 +1669,559 @@ namespace houdini_alembic {
 			object->objectPlaneWidth  = 2.0f * object->focusDistance * std::tan(0.5f * object->fov_horizontal_degree / 360.0f * 2.0 * M_PI);
 			object->objectPlaneHeight = 2.0f * object->focusDistance * std::tan(0.5f * object->fov_vertical_degree   / 360.0f * 2.0 * M_PI);
 
-			objects.emplace_back(object);
+			return object;
+		}
+		default:
+			return std::shared_ptr<SceneObject>();
+		}
+	}
+
+	/*
+	 The hierarchy in depth first order, with the kind of every object already resolved.
+	 Archives with the same hierarchy share one plan.
+	*/
+	struct ScenePlan {
+		enum {
+			kTopNode = 0xFFFFFFFF
+		};
+		struct Node {
+			uint32_t parent = kTopNode; // index of the parent node
+			uint32_t child = 0;         // index in the children of the parent
+			uint32_t xformDepth = 0;    // number of Xforms above
+			ObjectKind kind = ObjectKind_Group;
+		};
+		std::vector<Node> nodes;
+	};
+
+	static void build_plan(IObject o, uint32_t parent, uint32_t xformDepth, ScenePlan &plan) {
+		for (uint32_t i = 0; i < o.getNumChildren(); ++i) {
+			IObject child = o.getChild(i);
+			ScenePlan::Node node;
+			node.parent = parent;
+			node.child = i;
+			node.xformDepth = xformDepth;
+			node.kind = kind_of(child.getHeader());
+
+			uint32_t index = (uint32_t)plan.nodes.size();
+			plan.nodes.push_back(node);
+			if (node.kind == ObjectKind_Xform) {
+				build_plan(child, index, xformDepth + 1, plan);
+			}
+			else if (node.kind == ObjectKind_Group) {
+				build_plan(child, index, xformDepth, plan);
+			}
 		}
-		else if (IXform::matches(header)) {
-			IXform xform(o);
-			auto schema = xform.getSchema();
-			auto schemaValue = schema.getValue(selector);
-			M44d matrix = schemaValue.getMatrix();
-			xforms.push_back(matrix);
+	}
 
-			for (int i = 0; i < o.getNumChildren(); ++i) {
-				IObject child = o.getChild(i);
-				parse_object(child, selector, xforms, objects);
+	/*
+	 Whether build_plan would give exactly this plan for o, i.e. the same kinds at the same child indices.
+	 Walks in the order of build_plan and stops at the first difference. Names and samples are not read.
+	*/
+	static bool matches_plan(IObject o, uint32_t parent, const ScenePlan &plan, std::size_t &cursor) {
+		for (uint32_t i = 0; i < o.getNumChildren(); ++i) {
+			if (plan.nodes.size() <= cursor) {
+				return false;
+			}
+			const ScenePlan::Node &node = plan.nodes[cursor];
+			IObject child = o.getChild(i);
+			if (node.parent != parent || node.child != i || node.kind != kind_of(child.getHeader())) {
+				return false;
+			}
+			uint32_t index = (uint32_t)cursor++;
+			if (node.kind == ObjectKind_Xform || node.kind == ObjectKind_Group) {
+				if (!matches_plan(child, index, plan, cursor)) {
+					return false;
+				}
 			}
 		}
-		else {
-			for (int i = 0; i < o.getNumChildren(); ++i) {
-				IObject child = o.getChild(i);
-				parse_object(child, selector, xforms, objects);
+		return true;
+	}
+	static bool matches_plan(IObject top, const ScenePlan &plan) {
+		std::size_t cursor = 0;
+		return matches_plan(top, ScenePlan::kTopNode, plan, cursor) && cursor == plan.nodes.size();
+	}
+
+	/*
+	 The objects are in the order of the plan. Xforms and groups are walked first,
+	 then the objects are parsed as tasks, each into its own position.
+	*/
+	static void parse_plan(IObject top, const ScenePlan &plan, ISampleSelector selector, SceneBuilder &builder, std::vector<SceneObjectPointer> &objects) {
+		struct Leaf {
+			ObjectKind kind;
+			IObject o;
+			std::vector<M44d> xforms;
+		};
+		std::vector<Leaf> leaves;
+		std::vector<IObject> parents(plan.nodes.size());
+		std::vector<M44d> xforms;
+		for (std::size_t i = 0; i < plan.nodes.size(); ++i) {
+			const ScenePlan::Node &node = plan.nodes[i];
+			IObject o = (node.parent == ScenePlan::kTopNode ? top : parents[node.parent]).getChild(node.child);
+			xforms.resize(node.xformDepth);
+
+			switch (node.kind) {
+			case ObjectKind_Xform: {
+				IXform xform(o);
+				xforms.push_back(xform.getSchema().getValue(selector).getMatrix());
+				parents[i] = o;
+				break;
+			}
+			case ObjectKind_Group:
+				parents[i] = o;
+				break;
+			default:
+				leaves.push_back(Leaf{ node.kind, o, xforms });
+				break;
+			}
+		}
+
+		std::size_t base = objects.size();
+		std::vector<std::shared_ptr<SceneObject>> parsed(leaves.size());
+		builder.parallelFor((uint32_t)leaves.size(), [&](uint32_t i) {
+			// 取り消されたら、残りのオブジェクトは読まない
+			if (builder.cancelled()) {
+				return;
+			}
+			std::string name = builder.stats || trace_recording() ? leaves[i].o.getParent().getFullName() : std::string();
+			StatsScope scope(builder.stats, &name, nullptr);
+			TraceSpan span("parse_leaf", &name);
+			parsed[i] = parse_leaf(leaves[i].kind, leaves[i].o, selector, leaves[i].xforms, builder, base + i);
+		});
+		for (auto &object : parsed) {
+			objects.emplace_back(std::move(object));
+		}
+	}
+
+	/*
+	 parse_plan for several frames, one scene each.
+	 The hierarchy is walked once. Every object is a task that parses its frames in ascending order,
+	 so each property is read sample after sample and can share what did not change with the frame before.
+	*/
+	static void parse_plan_range(IObject top, const ScenePlan &plan, const std::vector<ISampleSelector> &selectors, SceneBuilder &builder, std::vector<std::shared_ptr<AlembicScene>> &scenes) {
+		struct Leaf {
+			ObjectKind kind;
+			IObject o;
+			std::vector<uint32_t> xformNodes;
+		};
+		std::vector<Leaf> leaves;
+		std::vector<IObject> parents(plan.nodes.size());
+		std::vector<std::vector<M44d>> matrices(plan.nodes.size()); // Xformごと、フレームごと
+		std::vector<uint32_t> xformNodes;
+		for (std::size_t i = 0; i < plan.nodes.size(); ++i) {
+			const ScenePlan::Node &node = plan.nodes[i];
+			IObject o = (node.parent == ScenePlan::kTopNode ? top : parents[node.parent]).getChild(node.child);
+			xformNodes.resize(node.xformDepth);
+
+			switch (node.kind) {
+			case ObjectKind_Xform: {
+				IXformSchema schema = IXform(o).getSchema();
+				for (const ISampleSelector &selector : selectors) {
+					matrices[i].push_back(schema.getValue(selector).getMatrix());
+				}
+				xformNodes.push_back((uint32_t)i);
+				parents[i] = o;
+				break;
+			}
+			case ObjectKind_Group:
+				parents[i] = o;
+				break;
+			default:
+				leaves.push_back(Leaf{ node.kind, o, xformNodes });
+				break;
+			}
+		}
+
+		std::vector<std::vector<std::shared_ptr<SceneObject>>> parsed(leaves.size(), std::vector<std::shared_ptr<SceneObject>>(selectors.size()));
+		builder.parallelFor((uint32_t)leaves.size(), [&](uint32_t i) {
+			const Leaf &leaf = leaves[i];
+			std::string name = builder.stats || trace_recording() ? leaf.o.getParent().getFullName() : std::string();
+			StatsScope scope(builder.stats, &name, nullptr);
+			std::vector<M44d> xforms(leaf.xformNodes.size());
+			for (std::size_t frame = 0; frame < selectors.size(); ++frame) {
+				if (builder.cancelled()) {
+					return;
+				}
+				for (std::size_t j = 0; j < xforms.size(); ++j) {
+					xforms[j] = matrices[leaf.xformNodes[j]][frame];
+				}
+				SceneBuilder frameBuilder = builder;
+				frameBuilder.arena = scenes[frame]->arena;
+				if (0 < frame) {
+					frameBuilder.previous = parsed[i][frame - 1].get();
+					frameBuilder.previousSelector = selectors[frame - 1];
+				}
+				TraceSpan span("parse_leaf", &name);
+				parsed[i][frame] = parse_leaf(leaf.kind, leaf.o, selectors[frame], xforms, frameBuilder, 0);
+			}
+		});
+		for (std::size_t frame = 0; frame < selectors.size(); ++frame) {
+			for (auto &objects : parsed) {
+				scenes[frame]->objects.emplace_back(std::move(objects[frame]));
+			}
+		}
+	}
+
+	uint32_t StringTable::intern(const std::string &value) {
+		uint32_t id;
+		intern(&value, 1, &id);
+		return id;
+	}
+	void StringTable::intern(const std::string *values, uint32_t count, uint32_t *ids) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (uint32_t i = 0; i < count; ++i) {
+			auto it = _ids.find(values[i]);
+			if (it == _ids.end()) {
+				it = _ids.emplace(values[i], (uint32_t)_strings.size()).first;
+				_strings.emplace_back(values[i]);
+			}
+			ids[i] = it->second;
+		}
+	}
+	const std::string &StringTable::string(uint32_t id) const {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _strings[id];
+	}
+	uint32_t StringTable::size() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return (uint32_t)_strings.size();
+	}
+
+	/*
+	 The ids of the attribute handles. Every key has an untyped id and one id per AttributeType, given out on first use.
+	 index() looks keys up for every sheet read, so lookups share the lock.
+	*/
+	class AttributeHandleRegistry {
+	public:
+		static AttributeHandleRegistry &instance() {
+			static AttributeHandleRegistry registry;
+			return registry;
+		}
+
+		// attributeType -1 for the untyped id
+		uint32_t resolve(const std::string &key, int attributeType) {
+			{
+				std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+				auto it = _ids.find(key);
+				if (it != _ids.end() && it->second[attributeType + 1] != AttributeHandle::kInvalidId) {
+					return it->second[attributeType + 1];
+				}
 			}
+			std::unique_lock<std::shared_timed_mutex> lock(_mutex);
+			auto it = _ids.find(key);
+			if (it == _ids.end()) {
+				std::array<uint32_t, 7> ids;
+				ids.fill(AttributeHandle::kInvalidId);
+				it = _ids.emplace(key, ids).first;
+			}
+			uint32_t &id = it->second[attributeType + 1];
+			if (id == AttributeHandle::kInvalidId) {
+				id = (uint32_t)_keys.size();
+				_keys.push_back(&it->first);
+				_count = (uint32_t)_keys.size();
+			}
+			return id;
+		}
+		void find(const std::string &key, AttributeType attributeType, uint32_t *untypedId, uint32_t *typedId) const {
+			std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+			auto it = _ids.find(key);
+			*untypedId = it == _ids.end() ? AttributeHandle::kInvalidId : it->second[0];
+			*typedId = it == _ids.end() ? AttributeHandle::kInvalidId : it->second[attributeType + 1];
 		}
+		const std::string &key(uint32_t id) const {
+			std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+			return *_keys[id];
+		}
+		uint32_t count() const {
+			return _count;
+		}
+	private:
+		mutable std::shared_timed_mutex _mutex;
+		// unordered_mapのキーは再ハッシュでも動かない
+		std::unordered_map<std::string, std::array<uint32_t, 7>> _ids;
+		std::vector<const std::string *> _keys;
+		std::atomic<uint32_t> _count{ 0 };
+	};
+
+	AttributeHandle::AttributeHandle(const std::string &key) {
+		_id = AttributeHandleRegistry::instance().resolve(key, -1);
+	}
+	AttributeHandle::AttributeHandle(const std::string &key, AttributeType attributeType) {
+		_id = AttributeHandleRegistry::instance().resolve(key, attributeType);
+	}
+	const std::string &AttributeHandle::key() const {
+		return AttributeHandleRegistry::instance().key(_id);
+	}
+	uint32_t AttributeHandle::resolvedCount() {
+		return AttributeHandleRegistry::instance().count();
 	}
-	static void parse_object(IObject o, ISampleSelector selector, std::vector<SceneObjectPointer> &objects) {
-		parse_object(o, selector, std::vector<M44d>(), objects);
+	void AttributeHandle::find(const std::string &key, AttributeType attributeType, uint32_t *untypedId, uint32_t *typedId) {
+		AttributeHandleRegistry::instance().find(key, attributeType, untypedId, typedId);
+	}
+
+	void AttributeSpreadSheet::index() {
+		// これより後に作られたハンドルはキーで引く
+		_indexedIds = AttributeHandle::resolvedCount();
+		_slots.clear();
+		for (uint32_t i = 0; i < sheet.size(); ++i) {
+			uint32_t ids[2];
+			AttributeHandle::find(sheet[i].key, sheet[i].column->attributeType(), &ids[0], &ids[1]);
+			for (uint32_t id : ids) {
+				if (_indexedIds <= id) {
+					continue;
+				}
+				if (_slots.size() <= id) {
+					_slots.resize(id + 1);
+				}
+				_slots[id] = i + 1;
+			}
+		}
+	}
+
+	uint64_t StringTable::memoryBytes() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+		uint64_t bytes = 0;
+		for (const std::string &value : _strings) {
+			bytes += sizeof(std::string) + MemoryCounter::heapBytes(value);
+		}
+		// 見積もり: ノード1つにキーと値と次へのポインタ、さらにバケット配列
+		bytes += _ids.size() * (sizeof(std::string) + sizeof(uint32_t) + sizeof(void *) * 2);
+		bytes += _ids.bucket_count() * sizeof(void *);
+		for (const auto &id : _ids) {
+			bytes += MemoryCounter::heapBytes(id.first);
+		}
+		return bytes;
+	}
+
+	uint64_t MemoryCounter::heapBytes(const std::string &value) {
+		const char *data = value.data();
+		const char *self = reinterpret_cast<const char *>(&value);
+		std::less<const char *> less;
+		if (!less(data, self) && less(data, self + sizeof(value))) {
+			return 0;
+		}
+		return value.capacity() + 1;
+	}
+	void MemoryCounter::add(const void *buffer, uint64_t bytes, long useCount) {
+		if (buffer == nullptr) {
+			return;
+		}
+		Buffer &b = _buffers[buffer];
+		if (b.references == 0) {
+			b.bytes = bytes;
+			b.useCount = useCount;
+		}
+		b.references++;
+		if (!_owners.empty() && std::find(b.owners.begin(), b.owners.end(), _owners.back()) == b.owners.end()) {
+			b.owners.push_back(_owners.back());
+		}
+	}
+	bool MemoryCounter::enter(const void *owner, uint64_t bytes, long useCount) {
+		bool first = _buffers.count(owner) == 0;
+		add(owner, bytes, useCount);
+		_owners.push_back(owner);
+		return first;
+	}
+	void MemoryCounter::leave() {
+		_owners.pop_back();
+	}
+	bool MemoryCounter::owned(const void *buffer, std::unordered_map<const void *, bool> &resolved) const {
+		auto it = resolved.find(buffer);
+		if (it != resolved.end()) {
+			return it->second;
+		}
+		const Buffer &b = _buffers.at(buffer);
+		bool result = b.useCount <= b.references;
+		for (const void *owner : b.owners) {
+			result = result && owned(owner, resolved);
+		}
+		resolved[buffer] = result;
+		return result;
+	}
+	MemoryUsage MemoryCounter::usage() const {
+		MemoryUsage usage;
+		std::unordered_map<const void *, bool> resolved;
+		for (const auto &buffer : _buffers) {
+			if (owned(buffer.first, resolved)) {
+				usage.ownedBytes += buffer.second.bytes;
+			}
+			else {
+				usage.sharedBytes += buffer.second.bytes;
+			}
+			usage.buffers++;
+		}
+		return usage;
+	}
+
+	MemoryUsage AttributeColumn::memoryUsage() const {
+		MemoryCounter counter;
+		countMemory(counter, 1);
+		return counter.usage();
+	}
+	void AttributeColumn::countMemory(MemoryCounter &counter, long useCount) const {
+		MemoryCounter::Scope scope(counter, this, sizeof(*this), useCount);
+	}
+
+	void AttributeSpreadSheet::countMemory(MemoryCounter &counter) const {
+		counter.add(sheet);
+		counter.add(_slots);
+		for (const Attribute &attribute : sheet) {
+			counter.add(attribute.key);
+			if (attribute.column) {
+				attribute.column->countMemory(counter, attribute.column.use_count());
+			}
+		}
+	}
+
+	MemoryUsage SceneObject::memoryUsage() const {
+		MemoryCounter counter;
+		countMemory(counter, 1);
+		return counter.usage();
+	}
+	void SceneObject::countMemory(MemoryCounter &counter, long useCount) const {
+		MemoryCounter::Scope scope(counter, this, sizeof(*this), useCount);
+		if (scope.first()) {
+			countMembers(counter);
+		}
+	}
+	void SceneObject::countMembers(MemoryCounter &counter) const {
+		counter.add(name);
+		counter.add(xforms);
+		details.countMemory(counter);
+	}
+	void PolygonMeshObject::countMemory(MemoryCounter &counter, long useCount) const {
+		MemoryCounter::Scope scope(counter, this, sizeof(*this), useCount);
+		if (scope.first()) {
+			countMembers(counter);
+			counter.add(faceCounts);
+			counter.add(indices);
+			counter.add(P);
+			points.countMemory(counter);
+			vertices.countMemory(counter);
+			primitives.countMemory(counter);
+		}
+	}
+	void PointObject::countMemory(MemoryCounter &counter, long useCount) const {
+		MemoryCounter::Scope scope(counter, this, sizeof(*this), useCount);
+		if (scope.first()) {
+			countMembers(counter);
+			counter.add(pointIds);
+			counter.add(P);
+			points.countMemory(counter);
+		}
+	}
+	void CurveObject::countMemory(MemoryCounter &counter, long useCount) const {
+		MemoryCounter::Scope scope(counter, this, sizeof(*this), useCount);
+		if (scope.first()) {
+			countMembers(counter);
+			counter.add(curvePrimitives);
+			counter.add(P);
+			points.countMemory(counter);
+			vertices.countMemory(counter);
+			primitives.countMemory(counter);
+		}
+	}
+	void CameraObject::countMemory(MemoryCounter &counter, long useCount) const {
+		MemoryCounter::Scope scope(counter, this, sizeof(*this), useCount);
+		if (scope.first()) {
+			countMembers(counter);
+		}
+	}
+
+	MemoryUsage AlembicScene::memoryUsage() const {
+		MemoryCounter counter;
+		counter.add(objects);
+		for (const SceneObjectPointer &object : objects) {
+			if (object.get()) {
+				object->countMemory(counter, object.pointer().use_count());
+			}
+		}
+		return counter.usage();
+	}
+
+	SceneArena::SceneArena(std::size_t blockSize) : _blockSize(blockSize) {
+	}
+	SceneArena::~SceneArena() {
+		while (_head) {
+			Block *next = _head->next;
+			::operator delete(_head);
+			_head = next;
+		}
+	}
+	void *SceneArena::allocate(std::size_t size, std::size_t alignment) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::size_t padding = (alignment - (std::uintptr_t)_cursor % alignment) % alignment;
+		if (_cursor == nullptr || (std::size_t)(_end - _cursor) < padding + size) {
+			// 足りなければ倍々で新しいブロックを確保する。古いブロックの残りは捨てる
+			std::size_t capacity = std::max(_blockSize, size + alignment);
+			Block *block = static_cast<Block *>(::operator new(sizeof(Block) + capacity));
+			block->next = _head;
+			block->size = capacity;
+			_head = block;
+			_cursor = reinterpret_cast<char *>(block + 1);
+			_end = _cursor + capacity;
+			_bytesReserved += sizeof(Block) + capacity;
+			_blockCount++;
+			_blockSize *= 2;
+			padding = (alignment - (std::uintptr_t)_cursor % alignment) % alignment;
+		}
+		void *p = _cursor + padding;
+		_cursor += padding + size;
+		_bytesUsed += size;
+		return p;
+	}
+
+	inline uint32_t frame_count_of(IObject top) {
+		auto prop = top.getProperties();
+		const char *kSample = "1.samples";
+		uint32_t frameCount = 1;
+		if (prop.getPropertyHeader(kSample)) {
+			IUInt32Property samples(prop, kSample);
+			samples.get(frameCount);
+		}
+		return frameCount;
 	}
 
 	bool AlembicStorage::open(const std::string &filePath, std::string &error_message) {
+		return open(std::vector<std::string>(1, filePath), error_message);
+	}
+	bool AlembicStorage::open(const std::vector<std::string> &layerPaths, std::string &error_message) {
+		TraceSpan span("AlembicStorage::open", layerPaths.empty() ? nullptr : &layerPaths[0]);
 		try {
 			_alembicArchive = std::shared_ptr<void>();
-			_alembicArchive = std::shared_ptr<void>(new IArchive(Alembic::AbcCoreOgawa::ReadArchive(), filePath), [](void *p) {
+			_plan = std::shared_ptr<void>();
+			_strings = std::shared_ptr<StringTable>(new StringTable());
+			if (layerPaths.empty()) {
+				error_message = "no layers to open";
+				return false;
+			}
+
+			auto deleter = [](void *p) {
 				IArchive *archive = static_cast<IArchive *>(p);
 				delete archive;
-			});
-
-			auto top = top_of_archive(_alembicArchive);
-			auto prop = top.getProperties();
-			const char *kSample = "1.samples";
-			if (prop.getPropertyHeader(kSample)) {
-				IUInt32Property samples(top.getProperties(), kSample);
-				samples.get(_frameCount);
+			};
+			Alembic::AbcCoreOgawa::ReadArchive reader(streamCount(), _memoryMapped);
+			std::shared_ptr<void> archive;
+			if (layerPaths.size() == 1) {
+				archive = std::shared_ptr<void>(new IArchive(reader, layerPaths[0]), deleter);
+				_frameCount = frame_count_of(top_of_archive(archive));
 			}
 			else {
-				_frameCount = 1;
+				// 先のレイヤーがプロパティ単位で上書きする。サンプルはそのプロパティを持つレイヤーからだけ読まれる
+				Alembic::AbcCoreLayer::ArchiveReaderPtrs layers;
+				uint32_t frameCount = 0;
+				for (const std::string &path : layerPaths) {
+					layers.push_back(reader(path));
+					frameCount = std::max(frameCount, frame_count_of(IArchive(layers.back(), kWrapExisting).getTop()));
+				}
+				archive = std::shared_ptr<void>(new IArchive(Alembic::AbcCoreLayer::ReadArchive()(layers), kWrapExisting), deleter);
+				_frameCount = frameCount;
 			}
+
+			// 階層はフレームによらないので、開いたときに一度だけたどる
+			std::shared_ptr<ScenePlan> plan(new ScenePlan());
+			build_plan(top_of_archive(archive), ScenePlan::kTopNode, 0, *plan);
+			_plan = plan;
+			_alembicArchive = archive;
 		}
 		catch (std::exception &e) {
 			error_message = e.what();
@@ -652,20 +2229,75 @@ namespace houdini_alembic {
 		}
 		return true;
 	}
+	uint32_t AlembicStorage::streamCount() const {
+		return _streamCount != 0 ? _streamCount : std::max(std::thread::hardware_concurrency(), 1u);
+	}
 	bool AlembicStorage::isOpened() const {
 		return (bool)_alembicArchive;
 	}
 	void AlembicStorage::close() {
 		_alembicArchive = std::shared_ptr<void>();
+		_plan = std::shared_ptr<void>();
+		_strings = std::shared_ptr<StringTable>();
 	}
 	std::shared_ptr<AlembicScene> AlembicStorage::read(uint32_t index, std::string &error_message) const {
-		if (!_alembicArchive) {
+		return read(index, error_message, std::shared_ptr<AlembicScene>());
+	}
+	/*
+	 What a read of AlembicStorage needs.
+	 read_async() keeps a copy, so that the read can finish after the storage is closed.
+	*/
+	struct StorageSnapshot {
+		std::shared_ptr<void> archive;
+		std::shared_ptr<void> plan;
+		std::shared_ptr<StringTable> strings;
+		float pointQuantization = 0.0f;
+		std::shared_ptr<TaskExecutor> executor;
+		std::shared_ptr<void> stats;
+	};
+
+	// null without error_message when cancelled
+	static std::shared_ptr<AlembicScene> read_scene(const StorageSnapshot &source, uint32_t index, std::string &error_message, std::shared_ptr<AlembicScene> recycled, const ReadCancellation *cancellation) {
+		if (!source.archive) {
 			return std::shared_ptr<AlembicScene>();
 		}
+		FrameTraceSpan span("AlembicStorage::read", index);
+		ReadStatsSink *stats = static_cast<ReadStatsSink *>(source.stats.get());
+		StatsScope scope(stats, nullptr, nullptr);
 		try {
 			ISampleSelector selector((index_t)index);
-			std::shared_ptr<AlembicScene> scene(new AlembicScene());
-			parse_object(top_of_archive(_alembicArchive), selector, scene->objects);
+
+			// シーンの中身は1つのアリーナにまとめ、解放は最後の参照が消えたときに一度だけ行う
+			SceneBuilder builder;
+			builder.arena = std::shared_ptr<SceneArena>(new SceneArena());
+			builder.strings = source.strings;
+			builder.pointQuantization = source.pointQuantization;
+			builder.executor = source.executor.get();
+			builder.cancellation = cancellation;
+			builder.stats = stats;
+
+			std::shared_ptr<AlembicScene> scene;
+			if (recycled && recycled.use_count() == 1) {
+				// 外から参照されているオブジェクトは書き換えない
+				scene = std::move(recycled);
+				builder.recycled.reserve(scene->objects.size());
+				for (const SceneObjectPointer &o : scene->objects) {
+					std::shared_ptr<SceneObject> object = o.pointer();
+					builder.recycled.emplace_back(object.use_count() == 2 ? object : std::shared_ptr<SceneObject>());
+				}
+				scene->objects.clear();
+			}
+			else {
+				scene = allocate_scene_object<AlembicScene>(builder.arena);
+			}
+			scene->arena = builder.arena;
+			parse_plan(top_of_archive(source.archive), *static_cast<const ScenePlan *>(source.plan.get()), selector, builder, scene->objects);
+			if (builder.cancelled()) {
+				return std::shared_ptr<AlembicScene>();
+			}
+			if (stats) {
+				stats->frames++;
+			}
 			return scene;
 		}
 		catch (std::exception &e) {
@@ -674,4 +2306,377 @@ namespace houdini_alembic {
 		}
 		return std::shared_ptr<AlembicScene>();
 	}
+
+	std::shared_ptr<AlembicScene> AlembicStorage::read(uint32_t index, std::string &error_message, std::shared_ptr<AlembicScene> recycled) const {
+		StorageSnapshot source;
+		source.archive = _alembicArchive;
+		source.plan = _plan;
+		source.strings = _strings;
+		source.pointQuantization = _pointQuantization;
+		source.executor = executor();
+		source.stats = _stats;
+		return read_scene(source, index, error_message, std::move(recycled), nullptr);
+	}
+	std::vector<std::shared_ptr<AlembicScene>> AlembicStorage::read_range(uint32_t begin, uint32_t end, std::string &error_message) const {
+		std::vector<std::shared_ptr<AlembicScene>> scenes;
+		if (!_alembicArchive || end <= begin) {
+			return scenes;
+		}
+		FrameTraceSpan span("AlembicStorage::read_range", begin);
+		ReadStatsSink *stats = static_cast<ReadStatsSink *>(_stats.get());
+		StatsScope scope(stats, nullptr, nullptr);
+		try {
+			SceneBuilder builder;
+			builder.strings = _strings;
+			builder.pointQuantization = _pointQuantization;
+			std::shared_ptr<TaskExecutor> executor = this->executor();
+			builder.executor = executor.get();
+			builder.stats = stats;
+
+			std::vector<ISampleSelector> selectors;
+			for (uint32_t index = begin; index < end; ++index) {
+				selectors.push_back(ISampleSelector((index_t)index));
+
+				std::shared_ptr<SceneArena> arena(new SceneArena());
+				std::shared_ptr<AlembicScene> scene = allocate_scene_object<AlembicScene>(arena);
+				scene->arena = arena;
+				scenes.push_back(scene);
+			}
+			parse_plan_range(top_of_archive(_alembicArchive), *static_cast<const ScenePlan *>(_plan.get()), selectors, builder, scenes);
+			if (stats) {
+				stats->frames += scenes.size();
+			}
+			return scenes;
+		}
+		catch (std::exception &e) {
+			error_message = e.what();
+			return std::vector<std::shared_ptr<AlembicScene>>();
+		}
+	}
+	void AlembicStorage::setStatsEnabled(bool enabled) {
+		if (enabled == statsEnabled()) {
+			return;
+		}
+		_stats = enabled ? std::shared_ptr<void>(new ReadStatsSink(), [](void *p) {
+			delete static_cast<ReadStatsSink *>(p);
+		}) : std::shared_ptr<void>();
+	}
+	ReadStats AlembicStorage::stats() const {
+		if (!_stats) {
+			return ReadStats();
+		}
+		return static_cast<const ReadStatsSink *>(_stats.get())->snapshot();
+	}
+	void AlembicStorage::resetStats() {
+		if (_stats) {
+			static_cast<ReadStatsSink *>(_stats.get())->reset();
+		}
+	}
+	std::future<std::shared_ptr<AlembicScene>> AlembicStorage::read_async(uint32_t index, std::shared_ptr<ReadCancellation> cancellation) const {
+		std::shared_ptr<std::promise<std::shared_ptr<AlembicScene>>> promise(new std::promise<std::shared_ptr<AlembicScene>>());
+		std::future<std::shared_ptr<AlembicScene>> future = promise->get_future();
+		read_async(index, [promise](std::shared_ptr<AlembicScene> scene, const std::string &error_message) {
+			if (scene || error_message.empty()) {
+				promise->set_value(scene);
+			}
+			else {
+				promise->set_exception(std::make_exception_ptr(std::runtime_error(error_message)));
+			}
+		}, cancellation);
+		return future;
+	}
+	void AlembicStorage::read_async(uint32_t index, ReadCompletion completion, std::shared_ptr<ReadCancellation> cancellation) const {
+		StorageSnapshot source;
+		source.archive = _alembicArchive;
+		source.plan = _plan;
+		source.strings = _strings;
+		source.pointQuantization = _pointQuantization;
+		source.executor = executor();
+		source.stats = _stats;
+		if (!source.archive) {
+			completion(std::shared_ptr<AlembicScene>(), "the storage is not opened");
+			return;
+		}
+
+		// 呼び出し元は待たない。executorのワーカーで読み、スレッドは増やさない
+		source.executor->submit([source, index, completion, cancellation]() {
+			std::string error_message;
+			std::shared_ptr<AlembicScene> scene;
+			if (!cancellation || !cancellation->isCancelled()) {
+				scene = read_scene(source, index, error_message, std::shared_ptr<AlembicScene>(), cancellation.get());
+			}
+			completion(scene, error_message);
+		});
+	}
+
+	/*
+	 Shared by AlembicSequenceStorage and the jobs reading ahead on its executor.
+	 A job holds the context only while it runs, and skips the read once the storage has been closed.
+	*/
+	class SequenceContext : public std::enable_shared_from_this<SequenceContext> {
+	public:
+		struct File {
+			std::shared_ptr<void> archive;
+			std::shared_ptr<const ScenePlan> plan;
+		};
+		struct Result {
+			std::shared_ptr<AlembicScene> scene;
+			std::string error_message;
+		};
+		struct Ahead {
+			std::shared_future<Result> result;
+
+			// the first of the job and read() to set it does the read
+			std::shared_ptr<std::atomic<bool>> claimed;
+		};
+
+		// the archive of the file, from the pool or newly opened
+		std::shared_ptr<File> acquire(uint32_t index) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				for (auto it = pool.begin(); it != pool.end(); ++it) {
+					if (it->first == index) {
+						pool.splice(pool.begin(), pool, it);
+						return it->second;
+					}
+				}
+			}
+
+			// 開くのと階層の照合はロックの外で、他のファイルと並列に行う
+			std::shared_ptr<File> file(new File());
+			file->archive = std::shared_ptr<void>(new IArchive(Alembic::AbcCoreOgawa::ReadArchive(), paths[index]), [](void *p) {
+				IArchive *archive = static_cast<IArchive *>(p);
+				delete archive;
+			});
+			IObject top = top_of_archive(file->archive);
+
+			// 直前に使った階層から照合する。連番ではたいてい最初の1つで一致する
+			std::vector<std::shared_ptr<const ScenePlan>> candidates;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				candidates = plans;
+			}
+			for (const auto &candidate : candidates) {
+				if (matches_plan(top, *candidate)) {
+					file->plan = candidate;
+					break;
+				}
+			}
+			if (!file->plan) {
+				std::shared_ptr<ScenePlan> built(new ScenePlan());
+				build_plan(top, ScenePlan::kTopNode, 0, *built);
+				file->plan = built;
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = std::find(plans.begin(), plans.end(), file->plan);
+				if (it == plans.end()) {
+					// 照合の後に他のスレッドが同じ階層を足していれば、そちらを使う
+					for (it = plans.begin(); it != plans.end(); ++it) {
+						if (std::find(candidates.begin(), candidates.end(), *it) == candidates.end() && matches_plan(top, **it)) {
+							file->plan = *it;
+							break;
+						}
+					}
+				}
+				if (it == plans.end()) {
+					plans.insert(plans.begin(), file->plan);
+				}
+				else {
+					std::rotate(plans.begin(), it, it + 1);
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			for (auto &opened : pool) {
+				// 他のスレッドが先に開いた
+				if (opened.first == index) {
+					return opened.second;
+				}
+			}
+			pool.emplace_front(index, file);
+			while (maxOpenArchives < pool.size()) {
+				pool.pop_back();
+			}
+			return file;
+		}
+
+		Result read(uint32_t index) {
+			Result result;
+			try {
+				std::shared_ptr<File> file = acquire(index);
+
+				SceneBuilder builder;
+				builder.arena = std::shared_ptr<SceneArena>(new SceneArena());
+				builder.strings = strings;
+				builder.pointQuantization = pointQuantization;
+				builder.executor = executor.get();
+
+				std::shared_ptr<AlembicScene> scene = allocate_scene_object<AlembicScene>(builder.arena);
+				scene->arena = builder.arena;
+				parse_plan(top_of_archive(file->archive), *file->plan, ISampleSelector((index_t)0), builder, scene->objects);
+				result.scene = scene;
+			}
+			catch (std::exception &e) {
+				result.error_message = e.what();
+			}
+			return result;
+		}
+
+		// the result of the read ahead, or of a read on this thread when the job has not started yet
+		Result take(uint32_t index) {
+			Ahead task;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = ahead.find(index);
+				if (it != ahead.end()) {
+					task = it->second;
+					ahead.erase(it);
+				}
+			}
+			if (task.claimed && task.claimed->exchange(true)) {
+				return task.result.get();
+			}
+			// 待つより自分で読むほうが早く、ワーカーが埋まっていても詰まらない
+			return read(index);
+		}
+
+		// 次のファイルを executor のジョブとして開いて読んでおく
+		void readAhead(uint32_t index) {
+			if (executor->workerCount() == 0) {
+				return;
+			}
+			std::weak_ptr<SequenceContext> weak = shared_from_this();
+			std::lock_guard<std::mutex> lock(mutex);
+
+			// 範囲外になったものは捨てる。まだ始まっていないジョブは読まずに終わる
+			for (auto it = ahead.begin(); it != ahead.end();) {
+				bool inWindow = index < it->first && it->first <= index + readAheadCount;
+				if (!inWindow) {
+					it->second.claimed->store(true);
+					it = ahead.erase(it);
+				}
+				else {
+					++it;
+				}
+			}
+			for (uint32_t i = index + 1; i <= index + readAheadCount && i < paths.size(); ++i) {
+				if (ahead.count(i) != 0) {
+					continue;
+				}
+				std::shared_ptr<std::promise<Result>> promise(new std::promise<Result>());
+				Ahead task;
+				task.result = promise->get_future().share();
+				task.claimed = std::shared_ptr<std::atomic<bool>>(new std::atomic<bool>(false));
+				ahead[i] = task;
+
+				std::shared_ptr<std::atomic<bool>> claimed = task.claimed;
+				executor->submit([weak, i, promise, claimed]() {
+					Result result;
+					if (!claimed->exchange(true)) {
+						if (std::shared_ptr<SequenceContext> context = weak.lock()) {
+							result = context->read(i);
+						}
+					}
+					promise->set_value(result);
+				});
+			}
+		}
+
+		std::vector<std::string> paths;
+		uint32_t maxOpenArchives = 8;
+		uint32_t readAheadCount = 2;
+		float pointQuantization = 0.0f;
+		std::shared_ptr<StringTable> strings;
+		std::shared_ptr<TaskExecutor> executor;
+
+		std::mutex mutex;
+
+		// most recently used first
+		std::list<std::pair<uint32_t, std::shared_ptr<File>>> pool;
+		std::vector<std::shared_ptr<const ScenePlan>> plans;
+		std::map<uint32_t, Ahead> ahead;
+	};
+
+	inline std::string expand_frame(const std::string &pattern, int frame) {
+		std::string::size_type at = pattern.find("$F");
+		std::string::size_type end = at + 2;
+		int padding = 0;
+		if (end < pattern.size() && '1' <= pattern[end] && pattern[end] <= '9') {
+			padding = pattern[end] - '0';
+			end++;
+		}
+		char number[32];
+		snprintf(number, sizeof(number), "%0*d", padding, frame);
+		return pattern.substr(0, at) + number + pattern.substr(end);
+	}
+
+	bool AlembicSequenceStorage::open(const std::string &pattern, int firstFrame, int lastFrame, std::string &error_message) {
+		if (pattern.find("$F") == std::string::npos) {
+			close();
+			error_message = "the pattern has no $F";
+			return false;
+		}
+		std::vector<std::string> framePaths;
+		for (int frame = firstFrame; frame <= lastFrame; ++frame) {
+			framePaths.push_back(expand_frame(pattern, frame));
+		}
+		return open(framePaths, error_message);
+	}
+	bool AlembicSequenceStorage::open(const std::vector<std::string> &framePaths, std::string &error_message) {
+		close();
+		if (framePaths.empty()) {
+			error_message = "no frames to open";
+			return false;
+		}
+
+		std::shared_ptr<SequenceContext> context(new SequenceContext());
+		context->paths = framePaths;
+		context->maxOpenArchives = std::max(_maxOpenArchives, 1u);
+		context->readAheadCount = std::min(_readAhead, context->maxOpenArchives);
+		context->pointQuantization = _pointQuantization;
+		context->strings = std::shared_ptr<StringTable>(new StringTable());
+		context->executor = executor();
+		try {
+			// 少なくとも最初のファイルは開けることを確かめる
+			context->acquire(0);
+		}
+		catch (std::exception &e) {
+			error_message = e.what();
+			return false;
+		}
+		_context = context;
+		_frameCount = (uint32_t)framePaths.size();
+		return true;
+	}
+	bool AlembicSequenceStorage::isOpened() const {
+		return (bool)_context;
+	}
+	void AlembicSequenceStorage::close() {
+		_context = std::shared_ptr<void>();
+		_frameCount = 0;
+	}
+	std::shared_ptr<AlembicScene> AlembicSequenceStorage::read(uint32_t index, std::string &error_message) const {
+		SequenceContext *context = static_cast<SequenceContext *>(_context.get());
+		if (context == nullptr || _frameCount <= index) {
+			return std::shared_ptr<AlembicScene>();
+		}
+		FrameTraceSpan span("AlembicSequenceStorage::read", index);
+
+		SequenceContext::Result result = context->take(index);
+		context->readAhead(index);
+
+		if (!result.scene) {
+			error_message = result.error_message;
+		}
+		return result.scene;
+	}
+	uint32_t AlembicSequenceStorage::planCount() const {
+		SequenceContext *context = static_cast<SequenceContext *>(_context.get());
+		if (context == nullptr) {
+			return 0;
+		}
+		std::lock_guard<std::mutex> lock(context->mutex);
+		return (uint32_t)context->plans.size();
+	}
 }
\ No newline at end of file
@@ -6,6 +6,11 @@
 #include <map>
 #include <sstream>
 #include <functional>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <unordered_map>
 
 namespace houdini_alembic {
 	//class Vector2f : public IStringConvertible {
@@ -85,6 +90,121 @@ namespace houdini_alembic {
 		return types[type];
 	}
 
+	/*
+	 The type the values of an attribute are stored with. Same order as Alembic::Util::PlainOldDataType
+	*/
+	enum AttributeStorageType {
+		AttributeStorageType_Bool = 0,
+		AttributeStorageType_UInt8,
+		AttributeStorageType_Int8,
+		AttributeStorageType_UInt16,
+		AttributeStorageType_Int16,
+		AttributeStorageType_UInt32,
+		AttributeStorageType_Int32,
+		AttributeStorageType_UInt64,
+		AttributeStorageType_Int64,
+		AttributeStorageType_Float16,
+		AttributeStorageType_Float32,
+		AttributeStorageType_Float64,
+		AttributeStorageType_String,
+	};
+	inline const char *attributeStorageTypeString(AttributeStorageType type) {
+		static const char *types[] = {
+			"Bool",
+			"UInt8",
+			"Int8",
+			"UInt16",
+			"Int16",
+			"UInt32",
+			"Int32",
+			"UInt64",
+			"Int64",
+			"Float16",
+			"Float32",
+			"Float64",
+			"String",
+		};
+		return types[type];
+	}
+
+	/*
+	 Heap memory held by a scene, an object or a column.
+	 owned bytes are released with it. shared bytes are also referred to from elsewhere: columns other frames reuse, the StringTable of the storage, a mapped scene cache.
+	 A buffer referred to from several places is counted once.
+	*/
+	struct MemoryUsage {
+		uint64_t ownedBytes = 0;
+		uint64_t sharedBytes = 0;
+		uint32_t buffers = 0;
+
+		uint64_t totalBytes() const {
+			return ownedBytes + sharedBytes;
+		}
+	};
+
+	/*
+	 Collects the buffers reachable from one scene, object or column.
+	 Every buffer is keyed by its address and added with the number of references to it, use_count() of the shared_ptr holding it or 1 for a member.
+	 It is owned if all its references were reached, and the objects it was reached through are owned too.
+	*/
+	class MemoryCounter {
+	public:
+		void add(const void *buffer, uint64_t bytes, long useCount = 1);
+
+		template <class T>
+		void add(const std::vector<T> &values) {
+			if (values.capacity()) {
+				add(values.data(), values.capacity() * sizeof(T));
+			}
+		}
+		// only the characters outside the small string buffer
+		void add(const std::string &value) {
+			if (uint64_t bytes = heapBytes(value)) {
+				add(value.data(), bytes);
+			}
+		}
+		static uint64_t heapBytes(const std::string &value);
+
+		/*
+		 Buffers added until leave() belong to owner, and are shared if it is.
+		 false if owner was entered before, its buffers are counted already.
+		*/
+		bool enter(const void *owner, uint64_t bytes, long useCount);
+		void leave();
+
+		MemoryUsage usage() const;
+
+		class Scope {
+		public:
+			Scope(MemoryCounter &counter, const void *owner, uint64_t bytes, long useCount) : _counter(counter) {
+				_first = counter.enter(owner, bytes, useCount);
+			}
+			~Scope() {
+				_counter.leave();
+			}
+			Scope(const Scope &) = delete;
+			void operator=(const Scope &) = delete;
+
+			bool first() const {
+				return _first;
+			}
+		private:
+			MemoryCounter &_counter;
+			bool _first = false;
+		};
+	private:
+		struct Buffer {
+			uint64_t bytes = 0;
+			long useCount = 1;
+			long references = 0;
+			std::vector<const void *> owners;
+		};
+		bool owned(const void *buffer, std::unordered_map<const void *, bool> &resolved) const;
+
+		std::unordered_map<const void *, Buffer> _buffers;
+		std::vector<const void *> _owners;
+	};
+
 	class AttributeColumn {
 	public:
 		AttributeColumn() {}
@@ -96,25 +216,72 @@ namespace houdini_alembic {
 		virtual uint32_t rowCount() const = 0;
 
 		virtual int snprint(uint32_t index, char *buffer, uint32_t buffersize) const = 0;
+
+		/*
+		 The values are kept in the type they are stored with, e.g. a half Cd stays half.
+		 get() converts a row to the type of the column.
+		*/
+		virtual AttributeStorageType storageType() const = 0;
+
+		// values per row
+		virtual uint32_t componentCount() const = 0;
+
+		/*
+		 rowCount() * componentCount() values of storageType(), or null if the rows are indexed or broadcast.
+		 null for strings.
+		*/
+		virtual const void *storage() const {
+			return nullptr;
+		}
+
+		/*
+		 true if the column stores a single row that every index returns, e.g. a detail value Houdini promoted to points.
+		 rowCount() is still the full count.
+		*/
+		virtual bool isBroadcast() const {
+			return false;
+		}
+
+		MemoryUsage memoryUsage() const;
+
+		/*
+		 Adds the column and its buffers. useCount is the number of references to the column, e.g. use_count() of the shared_ptr it was reached through.
+		*/
+		virtual void countMemory(MemoryCounter &counter, long useCount) const;
 	};
 
 	class AttributeFloatColumn : public AttributeColumn {
 	public:
+		static AttributeType staticAttributeType() {
+			return AttributeType_Float;
+		}
 		AttributeType attributeType() const override {
 			return AttributeType_Float;
 		}
 		virtual float get(uint32_t index) const = 0;
+
+		// without narrowing a Float64 attribute
+		virtual void get(uint32_t index, double *x) const = 0;
 	};
 	class AttributeIntColumn : public AttributeColumn {
 	public:
+		static AttributeType staticAttributeType() {
+			return AttributeType_Int;
+		}
 		AttributeType attributeType() const override {
 			return AttributeType_Int;
 		}
 		virtual int32_t get(uint32_t index) const = 0;
+
+		// without narrowing an Int64 or UInt32 attribute
+		virtual void get(uint32_t index, int64_t *x) const = 0;
 	};
 
 	class AttributeVector2Column : public AttributeColumn {
 	public:
+		static AttributeType staticAttributeType() {
+			return AttributeType_Vector2;
+		}
 		AttributeType attributeType() const override {
 			return AttributeType_Vector2;
 		}
@@ -123,14 +290,27 @@ namespace houdini_alembic {
 	};
 	class AttributeVector3Column : public AttributeColumn {
 	public:
+		static AttributeType staticAttributeType() {
+			return AttributeType_Vector3;
+		}
 		AttributeType attributeType() const override {
 			return AttributeType_Vector3;
 		}
 		virtual void get(uint32_t index, float *xyz) const = 0;
 		virtual void get(uint32_t index, double *xyz) const = 0;
+
+		// rows [begin, begin + count) to xyz, 3 floats per row
+		virtual void getRows(uint32_t begin, uint32_t count, float *xyz) const {
+			for (uint32_t i = 0; i < count; ++i) {
+				get(begin + i, xyz + i * 3);
+			}
+		}
 	};
 	class AttributeVector4Column : public AttributeColumn {
 	public:
+		static AttributeType staticAttributeType() {
+			return AttributeType_Vector4;
+		}
 		AttributeType attributeType() const override {
 			return AttributeType_Vector4;
 		}
@@ -138,12 +318,95 @@ namespace houdini_alembic {
 		virtual void get(uint32_t index, double *xyzw) const = 0;
 	};
 
+	/*
+	 Deduplicated strings of the string attributes read from one storage.
+	 A string keeps its id in every frame, so rows can be grouped and compared by id instead of by string.
+	 Thread safe.
+	*/
+	class StringTable {
+	public:
+		StringTable() {}
+		StringTable(const StringTable &) = delete;
+		void operator=(const StringTable &) = delete;
+
+		uint32_t intern(const std::string &value);
+		void intern(const std::string *values, uint32_t count, uint32_t *ids);
+
+		// the reference is valid as long as the table
+		const std::string &string(uint32_t id) const;
+		uint32_t size() const;
+
+		// the strings and an estimate of the hash map
+		uint64_t memoryBytes() const;
+	private:
+		mutable std::mutex _mutex;
+		std::deque<std::string> _strings;
+		std::unordered_map<std::string, uint32_t> _ids;
+	};
+
 	class AttributeStringColumn : public AttributeColumn {
 	public:
+		static AttributeType staticAttributeType() {
+			return AttributeType_String;
+		}
 		AttributeType attributeType() const override {
 			return AttributeType_String;
 		}
+		AttributeStorageType storageType() const override {
+			return AttributeStorageType_String;
+		}
+		uint32_t componentCount() const override {
+			return 1;
+		}
 		virtual const std::string &get(uint32_t index) const = 0;
+
+		/*
+		 id of the row in stringTable()
+		 stringTable().string(id(index)) == get(index)
+		*/
+		virtual uint32_t id(uint32_t index) const = 0;
+		virtual const StringTable &stringTable() const = 0;
+	};
+
+	/*
+	 An attribute key resolved to an integer once, e.g. as a static of a render kernel.
+	 Ids are process wide, so one handle works for the spreadsheets of every storage and every frame.
+	*/
+	class AttributeHandle {
+	public:
+		enum : uint32_t {
+			kInvalidId = 0xFFFFFFFF
+		};
+		AttributeHandle() {}
+		explicit AttributeHandle(const std::string &key);
+
+		uint32_t id() const {
+			return _id;
+		}
+		bool isValid() const {
+			return _id != kInvalidId;
+		}
+		const std::string &key() const;
+
+		// the number of ids handed out so far
+		static uint32_t resolvedCount();
+
+		// ids of key as known so far, kInvalidId for those no handle was made for
+		static void find(const std::string &key, AttributeType attributeType, uint32_t *untypedId, uint32_t *typedId);
+	protected:
+		AttributeHandle(const std::string &key, AttributeType attributeType);
+
+		uint32_t _id = kInvalidId;
+	};
+
+	/*
+	 A handle that only finds a column of Column's type. The type is part of the id, so the lookup does not check it at run time.
+	*/
+	template <class Column>
+	class TypedAttributeHandle : public AttributeHandle {
+	public:
+		TypedAttributeHandle() {}
+		explicit TypedAttributeHandle(const std::string &key) : AttributeHandle(key, Column::staticAttributeType()) {}
 	};
 
 	class AttributeSpreadSheet {
@@ -198,9 +461,26 @@ namespace houdini_alembic {
 			return it->column.get();
 		}
 
+		/*
+		 O(1) once the sheet is indexed. Otherwise, or for a handle made after index(), it falls back to the key.
+		*/
+		const AttributeColumn *column(const AttributeHandle &handle) const {
+			if (handle.id() < _indexedIds) {
+				return handle.id() < _slots.size() && _slots[handle.id()] ? sheet[_slots[handle.id()] - 1].column.get() : nullptr;
+			}
+			return handle.isValid() ? column(handle.key().c_str()) : nullptr;
+		}
+		template <class Column>
+		const Column *column(const TypedAttributeHandle<Column> &handle) const {
+			if (handle.id() < _indexedIds) {
+				return static_cast<const Column *>(column(static_cast<const AttributeHandle &>(handle)));
+			}
+			return handle.isValid() ? column_as<Column>(handle.key().c_str(), Column::staticAttributeType()) : nullptr;
+		}
+
 		struct Attribute {
 			Attribute() {}
-			Attribute(std::string k, std::shared_ptr<AttributeColumn> c) : key(k), column(c) {}
+			Attribute(std::string k, std::shared_ptr<AttributeColumn> c) : key(std::move(k)), column(std::move(c)) {}
 			std::string key;
 			std::shared_ptr<AttributeColumn> column;
 
@@ -212,6 +492,23 @@ namespace houdini_alembic {
 			}
 		};
 		std::vector<Attribute> sheet;
+
+		/*
+		 Maps the ids of the handles to the columns. The readers index the sheets they make, call it again after changing sheet.
+		*/
+		void index();
+		void clear() {
+			sheet.clear();
+			_slots.clear();
+			_indexedIds = 0;
+		}
+
+		// the sheet, the keys and the columns, as buffers of the object being counted
+		void countMemory(MemoryCounter &counter) const;
+	private:
+		// index + 1 in sheet by handle id, 0 if there is no such column. Handles with ids from _indexedIds on are newer than the index
+		std::vector<uint32_t> _slots;
+		uint32_t _indexedIds = 0;
 	};
 
 	enum SceneObjectType {
@@ -242,6 +539,20 @@ namespace houdini_alembic {
 		 combinedXforms == xforms[0] * xforms[1] * xforms[2]
 		*/
 		std::vector<Matrix4x4f> xforms;
+
+		/*
+		 detail attributes (geoScope "con"), one row each
+		*/
+		AttributeSpreadSheet details;
+
+		MemoryUsage memoryUsage() const;
+
+		/*
+		 Adds the object and everything it holds. useCount is the number of references to the object.
+		*/
+		virtual void countMemory(MemoryCounter &counter, long useCount) const;
+	protected:
+		void countMembers(MemoryCounter &counter) const;
 	};
 	class PolygonMeshObject : public SceneObject {
 	public:
@@ -256,6 +567,8 @@ namespace houdini_alembic {
 		AttributeSpreadSheet points;
 		AttributeSpreadSheet vertices;
 		AttributeSpreadSheet primitives;
+
+		void countMemory(MemoryCounter &counter, long useCount) const override;
 	};
 	class PointObject : public SceneObject {
 	public:
@@ -267,6 +580,8 @@ namespace houdini_alembic {
 		std::vector<Vector3f> P;
 
 		AttributeSpreadSheet points;
+
+		void countMemory(MemoryCounter &counter, long useCount) const override;
 	};
 
 	class CurveObject : public SceneObject {
@@ -285,6 +600,8 @@ namespace houdini_alembic {
 		AttributeSpreadSheet points;
 		AttributeSpreadSheet vertices;
 		AttributeSpreadSheet primitives;
+
+		void countMemory(MemoryCounter &counter, long useCount) const override;
 	};
 	
 	/*
@@ -330,6 +647,8 @@ namespace houdini_alembic {
 		float lensRadius = 0.0f; /* fov (in meter) */
 		float objectPlaneWidth = 0.0f;  /* object plane width  (in meter) */
 		float objectPlaneHeight = 0.0f; /* object plane height (in meter) */
+
+		void countMemory(MemoryCounter &counter, long useCount) const override;
 	};
 
 	class SceneObjectPointer {
@@ -355,10 +674,92 @@ namespace houdini_alembic {
 		SceneObject *get() const {
 			return _pointer.get();
 		}
+		const std::shared_ptr<SceneObject> &pointer() const {
+			return _pointer;
+		}
 	private:
 		std::shared_ptr<SceneObject> _pointer;
 	};
 
+	/*
+	 Monotonic memory for the objects and attribute columns of one scene.
+	 Memory is only given back when the arena itself is destroyed, which happens when the last object allocated from it is released.
+	 allocate() takes a lock, so the objects of one scene can be parsed in parallel.
+	*/
+	class SceneArena {
+	public:
+		SceneArena(std::size_t blockSize = 4096);
+		SceneArena(const SceneArena &) = delete;
+		void operator=(const SceneArena &) = delete;
+		~SceneArena();
+
+		void *allocate(std::size_t size, std::size_t alignment);
+
+		// bytes handed out by allocate()
+		std::size_t bytesUsed() const {
+			return _bytesUsed;
+		}
+		// bytes taken from the heap, including the unused tails of the blocks
+		std::size_t bytesReserved() const {
+			return _bytesReserved;
+		}
+		uint32_t blockCount() const {
+			return _blockCount;
+		}
+	private:
+		struct Block {
+			Block *next;
+			std::size_t size;
+		};
+		std::mutex _mutex;
+		Block *_head = nullptr;
+		char *_cursor = nullptr;
+		char *_end = nullptr;
+		std::size_t _blockSize = 0;
+		std::size_t _bytesUsed = 0;
+		std::size_t _bytesReserved = 0;
+		uint32_t _blockCount = 0;
+	};
+
+	/*
+	 Allocator for std::allocate_shared. Every control block keeps the arena alive.
+	*/
+	template <class T>
+	class SceneArenaAllocator {
+	public:
+		typedef T value_type;
+
+		SceneArenaAllocator(std::shared_ptr<SceneArena> arena) : _arena(std::move(arena)) {}
+		template <class U>
+		SceneArenaAllocator(const SceneArenaAllocator<U> &rhs) : _arena(rhs._arena) {}
+
+		T *allocate(std::size_t n) {
+			return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+		}
+		void deallocate(T *, std::size_t) {
+		}
+
+		template <class U>
+		bool operator==(const SceneArenaAllocator<U> &rhs) const {
+			return _arena == rhs._arena;
+		}
+		template <class U>
+		bool operator!=(const SceneArenaAllocator<U> &rhs) const {
+			return _arena != rhs._arena;
+		}
+
+		std::shared_ptr<SceneArena> _arena;
+	};
+
+	// falls back to the heap when arena is null
+	template <class T>
+	std::shared_ptr<T> allocate_scene_object(const std::shared_ptr<SceneArena> &arena) {
+		if (arena) {
+			return std::allocate_shared<T>(SceneArenaAllocator<T>(arena));
+		}
+		return std::make_shared<T>();
+	}
+
 	class AlembicScene {
 	public:
 		PolygonMeshObject *polygonMesh_FirstVisible() const {
@@ -386,6 +787,17 @@ namespace houdini_alembic {
 			return allVisible<CameraObject>();
 		}
 		std::vector<SceneObjectPointer> objects;
+
+		/*
+		 The arena the objects and their attribute columns were allocated from. null for scenes built by hand.
+		*/
+		std::shared_ptr<SceneArena> arena;
+
+		/*
+		 The objects, their columns and buffers. Objects and columns reused by other frames count as shared.
+		 Counted by the size of what they hold, the unused tail of the arena is not included.
+		*/
+		MemoryUsage memoryUsage() const;
 	private:
 		template <class T>
 		T *firstVisible() const {
@@ -414,20 +826,558 @@ namespace houdini_alembic {
 		}
 	};
 
+	/*
+	 A work stealing thread pool for everything that runs in parallel:
+	 the objects and attribute columns parsed by AlembicStorage::read(), the conversion kernels of Alembic and the attribute conversion of AlembicWriter.
+
+	 Every worker owns a deque. Tasks submitted from a worker are pushed to and popped from the back of its own deque,
+	 and an idle worker steals from the front of the others. A thread waiting in parallelFor() runs tasks instead of blocking,
+	 so tasks may run nested parallelFor()s, and threads outside the pool may use it as well.
+	*/
+	class TaskExecutor {
+	public:
+		/*
+		 workerCount: threads owned by the pool. 0 runs everything on the calling threads.
+		 pinWorkers: binds worker i to logical processor i + 1, leaving processor 0 to the thread that drives the pool.
+		*/
+		explicit TaskExecutor(uint32_t workerCount = defaultWorkerCount(), bool pinWorkers = false);
+		TaskExecutor(const TaskExecutor &) = delete;
+		void operator=(const TaskExecutor &) = delete;
+		~TaskExecutor();
+
+		// hardware threads - 1, the calling thread works as well
+		static uint32_t defaultWorkerCount();
+
+		uint32_t workerCount() const;
+
+		/*
+		 Runs body(i) for every i in [0, count), and returns when all of them are done.
+		 The range is split into a few tasks per thread. The first exception thrown by body is rethrown here.
+		*/
+		void parallelFor(uint32_t count, const std::function<void(uint32_t)> &body);
+
+		/*
+		 Queues job to run on a worker and returns at once. Jobs start in the order they are submitted, when no parallelFor task is waiting.
+		 TaskExecutor(0) runs it on the calling thread before returning. An exception thrown by job is dropped.
+		 The pool finishes the queued jobs before it is destroyed, and a job may hold the last reference to the executor.
+		*/
+		void submit(std::function<void()> job);
+
+		struct WorkerStats {
+			uint64_t executed = 0;       // tasks run
+			uint64_t stolen = 0;         // tasks taken from the deque of another worker
+			uint64_t busyNanoseconds = 0;
+		};
+
+		// one entry per worker, followed by one for all the threads outside the pool
+		std::vector<WorkerStats> stats() const;
+		void resetStats();
+
+		/*
+		 The executor used when none is given, created on first use.
+		 Alembic runs the chunks of its conversion kernels and chunked sample keys on it (Util::SetParallelFor), it starts no threads of its own.
+		*/
+		static std::shared_ptr<TaskExecutor> shared();
+	private:
+		std::shared_ptr<void> _context;
+	};
+
+	enum TriangulationMethod {
+		TriangulationMethod_Fan,     // (0, i, i + 1) for every face, enough for convex faces
+		TriangulationMethod_EarClip, // concave faces too, clipped in the plane of the face
+	};
+
+	/*
+	 The triangles of a PolygonMeshObject, in the winding order of its faces.
+	 The corners of triangle t are 3 * t, 3 * t + 1 and 3 * t + 2 of vertices and indices.
+	*/
+	struct Triangulation {
+		std::vector<uint32_t> faceOffsets;     // first face vertex of every face, followed by the number of face vertices
+		std::vector<uint32_t> triangleOffsets; // first triangle of every face, followed by the number of triangles
+		std::vector<uint32_t> vertices;        // rows of the vertices sheet
+		std::vector<uint32_t> indices;         // rows of P and the points sheet
+		std::vector<uint32_t> triangleFaces;   // the face of every triangle, rows of the primitives sheet
+
+		uint32_t triangleCount() const {
+			return (uint32_t)triangleFaces.size();
+		}
+	};
+
+	/*
+	 The offsets of the faces are a parallel prefix sum over faceCounts, then the faces are triangulated in parallel.
+	 Faces with less than 3 vertices have no triangles.
+	 null if faceCounts and indices do not match. executor null for TaskExecutor::shared().
+	*/
+	std::shared_ptr<Triangulation> triangulate(const PolygonMeshObject &polymesh, TriangulationMethod method, std::string &error_message, TaskExecutor *executor = nullptr);
+
+	/*
+	 Triangulations by object name, reused while faceCounts and indices stay the same, e.g. in every frame of a deforming mesh.
+	 Ear clipping keeps the triangles of the frame it ran on, so they do not flip while the points move.
+	 Thread safe.
+	*/
+	class TriangulationCache {
+	public:
+		explicit TriangulationCache(TriangulationMethod method = TriangulationMethod_EarClip, std::shared_ptr<TaskExecutor> executor = std::shared_ptr<TaskExecutor>());
+
+		std::shared_ptr<const Triangulation> triangulate(const PolygonMeshObject &polymesh, std::string &error_message);
+		void clear();
+
+		uint32_t hits() const;
+		uint32_t misses() const;
+	private:
+		std::shared_ptr<void> _context;
+	};
+
+	/*
+	 Cancels the asynchronous reads it is given to.
+	 A read checks it before every object, so the object being parsed is finished but the rest of the frame is abandoned.
+	*/
+	class ReadCancellation {
+	public:
+		void cancel() {
+			_cancelled = true;
+		}
+		bool isCancelled() const {
+			return _cancelled;
+		}
+	private:
+		std::atomic<bool> _cancelled{ false };
+	};
+
+	/*
+	 Records spans of the loader from every thread and writes them as Chrome trace event JSON, which chrome://tracing and Perfetto open.
+	 Spans cover AlembicStorage::open and the reads of frames, every object (parse_leaf), the parse_* functions, the array samples
+	 the loader reads (ReadArraySample) and below them Alembic's stream reads and POD conversions.
+	 Recording is process wide and off by default. While it is off a span costs one atomic load.
+	*/
+	class LoaderTrace {
+	public:
+		/*
+		 ringSeconds == 0 keeps every span until clear().
+		 Otherwise only the spans that ended within the last ringSeconds are kept, so recording can stay on in production.
+		*/
+		static void start(double ringSeconds = 0.0);
+		static void stop();
+		static bool isRecording();
+		static void clear();
+
+		// the spans kept so far
+		static bool write(const std::string &filePath, std::string &error_message);
+
+		/*
+		 While recording, a frame read (AlembicStorage::read, read_range, AlembicSequenceStorage::read) that takes longer than thresholdSeconds
+		 has the kept spans written to pathPrefix + "<n>.json", n counting from 0. thresholdSeconds == 0 disables it (default).
+		 The dump is written by a thread of the trace, not the reading one. While a dump waits for it, slower frames are left to that dump.
+		 callback is called on that thread after every dump, error_message is empty when it was written.
+		*/
+		typedef std::function<void(const std::string &path, const std::string &error_message)> SlowFrameDumpCallback;
+		static void setSlowFrameDump(double thresholdSeconds, const std::string &pathPrefix, SlowFrameDumpCallback callback = SlowFrameDumpCallback());
+
+		// the dumps requested so far
+		static uint32_t slowFrameDumpCount();
+
+		// waits until the requested dumps are written
+		static void flushSlowFrameDumps();
+	};
+
+	/*
+	 One span on the calling thread, from construction to destruction, for marking frames of an application among the spans of the loader.
+	 name must outlive the recording (a literal), label is copied only while recording.
+	*/
+	class TraceSpan {
+	public:
+		TraceSpan(const char *name, const std::string *label = nullptr);
+		TraceSpan(const TraceSpan &) = delete;
+		void operator=(const TraceSpan &) = delete;
+		~TraceSpan();
+
+		// nanoseconds since the span began, 0 while not recording
+		uint64_t elapsedNanoseconds() const;
+	private:
+		const char *_name;
+		std::string _label;
+		uint64_t _begin = 0;
+		bool _active = false;
+	};
+
+	/*
+	 Where the bytes and the time of the reads of an AlembicStorage went, see AlembicStorage::setStatsEnabled().
+	 Times are summed over the threads that did the work, so for parallel reads they can exceed the wall clock.
+	 parseAttributesNanoseconds includes the I/O and the conversions it caused.
+	*/
+	struct ReadStats {
+		enum {
+			kReadSizeBuckets = 8
+		};
+		// upper bound (exclusive) of readSizeHistogram[bucket], the last bucket has none
+		static uint64_t readSizeLimit(uint32_t bucket) {
+			return 256ull << (2 * bucket);
+		}
+
+		uint64_t frames = 0;
+		uint64_t bytesRead = 0; // by Ogawa::IStreams::read, whether memory mapped or not
+		uint64_t readCalls = 0;
+		std::array<uint64_t, kReadSizeBuckets> readSizeHistogram = {};
+		uint64_t ioNanoseconds = 0;
+		uint64_t bytesConverted = 0; // POD conversions done by Alembic while reading
+		uint64_t convertNanoseconds = 0;
+		uint64_t parseAttributesNanoseconds = 0;
+		uint64_t extractPNanoseconds = 0; // copying P out of its column, or quantizing it
+
+		// objects refilled by read(index, error_message, recycled), and those allocated
+		uint64_t recycledObjects = 0;
+		uint64_t allocatedObjects = 0;
+		// columns read_range() shared with the frame before, and those read
+		uint64_t sharedColumns = 0;
+		uint64_t parsedColumns = 0;
+
+		// bytes read by the name of the object, and by the name of the object + "/" + the key of the attribute
+		std::map<std::string, uint64_t> objectBytes;
+		std::map<std::string, uint64_t> attributeBytes;
+
+		double recycleHitRate() const {
+			uint64_t total = recycledObjects + allocatedObjects;
+			return total ? (double)recycledObjects / total : 0.0;
+		}
+		double columnShareRate() const {
+			uint64_t total = sharedColumns + parsedColumns;
+			return total ? (double)sharedColumns / total : 0.0;
+		}
+	};
+
+	/*
+	 read() may be called from several threads at once for any frames, open() and close() may not.
+	 Each read() has its own arena and builder and only the string table is shared, under its lock.
+	*/
 	class AlembicStorage {
 	public:
 		bool open(const std::string &filePath, std::string &error_message);
+
+		/*
+		 Opens a stack of archives composed with AbcCoreLayer, e.g. a cache and a small file of lookdev overrides.
+		 As in AbcCoreLayer the first path is the strongest: it overrides the following layers property by property,
+		 and prune/replace metadata (AbcCoreLayer::SetPrune, SetReplace) is honored.
+		 Samples are only read from the layer that provides the property, so a layer costs I/O only for what it overrides.
+		 frameCount() is that of the longest layer.
+		*/
+		bool open(const std::vector<std::string> &layerPaths, std::string &error_message);
 		bool isOpened() const;
 		void close();
 
 		// return null if failed to sample.
 		std::shared_ptr<AlembicScene> read(uint32_t index, std::string &error_message) const;
 
+		/*
+		 Same as read(), but refills a scene returned by a previous read() in place, so that the vectors of its objects keep their capacity.
+		 The scene is only reused when the caller has given up every other reference to it,
+		 and an object only when it is at the same position with the same type and nobody else refers to it.
+
+		 ex)
+		 scene = storage.read(i, error_message, std::move(scene));
+		*/
+		std::shared_ptr<AlembicScene> read(uint32_t index, std::string &error_message, std::shared_ptr<AlembicScene> recycled) const;
+
+		/*
+		 Reads as a job of executor() and returns at once, so at most the workers of the executor read at the same time.
+		 The read keeps what it needs, the executor included, so the storage may be closed meanwhile. TaskExecutor(0) reads before returning.
+		 The future gives null when the read was cancelled, and throws std::runtime_error with the error message when it failed.
+
+		 ex)
+		 cancellation->cancel();
+		 cancellation = std::make_shared<ReadCancellation>();
+		 pending = storage.read_async(frame, cancellation);
+		*/
+		std::future<std::shared_ptr<AlembicScene>> read_async(uint32_t index, std::shared_ptr<ReadCancellation> cancellation = std::shared_ptr<ReadCancellation>()) const;
+
+		/*
+		 Same as above, but calls completion on the worker that read when done.
+		 scene is null when the read failed or was cancelled, error_message is empty when it was cancelled.
+		*/
+		typedef std::function<void(std::shared_ptr<AlembicScene> scene, const std::string &error_message)> ReadCompletion;
+		void read_async(uint32_t index, ReadCompletion completion, std::shared_ptr<ReadCancellation> cancellation = std::shared_ptr<ReadCancellation>()) const;
+
+		/*
+		 Reads the frames [begin, end) at once, for tools that need many consecutive frames.
+		 The hierarchy is walked once and every object reads its frames in ascending order, which is the order its samples lie in the file.
+		 A sample that did not change from the frame before is not read again: the scenes share the attribute column.
+		 Returns an empty vector on failure.
+		*/
+		std::vector<std::shared_ptr<AlembicScene>> read_range(uint32_t begin, uint32_t end, std::string &error_message) const;
+
 		uint32_t frameCount() const {
 			return _frameCount;
 		}
+
+		/*
+		 Keeps the P and v columns of PointObjects quantized to 16 bits per component, relative to the bounds of each block of rows.
+		 A block is quantized only when the error stays within maxError (plus float rounding), otherwise it stays float.
+		 PointObject::P is left empty, read the positions through points.column_as_vector3("P") instead.
+		 0 disables it (default).
+		*/
+		void setPointQuantization(float maxError) {
+			_pointQuantization = maxError;
+		}
+		float pointQuantization() const {
+			return _pointQuantization;
+		}
+
+		/*
+		 How the archive is read when several threads call read().
+		 A memory mapped archive is read without locks. Otherwise every sample read borrows one of streamCount file handles,
+		 so streamCount should be the number of reading threads.
+		 0 means std::thread::hardware_concurrency() (default). Takes effect at the next open().
+		*/
+		void setStreams(uint32_t streamCount, bool memoryMapped = true) {
+			_streamCount = streamCount;
+			_memoryMapped = memoryMapped;
+		}
+		uint32_t streamCount() const;
+		bool memoryMapped() const {
+			return _memoryMapped;
+		}
+
+		/*
+		 The objects of a frame, and the columns of each object, are parsed as tasks of this executor.
+		 null means TaskExecutor::shared() (default). TaskExecutor(0) parses on the thread calling read().
+		*/
+		void setExecutor(std::shared_ptr<TaskExecutor> executor) {
+			_executor = std::move(executor);
+		}
+		std::shared_ptr<TaskExecutor> executor() const {
+			return _executor ? _executor : TaskExecutor::shared();
+		}
+
+		/*
+		 Counts the I/O, conversions and parsing of every read until disabled (default off). Not while reading, like open().
+		 While no storage has it enabled, Alembic does not even time its reads.
+		*/
+		void setStatsEnabled(bool enabled);
+		bool statsEnabled() const {
+			return (bool)_stats;
+		}
+		ReadStats stats() const;
+		void resetStats();
 	private:
+		std::shared_ptr<TaskExecutor> _executor;
+		std::shared_ptr<void> _stats;
+		std::shared_ptr<void> _plan;
 		uint32_t _frameCount = 0;
+		float _pointQuantization = 0.0f;
+		uint32_t _streamCount = 0;
+		bool _memoryMapped = true;
 		std::shared_ptr<void> _alembicArchive;
+		std::shared_ptr<StringTable> _strings;
 	};
+
+	/*
+	 Reads a sequence of archives with one frame each, such as "shot.$F4.abc" exported by Houdini.
+	 Frame index i is the first sample of the i-th file.
+
+	 A bounded pool keeps the most recently used archives open. After each read the following files are opened and read ahead as jobs of the executor,
+	 so playing forward mostly picks up scenes that are already done.
+	 The hierarchy of every file is compared with the ones seen before when it is opened, and files with the same hierarchy share one precompiled traversal of it.
+	*/
+	class AlembicSequenceStorage {
+	public:
+		/*
+		 $F is replaced by the frame number, $F2 to $F9 pad it with zeros.
+		 ex) open("shot.$F4.abc", 1001, 1100, error_message)
+		*/
+		bool open(const std::string &pattern, int firstFrame, int lastFrame, std::string &error_message);
+		bool open(const std::vector<std::string> &framePaths, std::string &error_message);
+		bool isOpened() const;
+		void close();
+
+		// return null if failed to sample.
+		std::shared_ptr<AlembicScene> read(uint32_t index, std::string &error_message) const;
+
+		uint32_t frameCount() const {
+			return _frameCount;
+		}
+
+		// the number of distinct hierarchies among the files opened so far
+		uint32_t planCount() const;
+
+		/*
+		 maxOpenArchives: archives kept open at once (default 8)
+		 readAhead: files read ahead of each read, at most maxOpenArchives (default 2, 0 disables it)
+		 Takes effect at the next open().
+		*/
+		void setPool(uint32_t maxOpenArchives, uint32_t readAhead) {
+			_maxOpenArchives = maxOpenArchives;
+			_readAhead = readAhead;
+		}
+
+		// see AlembicStorage::setPointQuantization(). Takes effect at the next open().
+		void setPointQuantization(float maxError) {
+			_pointQuantization = maxError;
+		}
+
+		/*
+		 Runs the reads ahead and parses the objects of every frame. null means TaskExecutor::shared() (default).
+		 TaskExecutor(0) does not read ahead. Takes effect at the next open().
+		*/
+		void setExecutor(std::shared_ptr<TaskExecutor> executor) {
+			_executor = std::move(executor);
+		}
+		std::shared_ptr<TaskExecutor> executor() const {
+			return _executor ? _executor : TaskExecutor::shared();
+		}
+	private:
+		std::shared_ptr<TaskExecutor> _executor;
+		uint32_t _frameCount = 0;
+		uint32_t _maxOpenArchives = 8;
+		uint32_t _readAhead = 2;
+		float _pointQuantization = 0.0f;
+		std::shared_ptr<void> _context;
+	};
+
+	/*
+	 Writes AlembicScene frames in the layout Houdini exports, so that AlembicStorage reads them back as they were.
+
+	 Objects are matched with the previous frames by name. An object that appears later stays invisible until the frame it first appears in,
+	 and an object that disappears holds its last sample and becomes invisible.
+	*/
+	class AlembicWriter {
+	public:
+		bool open(const std::string &filePath, std::string &error_message, double framesPerSecond = 24.0);
+		bool isOpened() const;
+		void close();
+
+		// append one frame
+		bool write(const AlembicScene &scene, std::string &error_message);
+
+		uint32_t frameCount() const;
+	private:
+		std::shared_ptr<void> _context;
+	};
+
+	/*
+	 Writes decoded frames to a flat scene cache that SceneCacheStorage maps without parsing.
+	 Attribute columns keep the type they were stored with (int8 to uint64, half, float and double), are mapped back at that width,
+	 and names and string values are interned in one table.
+	 The cache is only readable after close().
+	*/
+	class SceneCacheWriter {
+	public:
+		bool open(const std::string &filePath, std::string &error_message);
+		bool isOpened() const;
+		void close();
+
+		// append one frame
+		bool write(const AlembicScene &scene, std::string &error_message);
+
+		uint32_t frameCount() const;
+	private:
+		std::shared_ptr<void> _context;
+	};
+
+	/*
+	 Reads a scene cache with the same interface as AlembicStorage.
+	 The file is memory mapped once, and the attribute columns read the mapping in place.
+	 P, indices and the other std::vector members of the objects are copied from it.
+	*/
+	class SceneCacheStorage {
+	public:
+		bool open(const std::string &filePath, std::string &error_message);
+		bool isOpened() const;
+		void close();
+
+		// return null if failed to sample.
+		std::shared_ptr<AlembicScene> read(uint32_t index, std::string &error_message) const;
+
+		uint32_t frameCount() const {
+			return _frameCount;
+		}
+	private:
+		uint32_t _frameCount = 0;
+		std::shared_ptr<void> _source;
+	};
+
+	struct RepackReport {
+		uint32_t frameCount = 0;
+
+		/*
+		 Bytes skipped or rewound between consecutive sample reads while reading every frame in order
+		*/
+		uint64_t seekDistanceBefore = 0;
+		uint64_t seekDistanceAfter = 0;
+	};
+
+	/*
+	 Rewrites an archive so that the samples of each frame are contiguous, in the order read() visits them.
+	 Headers and metadata come first. The result is a standard Ogawa archive with the same groups.
+	*/
+	bool repackFrameMajor(const std::string &srcPath, const std::string &dstPath, RepackReport &report, std::string &error_message);
+
+	struct CompactReport {
+		struct Property {
+			std::string name;
+			uint32_t sharedSamples = 0;
+			uint64_t bytesSaved = 0;
+		};
+
+		// the properties that had duplicates, most bytes saved first
+		std::vector<Property> properties;
+		uint64_t bytesSaved = 0;
+	};
+
+	/*
+	 Rewrites an archive so that identical array samples, even from different objects, share one data block.
+	 Duplicates are found by the digest Ogawa stores with each array sample.
+	*/
+	bool compactArchive(const std::string &srcPath, const std::string &dstPath, CompactReport &report, std::string &error_message);
+
+	struct ArchiveReport {
+		struct Property {
+			std::string name;     // full path, e.g. "/mesh/meshShape/.geom/P"
+			std::string object;   // the object it belongs to
+			std::string pod;      // stored type, e.g. "float32[3]"
+			std::string geoScope; // empty when not an attribute
+			bool array = false;
+			uint32_t numSamples = 0;
+			uint32_t storedSamples = 0; // Ogawa stores only the samples that changed
+			bool constant = false;      // one stored sample for every frame
+			uint64_t bytesOnDisk = 0;   // data blocks first referenced by this property, including their 8 bytes of size
+			uint32_t duplicateSamples = 0; // stored array samples with the same digest as an earlier block of the archive
+			uint64_t duplicateBytes = 0;   // what compactArchive would save
+			bool convertedOnAccess = false; // not float32, int32 or string, so reading a value as float or int converts it
+		};
+		struct Object {
+			std::string name;
+			uint64_t bytesOnDisk = 0;
+			uint32_t properties = 0;
+			uint32_t animatedProperties = 0;
+		};
+		/*
+		 The data blocks AlembicStorage reads for one frame, in the order it visits them.
+		 locality is bytes / span, 1 when the frame is one contiguous range of the file.
+		*/
+		struct Frame {
+			uint32_t frame = 0;
+			uint32_t blocks = 0;
+			uint64_t bytes = 0;
+			uint64_t span = 0; // from the first byte to the last byte read
+			uint64_t seekDistance = 0;
+			double locality = 0.0;
+		};
+
+		uint64_t fileBytes = 0;
+		uint32_t frameCount = 0;
+		std::vector<Property> properties; // most bytes first
+		std::vector<Object> objects;      // most bytes first
+		std::vector<Frame> frames;
+	};
+
+	/*
+	 Walks the archive and reports the cost of every object and property, to find the attributes worth dropping or making constant.
+	*/
+	bool analyzeArchive(const std::string &filePath, ArchiveReport &report, std::string &error_message);
+
+	/*
+	 Writes the report as JSON: "properties", "objects" and "frames" are arrays of flat records with the fields of ArchiveReport,
+	 so they can be sorted by any of them.
+	 Properties also carry duplicateRatio, duplicateBytes / bytesOnDisk.
+	*/
+	bool writeArchiveReport(const ArchiveReport &report, const std::string &jsonPath, std::string &error_message);
 }
\ No newline at end of file
@@ -0,0 +1,362 @@
+﻿#include "houdini_alembic.hpp"
+
+#include <Alembic/Util/ParallelFor.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <thread>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace houdini_alembic {
+	namespace {
+		// parallelFor の呼び出し1回分
+		struct TaskGroup {
+			const std::function<void(uint32_t)> *body = nullptr;
+			uint32_t remaining = 0;
+			std::mutex mutex;
+			std::condition_variable done;
+			std::exception_ptr exception;
+		};
+		struct Task {
+			TaskGroup *group = nullptr;
+			uint32_t begin = 0;
+			uint32_t end = 0;
+		};
+
+		struct Worker {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+			std::atomic<uint64_t> executed;
+			std::atomic<uint64_t> stolen;
+			std::atomic<uint64_t> busyNanoseconds;
+			std::thread thread;
+
+			Worker() : executed(0), stolen(0), busyNanoseconds(0) {
+			}
+		};
+
+		inline void pin_thread(std::thread &thread, uint32_t processor) {
+#if defined(_WIN32)
+			SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << (processor % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(processor % CPU_SETSIZE, &set);
+			pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+			(void)thread;
+			(void)processor;
+#endif
+		}
+
+		/*
+		 _workers[i] for i < workerCount are the threads of the pool.
+		 The last one has no thread: tasks submitted from outside the pool are queued there, and its counters are those of the outside threads.
+		 Jobs of submit() wait in _jobs and only the workers run them, after the parallelFor tasks.
+		*/
+		class ExecutorContext {
+		public:
+			ExecutorContext(uint32_t workerCount, bool pinWorkers) {
+				for (uint32_t i = 0; i < workerCount + 1; ++i) {
+					_workers.emplace_back(new Worker());
+				}
+				for (uint32_t i = 0; i < workerCount; ++i) {
+					_workers[i]->thread = std::thread([this, i]() { work(i); });
+					if (pinWorkers) {
+						pin_thread(_workers[i]->thread, i + 1);
+					}
+				}
+			}
+			~ExecutorContext() {
+				{
+					std::lock_guard<std::mutex> lock(_sleepMutex);
+					_quit = true;
+				}
+				_wake.notify_all();
+				for (uint32_t i = 0; i < workerCount(); ++i) {
+					// 自分のジョブが最後の参照を放した。戻ったらthisに触れずに終わる
+					if (t_context == this && t_worker == i) {
+						t_context = nullptr;
+						t_orphaned = true;
+						_workers[i]->thread.detach();
+						continue;
+					}
+					_workers[i]->thread.join();
+				}
+			}
+
+			uint32_t workerCount() const {
+				return (uint32_t)_workers.size() - 1;
+			}
+
+			void parallelFor(uint32_t count, const std::function<void(uint32_t)> &body) {
+				if (count == 0) {
+					return;
+				}
+				// スレッドごとに数個のタスクに分ける。残りは盗まれて均される
+				uint32_t taskCount = std::min(count, (workerCount() + 1) * 4);
+				if (workerCount() == 0) {
+					taskCount = 1;
+				}
+
+				TaskGroup group;
+				group.body = &body;
+				group.remaining = taskCount;
+
+				// 積む前に数えておく。取り出す側が先に減らしても負にならない
+				_queued += taskCount;
+				uint32_t self = current();
+				{
+					Worker &worker = *_workers[self];
+					std::lock_guard<std::mutex> lock(worker.mutex);
+					for (uint32_t i = 0; i < taskCount; ++i) {
+						Task task;
+						task.group = &group;
+						task.begin = (uint32_t)((uint64_t)count * i / taskCount);
+						task.end = (uint32_t)((uint64_t)count * (i + 1) / taskCount);
+						worker.tasks.push_back(task);
+					}
+				}
+				if (1 < taskCount) {
+					std::lock_guard<std::mutex> lock(_sleepMutex);
+					_wake.notify_all();
+				}
+
+				// 積まれている間は他のタスクも実行する。入れ子のparallelForがあっても詰まらない
+				Task task;
+				bool stolen = false;
+				while (take(self, task, stolen)) {
+					run(self, task, stolen);
+				}
+				// 残りは他のスレッドが実行中。終わるまで眠る
+				std::unique_lock<std::mutex> lock(group.mutex);
+				group.done.wait(lock, [&group]() { return group.remaining == 0; });
+				if (group.exception) {
+					std::rethrow_exception(group.exception);
+				}
+			}
+
+			void submit(std::function<void()> job) {
+				if (workerCount() == 0) {
+					run_job(workerCount(), job);
+					return;
+				}
+				{
+					std::lock_guard<std::mutex> lock(_sleepMutex);
+					_jobs.push_back(std::move(job));
+				}
+				_wake.notify_one();
+			}
+
+			std::vector<TaskExecutor::WorkerStats> stats() const {
+				std::vector<TaskExecutor::WorkerStats> stats(_workers.size());
+				for (std::size_t i = 0; i < _workers.size(); ++i) {
+					stats[i].executed = _workers[i]->executed;
+					stats[i].stolen = _workers[i]->stolen;
+					stats[i].busyNanoseconds = _workers[i]->busyNanoseconds;
+				}
+				return stats;
+			}
+			void resetStats() {
+				for (auto &worker : _workers) {
+					worker->executed = 0;
+					worker->stolen = 0;
+					worker->busyNanoseconds = 0;
+				}
+			}
+		private:
+			static thread_local ExecutorContext *t_context;
+			static thread_local uint32_t t_worker;
+
+			// set on a worker that destroyed its own context from a job
+			static thread_local bool t_orphaned;
+
+			// index of the calling thread in _workers
+			uint32_t current() const {
+				return t_context == this ? t_worker : workerCount();
+			}
+
+			// own tasks from the back, then steal from the front of the others
+			bool take(uint32_t self, Task &task, bool &stolen) {
+				if (_queued == 0) {
+					return false;
+				}
+				{
+					Worker &worker = *_workers[self];
+					std::lock_guard<std::mutex> lock(worker.mutex);
+					if (!worker.tasks.empty()) {
+						task = worker.tasks.back();
+						worker.tasks.pop_back();
+						_queued--;
+						stolen = false;
+						return true;
+					}
+				}
+				for (std::size_t i = 1; i < _workers.size(); ++i) {
+					Worker &victim = *_workers[(self + i) % _workers.size()];
+					std::lock_guard<std::mutex> lock(victim.mutex);
+					if (!victim.tasks.empty()) {
+						task = victim.tasks.front();
+						victim.tasks.pop_front();
+						_queued--;
+						stolen = true;
+						return true;
+					}
+				}
+				return false;
+			}
+
+			void run(uint32_t self, const Task &task, bool stolen) {
+				auto beg = std::chrono::steady_clock::now();
+				try {
+					for (uint32_t i = task.begin; i < task.end; ++i) {
+						(*task.group->body)(i);
+					}
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lock(task.group->mutex);
+					if (!task.group->exception) {
+						task.group->exception = std::current_exception();
+					}
+				}
+				auto end = std::chrono::steady_clock::now();
+
+				Worker &worker = *_workers[self];
+				worker.executed++;
+				if (stolen) {
+					worker.stolen++;
+				}
+				worker.busyNanoseconds += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - beg).count();
+
+				// これが最後の参照。ロックを放すとgroupは呼び出し元のスタックから消えうる
+				std::lock_guard<std::mutex> lock(task.group->mutex);
+				if (--task.group->remaining == 0) {
+					task.group->done.notify_all();
+				}
+			}
+
+			// false when the job released the last reference to the executor, and this is gone
+			bool run_job(uint32_t self, std::function<void()> &job) {
+				auto beg = std::chrono::steady_clock::now();
+				try {
+					job();
+				}
+				catch (...) {
+				}
+				auto end = std::chrono::steady_clock::now();
+				if (t_orphaned) {
+					return false;
+				}
+
+				Worker &worker = *_workers[self];
+				worker.executed++;
+				worker.busyNanoseconds += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - beg).count();
+				return true;
+			}
+
+			void work(uint32_t self) {
+				t_context = this;
+				t_worker = self;
+				for (;;) {
+					Task task;
+					bool stolen = false;
+					if (take(self, task, stolen)) {
+						run(self, task, stolen);
+						continue;
+					}
+
+					std::function<void()> job;
+					{
+						std::unique_lock<std::mutex> lock(_sleepMutex);
+						_wake.wait(lock, [this]() { return _quit || 0 < _queued || !_jobs.empty(); });
+						if (0 < _queued) {
+							continue;
+						}
+						if (_jobs.empty()) {
+							// 積まれたジョブは終えてから止まる
+							return;
+						}
+						job = std::move(_jobs.front());
+						_jobs.pop_front();
+					}
+					if (!run_job(self, job)) {
+						return;
+					}
+
+					// ジョブが持っていた参照がここで消え、このコンテキストごと破棄されることがある
+					job = nullptr;
+					if (t_orphaned) {
+						return;
+					}
+				}
+			}
+
+			std::vector<std::unique_ptr<Worker>> _workers;
+			std::atomic<uint32_t> _queued{ 0 };
+			std::deque<std::function<void()>> _jobs;
+
+			std::mutex _sleepMutex;
+			std::condition_variable _wake;
+			bool _quit = false;
+		};
+		thread_local ExecutorContext *ExecutorContext::t_context = nullptr;
+		thread_local uint32_t ExecutorContext::t_worker = 0;
+		thread_local bool ExecutorContext::t_orphaned = false;
+	}
+
+	TaskExecutor::TaskExecutor(uint32_t workerCount, bool pinWorkers) {
+		_context = std::shared_ptr<void>(new ExecutorContext(workerCount, pinWorkers), [](void *p) {
+			delete static_cast<ExecutorContext *>(p);
+		});
+	}
+	TaskExecutor::~TaskExecutor() {
+	}
+	uint32_t TaskExecutor::defaultWorkerCount() {
+		return std::max(std::thread::hardware_concurrency(), 1u) - 1;
+	}
+	uint32_t TaskExecutor::workerCount() const {
+		return static_cast<const ExecutorContext *>(_context.get())->workerCount();
+	}
+	void TaskExecutor::parallelFor(uint32_t count, const std::function<void(uint32_t)> &body) {
+		static_cast<ExecutorContext *>(_context.get())->parallelFor(count, body);
+	}
+	void TaskExecutor::submit(std::function<void()> job) {
+		static_cast<ExecutorContext *>(_context.get())->submit(std::move(job));
+	}
+	std::vector<TaskExecutor::WorkerStats> TaskExecutor::stats() const {
+		return static_cast<const ExecutorContext *>(_context.get())->stats();
+	}
+	void TaskExecutor::resetStats() {
+		static_cast<ExecutorContext *>(_context.get())->resetStats();
+	}
+
+	std::shared_ptr<TaskExecutor> TaskExecutor::shared() {
+		static std::shared_ptr<TaskExecutor> executor = []() {
+			std::shared_ptr<TaskExecutor> executor(new TaskExecutor());
+			std::weak_ptr<TaskExecutor> weak = executor;
+			Alembic::Util::SetParallelFor([weak](std::size_t count, const std::function<void(std::size_t)> &body) {
+				std::shared_ptr<TaskExecutor> executor = weak.lock();
+				if (!executor) {
+					for (std::size_t i = 0; i < count; ++i) {
+						body(i);
+					}
+					return;
+				}
+				executor->parallelFor((uint32_t)count, [&body](uint32_t i) { body(i); });
+			});
+			return executor;
+		}();
+		return executor;
+	}
+}
@@ -0,0 +1,921 @@
+﻿#include "houdini_alembic.hpp"
+
+#include <Alembic/Util/PlainOldDataType.h>
+
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace houdini_alembic {
+	/*
+	 Scene cache layout. Every offset is from the beginning of the file, and every array is 16 byte aligned.
+
+	 CacheHeader
+	 frames...   : column data and arrays of a frame, then its ColumnRecords and ObjectRecords
+	 string table: CacheArray (uint64_t offsets to uint32_t length + chars) of the interned names and string values
+	 frame table : CacheArray (CacheFrame per frame)
+
+	 The byte order and the layout of the records are those of the machine that wrote the cache.
+	*/
+	namespace scene_cache {
+		const char kMagic[8] = { 'H', 'A', 'S', 'C', 'A', 'C', 'H', 'E' };
+		const uint32_t kVersion = 3;
+		const uint32_t kByteOrder = 0x01020304;
+		const uint64_t kAlignment = 16;
+
+		struct CacheArray {
+			uint64_t offset = 0;
+			uint64_t count = 0;
+		};
+		struct CacheHeader {
+			char magic[8];
+			uint32_t version = kVersion;
+			uint32_t byteOrder = kByteOrder;
+			CacheArray frames;
+			CacheArray strings;
+		};
+		struct CacheFrame {
+			CacheArray objects;
+		};
+		struct ColumnRecord {
+			uint32_t name = 0;
+			uint32_t attributeType = 0;
+			uint32_t rowCount = 0;
+			uint32_t storageType = 0;
+			uint32_t componentCount = 0;
+			uint32_t reserved = 0;
+
+			// componentCount values of storageType per row, or uint32_t string ids
+			uint64_t offset = 0;
+		};
+		struct CameraRecord {
+			float eye[3], lookat[3], up[3], down[3], forward[3], back[3], left[3], right[3];
+			int32_t resolution_x, resolution_y;
+			float focalLength_mm, aperture_horizontal_mm, aperture_vertical_mm, nearClip, farClip;
+			float focusDistance, f_stop;
+			float fov_horizontal_degree, fov_vertical_degree, lensRadius, objectPlaneWidth, objectPlaneHeight;
+		};
+		struct ObjectRecord {
+			uint32_t type = 0;
+			uint32_t name = 0;
+			uint32_t visible = 0;
+			uint32_t reserved = 0;
+
+			float combinedXforms[16];
+			CacheArray xforms;
+
+			CacheArray P;
+			CacheArray faceCounts;
+			CacheArray indices;
+			CacheArray pointIds;
+			CacheArray curvePrimitives;
+
+			// ColumnRecords of points, vertices, primitives, details
+			CacheArray sheets[4];
+
+			// CameraRecord
+			uint64_t camera = 0;
+		};
+		static_assert(sizeof(Vector3f) == sizeof(float) * 3, "Vector3f must be packed");
+		static_assert(sizeof(CurveObject::CurvePrimitive) == sizeof(int32_t) * 2, "CurvePrimitive must be packed");
+
+		inline void copy_vector3(float *dst, const Vector3f &v) {
+			dst[0] = v.x;
+			dst[1] = v.y;
+			dst[2] = v.z;
+		}
+		inline Vector3f to_vector3(const float *src) {
+			return Vector3f(src[0], src[1], src[2]);
+		}
+
+		class Context {
+		public:
+			std::ofstream _stream;
+			uint64_t _pos = 0;
+			std::vector<CacheFrame> _frames;
+			std::vector<std::string> _strings;
+			std::unordered_map<std::string, uint32_t> _stringIds;
+
+			// 再利用する作業領域
+			std::vector<uint8_t> _columnBuffer;
+
+			uint64_t write(const void *data, uint64_t size) {
+				static const char zeros[kAlignment] = {};
+				uint64_t padding = (kAlignment - _pos % kAlignment) % kAlignment;
+				_stream.write(zeros, (std::streamsize)padding);
+				_pos += padding;
+
+				uint64_t offset = _pos;
+				if (size != 0) {
+					_stream.write((const char *)data, (std::streamsize)size);
+					_pos += size;
+				}
+				return offset;
+			}
+			template <class T>
+			CacheArray write_array(const std::vector<T> &values) {
+				CacheArray array;
+				array.offset = write(values.data(), values.size() * sizeof(T));
+				array.count = values.size();
+				return array;
+			}
+
+			uint32_t intern(const std::string &s) {
+				auto it = _stringIds.find(s);
+				if (it != _stringIds.end()) {
+					return it->second;
+				}
+				uint32_t id = (uint32_t)_strings.size();
+				_strings.push_back(s);
+				_stringIds[s] = id;
+				return id;
+			}
+
+			// 行ごとに Wide で読んで POD に戻す
+			template <Alembic::Util::PlainOldDataType POD, class Wide, class Column>
+			uint64_t write_rows(const Column *c, uint32_t componentCount) {
+				typedef typename Alembic::Util::PODTraitsFromEnum<POD>::value_type value_type;
+				// bool_t は bool からしか作れない
+				typedef typename std::conditional<POD == Alembic::Util::kBooleanPOD, bool, value_type>::type cast_type;
+				_columnBuffer.resize(sizeof(value_type) * componentCount * c->rowCount());
+				value_type *values = (value_type *)_columnBuffer.data();
+				Wide row[4];
+				for (uint32_t i = 0; i < c->rowCount(); ++i) {
+					c->get(i, row);
+					for (uint32_t j = 0; j < componentCount; ++j) {
+						values[i * componentCount + j] = static_cast<value_type>(static_cast<cast_type>(row[j]));
+					}
+				}
+				return write(values, _columnBuffer.size());
+			}
+			template <class Wide, class Column>
+			uint64_t write_rows(const Column *c, AttributeStorageType storageType, uint32_t componentCount) {
+				using namespace Alembic::Util;
+				switch (storageType) {
+				case AttributeStorageType_Bool:    return write_rows<kBooleanPOD, Wide>(c, componentCount);
+				case AttributeStorageType_UInt8:   return write_rows<kUint8POD, Wide>(c, componentCount);
+				case AttributeStorageType_Int8:    return write_rows<kInt8POD, Wide>(c, componentCount);
+				case AttributeStorageType_UInt16:  return write_rows<kUint16POD, Wide>(c, componentCount);
+				case AttributeStorageType_Int16:   return write_rows<kInt16POD, Wide>(c, componentCount);
+				case AttributeStorageType_UInt32:  return write_rows<kUint32POD, Wide>(c, componentCount);
+				case AttributeStorageType_Int32:   return write_rows<kInt32POD, Wide>(c, componentCount);
+				case AttributeStorageType_UInt64:  return write_rows<kUint64POD, Wide>(c, componentCount);
+				case AttributeStorageType_Int64:   return write_rows<kInt64POD, Wide>(c, componentCount);
+				case AttributeStorageType_Float16: return write_rows<kFloat16POD, Wide>(c, componentCount);
+				case AttributeStorageType_Float32: return write_rows<kFloat32POD, Wide>(c, componentCount);
+				default:                           return write_rows<kFloat64POD, Wide>(c, componentCount);
+				}
+			}
+
+			/*
+			 Columns are written in the type they are stored with, so Float64, Int64, UInt32 and half values survive.
+			 Indexed and broadcast columns have no storage(), their rows are read one by one and converted back.
+			 A vector column with integer storage and no storage() is quantized (or indexed), it is written as floats.
+			*/
+			void write_column(const AttributeColumn *column, ColumnRecord &record) {
+				AttributeStorageType storageType = column->storageType();
+				uint32_t componentCount = column->componentCount();
+				if (const void *storage = column->storage()) {
+					uint64_t bytes = (uint64_t)Alembic::Util::PODNumBytes((Alembic::Util::PlainOldDataType)storageType) * componentCount * column->rowCount();
+					record.offset = write(storage, bytes);
+				}
+				else {
+					switch (column->attributeType()) {
+					case AttributeType_Int:
+						record.offset = write_rows<int64_t>(static_cast<const AttributeIntColumn *>(column), storageType, 1);
+						break;
+					default: {
+						if (storageType < AttributeStorageType_Float16) {
+							bool wide = AttributeStorageType_UInt32 <= storageType;
+							storageType = wide ? AttributeStorageType_Float64 : AttributeStorageType_Float32;
+						}
+						switch (column->attributeType()) {
+						case AttributeType_Float:
+							record.offset = write_rows<double>(static_cast<const AttributeFloatColumn *>(column), storageType, 1);
+							break;
+						case AttributeType_Vector2:
+							record.offset = write_rows<double>(static_cast<const AttributeVector2Column *>(column), storageType, 2);
+							break;
+						case AttributeType_Vector3:
+							record.offset = write_rows<double>(static_cast<const AttributeVector3Column *>(column), storageType, 3);
+							break;
+						default:
+							record.offset = write_rows<double>(static_cast<const AttributeVector4Column *>(column), storageType, 4);
+							break;
+						}
+						break;
+					}
+					}
+				}
+				record.storageType = storageType;
+				record.componentCount = componentCount;
+			}
+
+			CacheArray write_sheet(const AttributeSpreadSheet &sheet) {
+				std::vector<ColumnRecord> records;
+				for (const auto &attribute : sheet.sheet) {
+					const AttributeColumn *column = attribute.column.get();
+					ColumnRecord record;
+					record.name = intern(attribute.key);
+					record.attributeType = column->attributeType();
+					record.rowCount = column->rowCount();
+
+					if (column->attributeType() == AttributeType_String) {
+						auto c = static_cast<const AttributeStringColumn *>(column);
+						std::vector<uint32_t> ids(c->rowCount());
+						for (uint32_t i = 0; i < c->rowCount(); ++i) {
+							ids[i] = intern(c->get(i));
+						}
+						record.storageType = AttributeStorageType_String;
+						record.componentCount = 1;
+						record.offset = write(ids.data(), ids.size() * sizeof(uint32_t));
+					}
+					else {
+						write_column(column, record);
+					}
+					records.push_back(record);
+				}
+				return write_array(records);
+			}
+
+			void write_camera(const CameraObject *camera, ObjectRecord &record) {
+				CameraRecord c;
+				copy_vector3(c.eye, camera->eye);
+				copy_vector3(c.lookat, camera->lookat);
+				copy_vector3(c.up, camera->up);
+				copy_vector3(c.down, camera->down);
+				copy_vector3(c.forward, camera->forward);
+				copy_vector3(c.back, camera->back);
+				copy_vector3(c.left, camera->left);
+				copy_vector3(c.right, camera->right);
+				c.resolution_x = camera->resolution_x;
+				c.resolution_y = camera->resolution_y;
+				c.focalLength_mm = camera->focalLength_mm;
+				c.aperture_horizontal_mm = camera->aperture_horizontal_mm;
+				c.aperture_vertical_mm = camera->aperture_vertical_mm;
+				c.nearClip = camera->nearClip;
+				c.farClip = camera->farClip;
+				c.focusDistance = camera->focusDistance;
+				c.f_stop = camera->f_stop;
+				c.fov_horizontal_degree = camera->fov_horizontal_degree;
+				c.fov_vertical_degree = camera->fov_vertical_degree;
+				c.lensRadius = camera->lensRadius;
+				c.objectPlaneWidth = camera->objectPlaneWidth;
+				c.objectPlaneHeight = camera->objectPlaneHeight;
+				record.camera = write(&c, sizeof(c));
+			}
+
+			void write_frame(const AlembicScene &scene) {
+				std::vector<ObjectRecord> records;
+				for (const auto &o : scene.objects) {
+					const SceneObject *object = o.get();
+					ObjectRecord record;
+					record.type = object->type();
+					record.name = intern(object->name);
+					record.visible = object->visible ? 1 : 0;
+					memcpy(record.combinedXforms, object->combinedXforms.value_ptr(), sizeof(record.combinedXforms));
+					record.xforms = write_array(object->xforms);
+					record.sheets[3] = write_sheet(object->details);
+
+					switch (object->type()) {
+					case SceneObjectType_PolygonMesh: {
+						auto polygon = static_cast<const PolygonMeshObject *>(object);
+						record.P = write_array(polygon->P);
+						record.faceCounts = write_array(polygon->faceCounts);
+						record.indices = write_array(polygon->indices);
+						record.sheets[0] = write_sheet(polygon->points);
+						record.sheets[1] = write_sheet(polygon->vertices);
+						record.sheets[2] = write_sheet(polygon->primitives);
+						break;
+					}
+					case SceneObjectType_Point: {
+						auto point = static_cast<const PointObject *>(object);
+						// 量子化して読んだ点はPの列にしかない
+						static const TypedAttributeHandle<AttributeVector3Column> kP("P");
+						auto column = point->points.column(kP);
+						if (point->P.empty() && column) {
+							std::vector<Vector3f> P(column->rowCount());
+							column->getRows(0, (uint32_t)P.size(), (float *)P.data());
+							record.P = write_array(P);
+						}
+						else {
+							record.P = write_array(point->P);
+						}
+						record.pointIds = write_array(point->pointIds);
+						record.sheets[0] = write_sheet(point->points);
+						break;
+					}
+					case SceneObjectType_Curve: {
+						auto curve = static_cast<const CurveObject *>(object);
+						record.P = write_array(curve->P);
+						record.curvePrimitives = write_array(curve->curvePrimitives);
+						record.sheets[0] = write_sheet(curve->points);
+						record.sheets[1] = write_sheet(curve->vertices);
+						record.sheets[2] = write_sheet(curve->primitives);
+						break;
+					}
+					case SceneObjectType_Camera:
+						write_camera(static_cast<const CameraObject *>(object), record);
+						break;
+					}
+					records.push_back(record);
+				}
+
+				CacheFrame frame;
+				frame.objects = write_array(records);
+				_frames.push_back(frame);
+			}
+
+			void finish() {
+				CacheHeader header;
+				memcpy(header.magic, kMagic, sizeof(kMagic));
+
+				std::vector<uint64_t> stringOffsets(_strings.size());
+				for (size_t i = 0; i < _strings.size(); ++i) {
+					uint32_t length = (uint32_t)_strings[i].size();
+					stringOffsets[i] = write(&length, sizeof(length));
+					_stream.write(_strings[i].data(), length);
+					_pos += length;
+				}
+				header.strings = write_array(stringOffsets);
+				header.frames = write_array(_frames);
+
+				_stream.seekp(0);
+				_stream.write((const char *)&header, sizeof(header));
+				_stream.close();
+			}
+		};
+
+		/*
+		 Read only mapping of the whole file, shared by the storage and every column read from it
+		*/
+		class Mapping {
+		public:
+			Mapping(const Mapping &) = delete;
+			void operator=(const Mapping &) = delete;
+
+			Mapping(const std::string &filePath) {
+#ifdef _WIN32
+				_file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+				if (_file == INVALID_HANDLE_VALUE) {
+					throw std::runtime_error("can't open " + filePath);
+				}
+				LARGE_INTEGER size;
+				GetFileSizeEx(_file, &size);
+				_size = (uint64_t)size.QuadPart;
+				if (_size != 0) {
+					_mapping = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+					if (_mapping != NULL) {
+						_data = (const uint8_t *)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+					}
+					if (_data == nullptr) {
+						release();
+						throw std::runtime_error("can't map " + filePath);
+					}
+				}
+#else
+				_file = ::open(filePath.c_str(), O_RDONLY);
+				if (_file < 0) {
+					throw std::runtime_error("can't open " + filePath);
+				}
+				struct stat st;
+				fstat(_file, &st);
+				_size = (uint64_t)st.st_size;
+				if (_size != 0) {
+					void *p = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _file, 0);
+					if (p == MAP_FAILED) {
+						release();
+						throw std::runtime_error("can't map " + filePath);
+					}
+					_data = (const uint8_t *)p;
+				}
+#endif
+			}
+			~Mapping() {
+				release();
+			}
+
+			// returns null if [offset, offset + count * sizeof(T)) is out of the file
+			template <class T>
+			const T *get(uint64_t offset, uint64_t count = 1) const {
+				if (_size < offset || (_size - offset) / sizeof(T) < count || offset % alignof(T) != 0) {
+					return nullptr;
+				}
+				return (const T *)(_data + offset);
+			}
+			template <class T>
+			const T *get(const CacheArray &array) const {
+				const T *values = get<T>(array.offset, array.count);
+				if (values == nullptr) {
+					throw std::runtime_error("scene cache is broken");
+				}
+				return values;
+			}
+		private:
+			void release() {
+#ifdef _WIN32
+				if (_data) {
+					UnmapViewOfFile(_data);
+				}
+				if (_mapping != NULL) {
+					CloseHandle(_mapping);
+				}
+				if (_file != INVALID_HANDLE_VALUE) {
+					CloseHandle(_file);
+				}
+				_mapping = NULL;
+				_file = INVALID_HANDLE_VALUE;
+#else
+				if (_data) {
+					munmap((void *)_data, _size);
+				}
+				if (0 <= _file) {
+					::close(_file);
+				}
+				_file = -1;
+#endif
+				_data = nullptr;
+			}
+
+#ifdef _WIN32
+			HANDLE _file = INVALID_HANDLE_VALUE;
+			HANDLE _mapping = NULL;
+#else
+			int _file = -1;
+#endif
+			const uint8_t *_data = nullptr;
+			uint64_t _size = 0;
+		};
+
+		/*
+		 The columns read the mapped values in place, in the type they were written with
+		*/
+		template <class Base, Alembic::Util::PlainOldDataType POD>
+		class MappedColumn : public Base {
+		public:
+			typedef typename Alembic::Util::PODTraitsFromEnum<POD>::value_type value_type;
+
+			uint32_t rowCount() const override {
+				return _rowCount;
+			}
+			AttributeStorageType storageType() const override {
+				return (AttributeStorageType)POD;
+			}
+			uint32_t componentCount() const override {
+				return _componentCount;
+			}
+			const void *storage() const override {
+				return _values;
+			}
+			template <class T>
+			void get_as(uint32_t index, T *xs) const {
+				const value_type *p = _values + (std::size_t)index * _componentCount;
+				for (uint32_t i = 0; i < _componentCount; ++i) {
+					xs[i] = static_cast<T>(p[i]);
+				}
+			}
+			void countMemory(MemoryCounter &counter, long useCount) const override {
+				MemoryCounter::Scope scope(counter, this, sizeof(*this), useCount);
+				if (scope.first()) {
+					counter.add(_values, (uint64_t)_rowCount * _componentCount * sizeof(value_type), _mapping.use_count());
+				}
+			}
+			std::shared_ptr<Mapping> _mapping;
+			const value_type *_values = nullptr;
+			uint32_t _rowCount = 0;
+			uint32_t _componentCount = 0;
+		};
+		template <Alembic::Util::PlainOldDataType POD>
+		class MappedFloatColumn : public MappedColumn<AttributeFloatColumn, POD> {
+		public:
+			float get(uint32_t index) const override {
+				return static_cast<float>(this->_values[index]);
+			}
+			void get(uint32_t index, double *x) const override {
+				*x = static_cast<double>(this->_values[index]);
+			}
+			int snprint(uint32_t index, char *buffer, uint32_t buffersize) const override {
+				return snprintf(buffer, buffersize, "%f", get(index));
+			}
+		};
+		template <Alembic::Util::PlainOldDataType POD>
+		class MappedIntColumn : public MappedColumn<AttributeIntColumn, POD> {
+		public:
+			int32_t get(uint32_t index) const override {
+				return static_cast<int32_t>(this->_values[index]);
+			}
+			void get(uint32_t index, int64_t *x) const override {
+				*x = static_cast<int64_t>(this->_values[index]);
+			}
+			int snprint(uint32_t index, char *buffer, uint32_t buffersize) const override {
+				int64_t x;
+				get(index, &x);
+				return snprintf(buffer, buffersize, "%lld", (long long)x);
+			}
+		};
+		template <class Base, Alembic::Util::PlainOldDataType POD>
+		class MappedVectorColumn : public MappedColumn<Base, POD> {
+		public:
+			void get(uint32_t index, float *xs) const override {
+				this->get_as(index, xs);
+			}
+			void get(uint32_t index, double *xs) const override {
+				this->get_as(index, xs);
+			}
+			int snprint(uint32_t index, char *buffer, uint32_t buffersize) const override {
+				float xs[4] = {};
+				get(index, xs);
+				switch (this->_componentCount) {
+				case 2: return snprintf(buffer, buffersize, "(%f, %f)", xs[0], xs[1]);
+				case 3: return snprintf(buffer, buffersize, "(%f, %f, %f)", xs[0], xs[1], xs[2]);
+				default: return snprintf(buffer, buffersize, "(%f, %f, %f, %f)", xs[0], xs[1], xs[2], xs[3]);
+				}
+			}
+		};
+		template <Alembic::Util::PlainOldDataType POD>
+		class MappedVector3Column : public MappedVectorColumn<AttributeVector3Column, POD> {
+		public:
+			void getRows(uint32_t begin, uint32_t count, float *xyz) const override {
+				if (POD == Alembic::Util::kFloat32POD) {
+					memcpy(xyz, this->_values + (std::size_t)begin * 3, (std::size_t)count * 3 * sizeof(float));
+					return;
+				}
+				MappedVectorColumn<AttributeVector3Column, POD>::getRows(begin, count, xyz);
+			}
+		};
+		class MappedStringColumn : public AttributeStringColumn {
+		public:
+			const std::string &get(uint32_t index) const override {
+				return (*_strings)[_ids[index]];
+			}
+			uint32_t rowCount() const override {
+				return _rowCount;
+			}
+			int snprint(uint32_t index, char *buffer, uint32_t buffersize) const override {
+				return snprintf(buffer, buffersize, "%s", get(index).c_str());
+			}
+			uint32_t id(uint32_t index) const override {
+				return _ids[index];
+			}
+			const StringTable &stringTable() const override {
+				return *_table;
+			}
+			void countMemory(MemoryCounter &counter, long useCount) const override {
+				MemoryCounter::Scope scope(counter, this, sizeof(*this), useCount);
+				if (scope.first()) {
+					// 文字列はキャッシュ全体で共有している
+					uint64_t bytes = _strings->capacity() * sizeof(std::string);
+					for (const std::string &value : *_strings) {
+						bytes += MemoryCounter::heapBytes(value);
+					}
+					counter.add(_strings.get(), bytes, _strings.use_count());
+					counter.add(_table.get(), _table->memoryBytes(), _table.use_count());
+					counter.add(_ids, (uint64_t)_rowCount * sizeof(uint32_t), _mapping.use_count());
+				}
+			}
+			std::shared_ptr<Mapping> _mapping;
+			std::shared_ptr<const std::vector<std::string>> _strings;
+			std::shared_ptr<const StringTable> _table;
+			const uint32_t *_ids = nullptr;
+			uint32_t _rowCount = 0;
+		};
+
+		class Source {
+		public:
+			std::shared_ptr<Mapping> _mapping;
+			std::shared_ptr<const std::vector<std::string>> _strings;
+			std::shared_ptr<const StringTable> _table;
+			const CacheFrame *_frames = nullptr;
+			uint32_t _frameCount = 0;
+
+			const std::string &string(uint32_t id) const {
+				if (_strings->size() <= id) {
+					throw std::runtime_error("scene cache is broken");
+				}
+				return (*_strings)[id];
+			}
+
+			template <class T>
+			void copy(std::vector<T> &dst, const CacheArray &array) const {
+				const T *values = _mapping->get<T>(array);
+				dst.assign(values, values + array.count);
+			}
+
+			template <class Column>
+			std::shared_ptr<AttributeColumn> column(const ColumnRecord &record, const std::shared_ptr<SceneArena> &arena) const {
+				auto column = allocate_scene_object<Column>(arena);
+				column->_mapping = _mapping;
+				column->_rowCount = record.rowCount;
+				column->_componentCount = record.componentCount;
+				CacheArray array;
+				array.offset = record.offset;
+				array.count = (uint64_t)record.rowCount * record.componentCount;
+				column->_values = _mapping->get<typename Column::value_type>(array);
+				return column;
+			}
+			template <Alembic::Util::PlainOldDataType POD>
+			std::shared_ptr<AttributeColumn> column(const ColumnRecord &record, const std::shared_ptr<SceneArena> &arena) const {
+				switch (record.attributeType) {
+				case AttributeType_Int:
+					return column<MappedIntColumn<POD>>(record, arena);
+				case AttributeType_Float:
+					return column<MappedFloatColumn<POD>>(record, arena);
+				case AttributeType_Vector2:
+					return column<MappedVectorColumn<AttributeVector2Column, POD>>(record, arena);
+				case AttributeType_Vector3:
+					return column<MappedVector3Column<POD>>(record, arena);
+				default:
+					return column<MappedVectorColumn<AttributeVector4Column, POD>>(record, arena);
+				}
+			}
+			std::shared_ptr<AttributeColumn> column(const ColumnRecord &record, const std::shared_ptr<SceneArena> &arena) const {
+				using namespace Alembic::Util;
+				switch (record.storageType) {
+				case AttributeStorageType_Bool:    return column<kBooleanPOD>(record, arena);
+				case AttributeStorageType_UInt8:   return column<kUint8POD>(record, arena);
+				case AttributeStorageType_Int8:    return column<kInt8POD>(record, arena);
+				case AttributeStorageType_UInt16:  return column<kUint16POD>(record, arena);
+				case AttributeStorageType_Int16:   return column<kInt16POD>(record, arena);
+				case AttributeStorageType_UInt32:  return column<kUint32POD>(record, arena);
+				case AttributeStorageType_Int32:   return column<kInt32POD>(record, arena);
+				case AttributeStorageType_UInt64:  return column<kUint64POD>(record, arena);
+				case AttributeStorageType_Int64:   return column<kInt64POD>(record, arena);
+				case AttributeStorageType_Float16: return column<kFloat16POD>(record, arena);
+				case AttributeStorageType_Float32: return column<kFloat32POD>(record, arena);
+				case AttributeStorageType_Float64: return column<kFloat64POD>(record, arena);
+				default:
+					throw std::runtime_error("scene cache is broken");
+				}
+			}
+
+			void read_sheet(AttributeSpreadSheet &sheet, const CacheArray &array, const std::shared_ptr<SceneArena> &arena) const {
+				const ColumnRecord *records = _mapping->get<ColumnRecord>(array);
+				sheet.sheet.reserve(array.count);
+				for (uint64_t i = 0; i < array.count; ++i) {
+					const ColumnRecord &record = records[i];
+					std::shared_ptr<AttributeColumn> c;
+					switch (record.attributeType) {
+					case AttributeType_Int:
+					case AttributeType_Float:
+						if (record.componentCount != 1) {
+							throw std::runtime_error("scene cache is broken");
+						}
+						c = column(record, arena);
+						break;
+					case AttributeType_Vector2:
+					case AttributeType_Vector3:
+					case AttributeType_Vector4:
+						if (record.componentCount != 2 + (record.attributeType - AttributeType_Vector2)) {
+							throw std::runtime_error("scene cache is broken");
+						}
+						c = column(record, arena);
+						break;
+					case AttributeType_String: {
+						auto s = allocate_scene_object<MappedStringColumn>(arena);
+						s->_mapping = _mapping;
+						s->_strings = _strings;
+						s->_table = _table;
+						s->_rowCount = record.rowCount;
+						CacheArray ids;
+						ids.offset = record.offset;
+						ids.count = record.rowCount;
+						s->_ids = _mapping->get<uint32_t>(ids);
+						for (uint32_t j = 0; j < record.rowCount; ++j) {
+							string(s->_ids[j]);
+						}
+						c = s;
+						break;
+					}
+					default:
+						throw std::runtime_error("scene cache is broken");
+					}
+					sheet.sheet.emplace_back(string(record.name), c);
+				}
+				sheet.index();
+			}
+
+			void read_camera(CameraObject *camera, uint64_t offset) const {
+				CacheArray array;
+				array.offset = offset;
+				array.count = 1;
+				const CameraRecord &c = *_mapping->get<CameraRecord>(array);
+				camera->eye = to_vector3(c.eye);
+				camera->lookat = to_vector3(c.lookat);
+				camera->up = to_vector3(c.up);
+				camera->down = to_vector3(c.down);
+				camera->forward = to_vector3(c.forward);
+				camera->back = to_vector3(c.back);
+				camera->left = to_vector3(c.left);
+				camera->right = to_vector3(c.right);
+				camera->resolution_x = c.resolution_x;
+				camera->resolution_y = c.resolution_y;
+				camera->focalLength_mm = c.focalLength_mm;
+				camera->aperture_horizontal_mm = c.aperture_horizontal_mm;
+				camera->aperture_vertical_mm = c.aperture_vertical_mm;
+				camera->nearClip = c.nearClip;
+				camera->farClip = c.farClip;
+				camera->focusDistance = c.focusDistance;
+				camera->f_stop = c.f_stop;
+				camera->fov_horizontal_degree = c.fov_horizontal_degree;
+				camera->fov_vertical_degree = c.fov_vertical_degree;
+				camera->lensRadius = c.lensRadius;
+				camera->objectPlaneWidth = c.objectPlaneWidth;
+				camera->objectPlaneHeight = c.objectPlaneHeight;
+			}
+
+			std::shared_ptr<AlembicScene> read(uint32_t index) const {
+				const ObjectRecord *records = _mapping->get<ObjectRecord>(_frames[index].objects);
+				std::shared_ptr<SceneArena> arena(new SceneArena());
+				auto scene = allocate_scene_object<AlembicScene>(arena);
+				scene->arena = arena;
+				scene->objects.reserve(_frames[index].objects.count);
+				for (uint64_t i = 0; i < _frames[index].objects.count; ++i) {
+					const ObjectRecord &record = records[i];
+					std::shared_ptr<SceneObject> object;
+					switch (record.type) {
+					case SceneObjectType_PolygonMesh: {
+						auto polygon = allocate_scene_object<PolygonMeshObject>(arena);
+						copy(polygon->P, record.P);
+						copy(polygon->faceCounts, record.faceCounts);
+						copy(polygon->indices, record.indices);
+						read_sheet(polygon->points, record.sheets[0], arena);
+						read_sheet(polygon->vertices, record.sheets[1], arena);
+						read_sheet(polygon->primitives, record.sheets[2], arena);
+						object = polygon;
+						break;
+					}
+					case SceneObjectType_Point: {
+						auto point = allocate_scene_object<PointObject>(arena);
+						copy(point->P, record.P);
+						copy(point->pointIds, record.pointIds);
+						read_sheet(point->points, record.sheets[0], arena);
+						object = point;
+						break;
+					}
+					case SceneObjectType_Curve: {
+						auto curve = allocate_scene_object<CurveObject>(arena);
+						copy(curve->P, record.P);
+						copy(curve->curvePrimitives, record.curvePrimitives);
+						read_sheet(curve->points, record.sheets[0], arena);
+						read_sheet(curve->vertices, record.sheets[1], arena);
+						read_sheet(curve->primitives, record.sheets[2], arena);
+						object = curve;
+						break;
+					}
+					case SceneObjectType_Camera: {
+						auto camera = allocate_scene_object<CameraObject>(arena);
+						read_camera(camera.get(), record.camera);
+						object = camera;
+						break;
+					}
+					default:
+						throw std::runtime_error("scene cache is broken");
+					}
+					object->name = string(record.name);
+					object->visible = record.visible != 0;
+					memcpy(object->combinedXforms.value_ptr(), record.combinedXforms, sizeof(record.combinedXforms));
+					copy(object->xforms, record.xforms);
+					read_sheet(object->details, record.sheets[3], arena);
+					scene->objects.emplace_back(object);
+				}
+				return scene;
+			}
+		};
+	}
+
+	bool SceneCacheWriter::open(const std::string &filePath, std::string &error_message) {
+		using namespace scene_cache;
+		_context = std::shared_ptr<void>();
+
+		std::shared_ptr<Context> context(new Context());
+		context->_stream.open(filePath, std::ios::binary | std::ios::trunc);
+		if (!context->_stream) {
+			error_message = "can't open " + filePath;
+			return false;
+		}
+
+		// ヘッダーはcloseで書き直す
+		CacheHeader header;
+		memset(header.magic, 0, sizeof(header.magic));
+		context->write(&header, sizeof(header));
+		_context = context;
+		return true;
+	}
+	bool SceneCacheWriter::isOpened() const {
+		return (bool)_context;
+	}
+	void SceneCacheWriter::close() {
+		if (_context) {
+			static_cast<scene_cache::Context *>(_context.get())->finish();
+		}
+		_context = std::shared_ptr<void>();
+	}
+	bool SceneCacheWriter::write(const AlembicScene &scene, std::string &error_message) {
+		if (!_context) {
+			error_message = "scene cache is not opened";
+			return false;
+		}
+		auto context = static_cast<scene_cache::Context *>(_context.get());
+		context->write_frame(scene);
+		if (!context->_stream) {
+			error_message = "failed to write scene cache";
+			return false;
+		}
+		return true;
+	}
+	uint32_t SceneCacheWriter::frameCount() const {
+		if (!_context) {
+			return 0;
+		}
+		return (uint32_t)static_cast<scene_cache::Context *>(_context.get())->_frames.size();
+	}
+
+	bool SceneCacheStorage::open(const std::string &filePath, std::string &error_message) {
+		using namespace scene_cache;
+		try {
+			_source = std::shared_ptr<void>();
+			_frameCount = 0;
+
+			std::shared_ptr<Source> source(new Source());
+			source->_mapping = std::shared_ptr<Mapping>(new Mapping(filePath));
+
+			const CacheHeader *header = source->_mapping->get<CacheHeader>(0);
+			if (header == nullptr || memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) {
+				error_message = "not a scene cache: " + filePath;
+				return false;
+			}
+			if (header->version != kVersion || header->byteOrder != kByteOrder) {
+				error_message = "unsupported scene cache: " + filePath;
+				return false;
+			}
+
+			// 文字列だけはstd::stringにしておく (フレームごとには変換しない)
+			std::shared_ptr<std::vector<std::string>> strings(new std::vector<std::string>(header->strings.count));
+			const uint64_t *stringOffsets = source->_mapping->get<uint64_t>(header->strings);
+			for (uint64_t i = 0; i < header->strings.count; ++i) {
+				const uint32_t *length = source->_mapping->get<uint32_t>(stringOffsets[i]);
+				const char *chars = length ? source->_mapping->get<char>(stringOffsets[i] + sizeof(uint32_t), *length) : nullptr;
+				if (chars == nullptr) {
+					throw std::runtime_error("scene cache is broken");
+				}
+				(*strings)[i].assign(chars, *length);
+			}
+			source->_strings = strings;
+
+			// 書き出し時に重複は除いてあるので、キャッシュのidをそのままStringTableのidとして使える
+			std::shared_ptr<StringTable> table(new StringTable());
+			for (uint32_t i = 0; i < strings->size(); ++i) {
+				if (table->intern((*strings)[i]) != i) {
+					throw std::runtime_error("scene cache is broken");
+				}
+			}
+			source->_table = table;
+			source->_frames = source->_mapping->get<CacheFrame>(header->frames);
+			source->_frameCount = (uint32_t)header->frames.count;
+
+			_frameCount = source->_frameCount;
+			_source = source;
+		}
+		catch (std::exception &e) {
+			error_message = e.what();
+			return false;
+		}
+		return true;
+	}
+	bool SceneCacheStorage::isOpened() const {
+		return (bool)_source;
+	}
+	void SceneCacheStorage::close() {
+		_source = std::shared_ptr<void>();
+		_frameCount = 0;
+	}
+	std::shared_ptr<AlembicScene> SceneCacheStorage::read(uint32_t index, std::string &error_message) const {
+		if (!_source) {
+			return std::shared_ptr<AlembicScene>();
+		}
+		auto source = static_cast<const scene_cache::Source *>(_source.get());
+		if (source->_frameCount <= index) {
+			error_message = "frame index out of range";
+			return std::shared_ptr<AlembicScene>();
+		}
+		try {
+			return source->read(index);
+		}
+		catch (std::exception &e) {
+			error_message = e.what();
+			return std::shared_ptr<AlembicScene>();
+		}
+	}
+}
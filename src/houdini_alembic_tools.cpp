@@ -0,0 +1,728 @@
+﻿#include "houdini_alembic.hpp"
+
+#include <Alembic/Abc/All.h>
+#include <Alembic/AbcCoreOgawa/All.h>
+#include <Alembic/Ogawa/All.h>
+
+#include <fstream>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+namespace houdini_alembic {
+	using namespace Alembic::Abc;
+
+	/*
+	 The Ogawa tree of an archive, with every data block tagged by the frame it belongs to.
+
+	 Ogawa itself only knows groups and data, so the tree is walked together with the Alembic objects and properties:
+	   archive : [version, library version, top object, archive metadata, time samplings, indexed metadata]
+	   object  : [properties, child objects..., object headers]
+	   compound: [sub properties..., property headers]
+	   scalar  : [sample 0, sample 1, ...]
+	   array   : [sample 0, dimensions 0, sample 1, dimensions 1, ...]
+	 Only the samples that changed are stored, and the frames before the first change share stored sample 0.
+	*/
+	namespace ogawa_tree {
+		const int64_t kHeaderFrame = -1;
+
+		struct Block {
+			uint64_t pos = 0;
+			uint64_t size = 0;
+
+			// write order
+			int64_t frame = 0;
+			uint64_t order = 0;
+
+			// the first property referencing this block, and whether it begins with the 16 bytes digest of an array sample
+			int32_t sampleGroup = -1;
+			bool digest = false;
+		};
+
+		struct Node {
+			enum Kind {
+				Group,
+				Data,
+				EmptyGroup,
+				EmptyData,
+			};
+			Kind kind = EmptyGroup;
+			uint32_t block = 0;
+			std::vector<Node> children;
+		};
+
+		// data blocks of a property, per stored sample
+		struct SampleGroup {
+			std::string name;
+			std::string object;
+			Alembic::AbcCoreAbstract::DataType dataType;
+			std::string geoScope;
+			bool array = false;
+			uint32_t numSamples = 0;
+			std::vector<std::vector<uint32_t>> stored;
+
+			// Ogawa stores the sample 0, then every sample from the first change to the last one
+			uint32_t firstChanged = 0;
+			uint32_t lastChanged = 0;
+
+			uint32_t storedIndex(uint32_t frame) const {
+				uint32_t index;
+				if (frame < firstChanged || lastChanged == 0) {
+					index = 0;
+				}
+				else if (lastChanged < frame) {
+					index = lastChanged - firstChanged + 1;
+				}
+				else {
+					index = frame - firstChanged + 1;
+				}
+				return std::min(index, (uint32_t)stored.size() - 1);
+			}
+			int64_t frameOf(uint32_t storedIndex) const {
+				return storedIndex == 0 ? 0 : (int64_t)firstChanged + storedIndex - 1;
+			}
+		};
+
+		struct Tree {
+			Node root;
+			std::vector<Block> blocks;
+			std::vector<SampleGroup> sampleGroups;
+			uint32_t frameCount = 0;
+		};
+
+		class Loader {
+		public:
+			Loader(Tree &tree) :_tree(tree) {}
+
+			void load(Alembic::Ogawa::IArchive &ogawa, Alembic::Abc::IArchive &archive) {
+				Alembic::Ogawa::IGroupPtr group = ogawa.getGroup();
+				_tree.root.kind = Node::Group;
+				_tree.root.children.resize(group->getNumChildren());
+				for (uint64_t i = 0; i < group->getNumChildren(); ++i) {
+					if (i == 2 && group->isChildGroup(i)) {
+						loadObject(group, i, _tree.root.children[i], archive.getTop());
+					}
+					else {
+						loadChild(group, i, _tree.root.children[i], kHeaderFrame);
+					}
+				}
+				for (const SampleGroup &samples : _tree.sampleGroups) {
+					_tree.frameCount = std::max(_tree.frameCount, samples.numSamples);
+				}
+			}
+		private:
+			void loadChild(Alembic::Ogawa::IGroupPtr group, uint64_t index, Node &node, int64_t frame) {
+				if (group->isEmptyChildGroup(index)) {
+					node.kind = Node::EmptyGroup;
+					return;
+				}
+				if (group->isEmptyChildData(index)) {
+					node.kind = Node::EmptyData;
+					return;
+				}
+				if (group->isChildData(index)) {
+					Alembic::Ogawa::IDataPtr data = group->getData(index, 0);
+					node.kind = Node::Data;
+					node.block = block(data, frame);
+					return;
+				}
+
+				// unknown group, keep it as it is
+				node.kind = Node::Group;
+				Alembic::Ogawa::IGroupPtr child = group->getGroup(index, false, 0);
+				node.children.resize(child->getNumChildren());
+				for (uint64_t i = 0; i < child->getNumChildren(); ++i) {
+					loadChild(child, i, node.children[i], frame);
+				}
+			}
+
+			void loadObject(Alembic::Ogawa::IGroupPtr parent, uint64_t index, Node &node, IObject o) {
+				node.kind = Node::Group;
+				Alembic::Ogawa::IGroupPtr group = parent->getGroup(index, false, 0);
+				node.children.resize(group->getNumChildren());
+				for (uint64_t i = 0; i < group->getNumChildren(); ++i) {
+					Node &child = node.children[i];
+					if (group->isChildGroup(i) && !group->isEmptyChildGroup(i)) {
+						if (i == 0) {
+							std::string name = o.getFullName() == "/" ? "" : o.getFullName();
+							loadCompound(group, i, child, o.getProperties(), o.getFullName(), name);
+							continue;
+						}
+						if (i - 1 < o.getNumChildren()) {
+							loadObject(group, i, child, o.getChild(i - 1));
+							continue;
+						}
+					}
+					loadChild(group, i, child, kHeaderFrame);
+				}
+			}
+
+			void loadCompound(Alembic::Ogawa::IGroupPtr parent, uint64_t index, Node &node, ICompoundProperty compound, const std::string &object, const std::string &path) {
+				node.kind = Node::Group;
+				Alembic::Ogawa::IGroupPtr group = parent->getGroup(index, false, 0);
+				node.children.resize(group->getNumChildren());
+				for (uint64_t i = 0; i < group->getNumChildren(); ++i) {
+					Node &child = node.children[i];
+					if (i < compound.getNumProperties() && group->isChildGroup(i) && !group->isEmptyChildGroup(i)) {
+						const PropertyHeader &header = compound.getPropertyHeader(i);
+						if (header.isCompound()) {
+							loadCompound(group, i, child, ICompoundProperty(compound, header.getName()), object, path + "/" + header.getName());
+						}
+						else if (header.isArray()) {
+							IArrayProperty property(compound, header.getName());
+							loadSamples(group, i, child, path + "/" + header.getName(), object, &header, property.getPtr(), 2);
+						}
+						else {
+							IScalarProperty property(compound, header.getName());
+							loadSamples(group, i, child, path + "/" + header.getName(), object, &header, property.getPtr(), 1);
+						}
+						continue;
+					}
+					loadChild(group, i, child, kHeaderFrame);
+				}
+			}
+
+			void loadSamples(Alembic::Ogawa::IGroupPtr parent, uint64_t index, Node &node, const std::string &name, const std::string &object, const PropertyHeader *header, Alembic::AbcCoreAbstract::BasePropertyReaderPtr property, uint32_t childrenPerSample) {
+				node.kind = Node::Group;
+				Alembic::Ogawa::IGroupPtr group = parent->getGroup(index, false, 0);
+				uint64_t numChildren = group->getNumChildren();
+				node.children.resize(numChildren);
+
+				SampleGroup samples;
+				samples.name = name;
+				samples.object = object;
+				samples.dataType = header->getDataType();
+				samples.geoScope = header->getMetaData().get("geoScope");
+				samples.array = header->isArray();
+				samples.stored.resize((numChildren + childrenPerSample - 1) / childrenPerSample);
+
+				uint32_t numSamples = (uint32_t)(header->isArray() ? property->asArrayPtr()->getNumSamples() : property->asScalarPtr()->getNumSamples());
+				samples.numSamples = std::max(numSamples, (uint32_t)samples.stored.size());
+				if (Alembic::AbcCoreOgawa::GetChangedSampleRange(property, samples.firstChanged, samples.lastChanged) == false) {
+					throw std::runtime_error("not an ogawa property: " + name);
+				}
+
+				for (uint64_t i = 0; i < numChildren; ++i) {
+					uint32_t storedIndex = (uint32_t)(i / childrenPerSample);
+					loadChild(group, i, node.children[i], samples.frameOf(storedIndex));
+					if (node.children[i].kind == Node::Data) {
+						samples.stored[storedIndex].push_back(node.children[i].block);
+
+						Block &b = _tree.blocks[node.children[i].block];
+						if (b.sampleGroup < 0) {
+							b.sampleGroup = (int32_t)_tree.sampleGroups.size();
+							b.digest = childrenPerSample == 2 && i % 2 == 0 && 16 <= b.size;
+						}
+					}
+				}
+				if (samples.stored.empty() == false) {
+					_tree.sampleGroups.emplace_back(std::move(samples));
+				}
+			}
+
+			uint32_t block(Alembic::Ogawa::IDataPtr data, int64_t frame) {
+				// 共有されているデータは一度だけ書く
+				auto it = _blockIndices.find(data->getPos());
+				if (it != _blockIndices.end()) {
+					Block &b = _tree.blocks[it->second];
+					if (frame < b.frame) {
+						b.frame = frame;
+						b.order = _order++;
+					}
+					return it->second;
+				}
+				Block b;
+				b.pos = data->getPos();
+				b.size = data->getSize();
+				b.frame = frame;
+				b.order = _order++;
+				uint32_t index = (uint32_t)_tree.blocks.size();
+				_tree.blocks.push_back(b);
+				_blockIndices[b.pos] = index;
+				return index;
+			}
+
+			Tree &_tree;
+			uint64_t _order = 0;
+			std::unordered_map<uint64_t, uint32_t> _blockIndices;
+		};
+
+		inline void load(const std::string &filePath, Tree &tree) {
+			Alembic::Ogawa::IArchive ogawa(filePath);
+			if (ogawa.isValid() == false) {
+				throw std::runtime_error("invalid ogawa archive: " + filePath);
+			}
+			Alembic::Abc::IArchive archive(Alembic::AbcCoreOgawa::ReadArchive(), filePath);
+			Loader(tree).load(ogawa, archive);
+		}
+
+		/*
+		 Bytes skipped or rewound between consecutive reads when AlembicStorage reads every frame in order.
+		 Each frame reads the stored sample of every property in the order AlembicStorage::read visits them.
+		*/
+		inline uint64_t seekDistance(const Tree &tree) {
+			uint64_t distance = 0;
+			uint64_t head = 0;
+			bool first = true;
+			for (uint32_t frame = 0; frame < tree.frameCount; ++frame) {
+				for (const SampleGroup &samples : tree.sampleGroups) {
+					for (uint32_t blockIndex : samples.stored[samples.storedIndex(frame)]) {
+						const Block &b = tree.blocks[blockIndex];
+						if (b.size == 0) {
+							continue;
+						}
+						if (first == false) {
+							distance += b.pos < head ? head - b.pos : b.pos - head;
+						}
+						first = false;
+
+						// 8 bytes of size precede the data
+						head = b.pos + 8 + b.size;
+					}
+				}
+			}
+			return distance;
+		}
+
+		/*
+		 Copies the tree into a new Ogawa archive.
+		 Data blocks are written first in the given order, then the groups referencing them.
+		*/
+		class Writer {
+		public:
+			Writer(const Tree &tree, Alembic::Ogawa::IArchive &source) :_tree(tree), _source(source) {}
+
+			// blocks with the same data as another block, written as a reference to it
+			void alias(uint32_t blockIndex, uint32_t to) {
+				_aliases[blockIndex] = to;
+			}
+
+			void write(const std::string &filePath, const std::vector<uint32_t> &blockOrder) {
+				Alembic::Ogawa::OArchive archive(filePath);
+				if (archive.isValid() == false) {
+					throw std::runtime_error("can't create archive: " + filePath);
+				}
+				Alembic::Ogawa::OGroupPtr root = archive.getGroup();
+
+				_datas.resize(_tree.blocks.size());
+				std::vector<uint8_t> buffer;
+				for (uint32_t blockIndex : blockOrder) {
+					if (_aliases.count(blockIndex)) {
+						continue;
+					}
+
+					// OGroup::createData adds an empty child for zero bytes, they are written as empty data instead
+					uint64_t size = read(blockIndex, buffer);
+					if (size != 0) {
+						_datas[blockIndex] = root->createData(size, buffer.data());
+					}
+				}
+				writeChildren(_tree.root, root);
+			}
+
+			uint64_t read(uint32_t blockIndex, std::vector<uint8_t> &buffer) {
+				const Block &b = _tree.blocks[blockIndex];
+				buffer.resize(b.size);
+				if (b.size == 0) {
+					return 0;
+				}
+				auto it = _sourceDatas.find(blockIndex);
+				if (it == _sourceDatas.end()) {
+					throw std::runtime_error("missing data block");
+				}
+				it->second->read(b.size, buffer.data(), 0, 0);
+				return b.size;
+			}
+
+			void readDigest(uint32_t blockIndex, Alembic::Util::Digest &digest) {
+				_sourceDatas.at(blockIndex)->read(16, digest.d, 0, 0);
+			}
+
+			// IData of every block, looked up by walking the source again
+			void bindSource() {
+				bind(_tree.root, _source.getGroup());
+			}
+		private:
+			void bind(const Node &node, Alembic::Ogawa::IGroupPtr group) {
+				for (uint64_t i = 0; i < node.children.size(); ++i) {
+					const Node &child = node.children[i];
+					if (child.kind == Node::Data) {
+						if (_sourceDatas.count(child.block) == 0) {
+							_sourceDatas[child.block] = group->getData(i, 0);
+						}
+					}
+					else if (child.kind == Node::Group) {
+						bind(child, group->getGroup(i, false, 0));
+					}
+				}
+			}
+
+			void writeChildren(const Node &node, Alembic::Ogawa::OGroupPtr group) {
+				for (const Node &child : node.children) {
+					switch (child.kind) {
+					case Node::Group: {
+						Alembic::Ogawa::OGroupPtr g = group->addGroup();
+						writeChildren(child, g);
+						g->freeze();
+						break;
+					}
+					case Node::Data: {
+						uint32_t blockIndex = child.block;
+						auto it = _aliases.find(blockIndex);
+						if (it != _aliases.end()) {
+							blockIndex = it->second;
+						}
+						if (_datas[blockIndex]) {
+							group->addData(_datas[blockIndex]);
+						}
+						else {
+							group->addEmptyData();
+						}
+						break;
+					}
+					case Node::EmptyGroup:
+						group->addEmptyGroup();
+						break;
+					case Node::EmptyData:
+						group->addEmptyData();
+						break;
+					}
+				}
+			}
+
+			const Tree &_tree;
+			Alembic::Ogawa::IArchive &_source;
+			std::unordered_map<uint32_t, Alembic::Ogawa::IDataPtr> _sourceDatas;
+			std::unordered_map<uint32_t, uint32_t> _aliases;
+			std::vector<Alembic::Ogawa::ODataPtr> _datas;
+		};
+
+		inline std::vector<uint32_t> blocksInFileOrder(const Tree &tree) {
+			std::vector<uint32_t> order(tree.blocks.size());
+			for (uint32_t i = 0; i < order.size(); ++i) {
+				order[i] = i;
+			}
+			std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+				return tree.blocks[a].pos < tree.blocks[b].pos;
+			});
+			return order;
+		}
+
+		/*
+		 Array sample blocks holding the same data as an earlier block of the file, paired with that block.
+		 Array samples begin with the digest of their data, so they are matched by size and digest.
+		*/
+		inline std::vector<std::pair<uint32_t, uint32_t>> duplicateBlocks(const Tree &tree, Writer &writer) {
+			struct DigestKey {
+				uint64_t size;
+				Alembic::Util::Digest digest;
+				bool operator<(const DigestKey &rhs) const {
+					if (size != rhs.size) {
+						return size < rhs.size;
+					}
+					return digest < rhs.digest;
+				}
+			};
+			std::map<DigestKey, uint32_t> firstBlocks;
+			std::vector<std::pair<uint32_t, uint32_t>> duplicates;
+
+			// 元の並びのまま、先に現れたものを残す
+			for (uint32_t blockIndex : blocksInFileOrder(tree)) {
+				const Block &b = tree.blocks[blockIndex];
+				if (b.digest == false) {
+					continue;
+				}
+				DigestKey key;
+				key.size = b.size;
+				writer.readDigest(blockIndex, key.digest);
+
+				auto it = firstBlocks.find(key);
+				if (it == firstBlocks.end()) {
+					firstBlocks[key] = blockIndex;
+					continue;
+				}
+				duplicates.emplace_back(blockIndex, it->second);
+			}
+			return duplicates;
+		}
+
+		inline void write_json_string(std::ostream &stream, const std::string &value) {
+			stream << '"';
+			for (char c : value) {
+				switch (c) {
+				case '"': stream << "\\\""; break;
+				case '\\': stream << "\\\\"; break;
+				case '\n': stream << "\\n"; break;
+				case '\t': stream << "\\t"; break;
+				default:
+					if ((unsigned char)c < 0x20) {
+						char buffer[8];
+						snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned)c);
+						stream << buffer;
+					}
+					else {
+						stream << c;
+					}
+					break;
+				}
+			}
+			stream << '"';
+		}
+	}
+
+	bool repackFrameMajor(const std::string &srcPath, const std::string &dstPath, RepackReport &report, std::string &error_message) {
+		using namespace ogawa_tree;
+		try {
+			Tree tree;
+			load(srcPath, tree);
+
+			// ヘッダー類を先頭に、サンプルはフレームごとにAlembicStorage::readの訪問順で並べる
+			std::vector<uint32_t> order(tree.blocks.size());
+			for (uint32_t i = 0; i < order.size(); ++i) {
+				order[i] = i;
+			}
+			std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+				const Block &ba = tree.blocks[a];
+				const Block &bb = tree.blocks[b];
+				if (ba.frame != bb.frame) {
+					return ba.frame < bb.frame;
+				}
+				return ba.order < bb.order;
+			});
+
+			{
+				Alembic::Ogawa::IArchive source(srcPath);
+				Writer writer(tree, source);
+				writer.bindSource();
+				writer.write(dstPath, order);
+			}
+
+			Tree repacked;
+			load(dstPath, repacked);
+
+			report.frameCount = tree.frameCount;
+			report.seekDistanceBefore = seekDistance(tree);
+			report.seekDistanceAfter = seekDistance(repacked);
+		}
+		catch (std::exception &e) {
+			error_message = e.what();
+			return false;
+		}
+		return true;
+	}
+
+	bool compactArchive(const std::string &srcPath, const std::string &dstPath, CompactReport &report, std::string &error_message) {
+		using namespace ogawa_tree;
+		try {
+			Tree tree;
+			load(srcPath, tree);
+
+			Alembic::Ogawa::IArchive source(srcPath);
+			Writer writer(tree, source);
+			writer.bindSource();
+
+			std::map<int32_t, CompactReport::Property> properties;
+			for (const auto &duplicate : duplicateBlocks(tree, writer)) {
+				writer.alias(duplicate.first, duplicate.second);
+
+				// 8 bytes of size precede the data
+				const Block &b = tree.blocks[duplicate.first];
+				CompactReport::Property &property = properties[b.sampleGroup];
+				property.name = tree.sampleGroups[b.sampleGroup].name;
+				property.sharedSamples++;
+				property.bytesSaved += 8 + b.size;
+			}
+
+			writer.write(dstPath, blocksInFileOrder(tree));
+
+			report = CompactReport();
+			for (const auto &property : properties) {
+				report.properties.push_back(property.second);
+				report.bytesSaved += property.second.bytesSaved;
+			}
+			std::sort(report.properties.begin(), report.properties.end(), [](const CompactReport::Property &a, const CompactReport::Property &b) {
+				return a.bytesSaved > b.bytesSaved;
+			});
+		}
+		catch (std::exception &e) {
+			error_message = e.what();
+			return false;
+		}
+		return true;
+	}
+
+	bool analyzeArchive(const std::string &filePath, ArchiveReport &report, std::string &error_message) {
+		using namespace ogawa_tree;
+		try {
+			Tree tree;
+			load(filePath, tree);
+
+			Alembic::Ogawa::IArchive source(filePath);
+			Writer writer(tree, source);
+			writer.bindSource();
+
+			report = ArchiveReport();
+			{
+				std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+				report.fileBytes = (uint64_t)file.tellg();
+			}
+			report.frameCount = tree.frameCount;
+
+			std::vector<ArchiveReport::Property> properties(tree.sampleGroups.size());
+			for (std::size_t i = 0; i < tree.sampleGroups.size(); ++i) {
+				const SampleGroup &samples = tree.sampleGroups[i];
+				ArchiveReport::Property &property = properties[i];
+				property.name = samples.name;
+				property.object = samples.object;
+				property.pod = Alembic::Util::PODName(samples.dataType.getPod());
+				if (1 < samples.dataType.getExtent()) {
+					property.pod += "[" + std::to_string((int)samples.dataType.getExtent()) + "]";
+				}
+				property.geoScope = samples.geoScope;
+				property.array = samples.array;
+				property.numSamples = samples.numSamples;
+				property.storedSamples = (uint32_t)samples.stored.size();
+				property.constant = samples.stored.size() == 1;
+
+				Alembic::Util::PlainOldDataType pod = samples.dataType.getPod();
+				property.convertedOnAccess = pod != Alembic::Util::kFloat32POD && pod != Alembic::Util::kInt32POD && pod != Alembic::Util::kStringPOD;
+			}
+
+			// 共有されたブロックは最初に参照したプロパティに数える。8 bytes of size precede the data
+			for (const Block &b : tree.blocks) {
+				if (0 <= b.sampleGroup) {
+					properties[b.sampleGroup].bytesOnDisk += 8 + b.size;
+				}
+			}
+			for (const auto &duplicate : duplicateBlocks(tree, writer)) {
+				const Block &b = tree.blocks[duplicate.first];
+				properties[b.sampleGroup].duplicateSamples++;
+				properties[b.sampleGroup].duplicateBytes += 8 + b.size;
+			}
+
+			std::map<std::string, ArchiveReport::Object> objects;
+			for (const ArchiveReport::Property &property : properties) {
+				ArchiveReport::Object &object = objects[property.object];
+				object.name = property.object;
+				object.bytesOnDisk += property.bytesOnDisk;
+				object.properties++;
+				if (property.constant == false) {
+					object.animatedProperties++;
+				}
+			}
+
+			// seekDistanceと同じ順で、フレームごとに読むブロックを辿る
+			std::vector<bool> visited(tree.blocks.size());
+			for (uint32_t frame = 0; frame < tree.frameCount; ++frame) {
+				ArchiveReport::Frame f;
+				f.frame = frame;
+
+				std::fill(visited.begin(), visited.end(), false);
+				uint64_t head = 0;
+				uint64_t first = std::numeric_limits<uint64_t>::max();
+				uint64_t last = 0;
+				for (const SampleGroup &samples : tree.sampleGroups) {
+					for (uint32_t blockIndex : samples.stored[samples.storedIndex(frame)]) {
+						const Block &b = tree.blocks[blockIndex];
+						if (b.size == 0 || visited[blockIndex]) {
+							continue;
+						}
+						visited[blockIndex] = true;
+						if (f.blocks != 0) {
+							f.seekDistance += b.pos < head ? head - b.pos : b.pos - head;
+						}
+						head = b.pos + 8 + b.size;
+
+						f.blocks++;
+						f.bytes += 8 + b.size;
+						first = std::min(first, b.pos);
+						last = std::max(last, head);
+					}
+				}
+				f.span = f.blocks == 0 ? 0 : last - first;
+				f.locality = f.span == 0 ? 1.0 : (double)f.bytes / (double)f.span;
+				report.frames.push_back(f);
+			}
+
+			report.properties = std::move(properties);
+			std::sort(report.properties.begin(), report.properties.end(), [](const ArchiveReport::Property &a, const ArchiveReport::Property &b) {
+				return a.bytesOnDisk > b.bytesOnDisk;
+			});
+			for (const auto &object : objects) {
+				report.objects.push_back(object.second);
+			}
+			std::sort(report.objects.begin(), report.objects.end(), [](const ArchiveReport::Object &a, const ArchiveReport::Object &b) {
+				return a.bytesOnDisk > b.bytesOnDisk;
+			});
+		}
+		catch (std::exception &e) {
+			error_message = e.what();
+			return false;
+		}
+		return true;
+	}
+
+	bool writeArchiveReport(const ArchiveReport &report, const std::string &jsonPath, std::string &error_message) {
+		using ogawa_tree::write_json_string;
+
+		std::ofstream stream(jsonPath, std::ios::binary);
+		if (!stream) {
+			error_message = "can't open " + jsonPath;
+			return false;
+		}
+		stream << "{\"fileBytes\":" << report.fileBytes << ",\"frameCount\":" << report.frameCount << ",\n";
+
+		stream << "\"properties\":[";
+		for (std::size_t i = 0; i < report.properties.size(); ++i) {
+			const ArchiveReport::Property &p = report.properties[i];
+			stream << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+			write_json_string(stream, p.name);
+			stream << ",\"object\":";
+			write_json_string(stream, p.object);
+			stream << ",\"pod\":";
+			write_json_string(stream, p.pod);
+			stream << ",\"geoScope\":";
+			write_json_string(stream, p.geoScope);
+			stream << ",\"array\":" << (p.array ? "true" : "false")
+				<< ",\"numSamples\":" << p.numSamples
+				<< ",\"storedSamples\":" << p.storedSamples
+				<< ",\"constant\":" << (p.constant ? "true" : "false")
+				<< ",\"bytesOnDisk\":" << p.bytesOnDisk
+				<< ",\"duplicateSamples\":" << p.duplicateSamples
+				<< ",\"duplicateBytes\":" << p.duplicateBytes
+				<< ",\"duplicateRatio\":" << (p.bytesOnDisk == 0 ? 0.0 : (double)p.duplicateBytes / (double)p.bytesOnDisk)
+				<< ",\"convertedOnAccess\":" << (p.convertedOnAccess ? "true" : "false") << "}";
+		}
+		stream << "],\n";
+
+		stream << "\"objects\":[";
+		for (std::size_t i = 0; i < report.objects.size(); ++i) {
+			const ArchiveReport::Object &o = report.objects[i];
+			stream << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+			write_json_string(stream, o.name);
+			stream << ",\"bytesOnDisk\":" << o.bytesOnDisk
+				<< ",\"properties\":" << o.properties
+				<< ",\"animatedProperties\":" << o.animatedProperties << "}";
+		}
+		stream << "],\n";
+
+		stream << "\"frames\":[";
+		for (std::size_t i = 0; i < report.frames.size(); ++i) {
+			const ArchiveReport::Frame &f = report.frames[i];
+			stream << (i == 0 ? "\n" : ",\n")
+				<< "{\"frame\":" << f.frame
+				<< ",\"blocks\":" << f.blocks
+				<< ",\"bytes\":" << f.bytes
+				<< ",\"span\":" << f.span
+				<< ",\"seekDistance\":" << f.seekDistance
+				<< ",\"locality\":" << f.locality << "}";
+		}
+		stream << "]}\n";
+
+		if (!stream) {
+			error_message = "can't write " + jsonPath;
+			return false;
+		}
+		return true;
+	}
+}
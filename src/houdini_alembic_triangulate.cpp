@@ -0,0 +1,299 @@
+﻿#include "houdini_alembic.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace houdini_alembic {
+	namespace {
+		// 小さなメッシュは分けない
+		const uint32_t kFacesPerChunk = 2048;
+
+		inline uint32_t triangles_of(uint32_t faceCount) {
+			return faceCount < 3 ? 0 : faceCount - 2;
+		}
+
+		/*
+		 Exclusive prefix sums of the face vertices and the triangles, with the totals at the end.
+		 Every chunk sums its faces, the sums of the chunks are scanned, then every chunk writes its offsets from there.
+		*/
+		inline bool scan_offsets(const std::vector<uint32_t> &faceCounts, uint32_t chunkCount, TaskExecutor &executor, std::vector<uint32_t> &faceOffsets, std::vector<uint32_t> &triangleOffsets, uint64_t &vertexCount) {
+			const uint32_t faceCount = (uint32_t)faceCounts.size();
+			auto chunk_begin = [&](uint32_t chunk) {
+				return (uint32_t)((uint64_t)faceCount * chunk / chunkCount);
+			};
+
+			std::vector<uint64_t> vertexSums(chunkCount + 1);
+			std::vector<uint64_t> triangleSums(chunkCount + 1);
+			executor.parallelFor(chunkCount, [&](uint32_t chunk) {
+				uint64_t vertices = 0;
+				uint64_t triangles = 0;
+				for (uint32_t face = chunk_begin(chunk); face < chunk_begin(chunk + 1); ++face) {
+					vertices += faceCounts[face];
+					triangles += triangles_of(faceCounts[face]);
+				}
+				vertexSums[chunk + 1] = vertices;
+				triangleSums[chunk + 1] = triangles;
+			});
+			for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+				vertexSums[chunk + 1] += vertexSums[chunk];
+				triangleSums[chunk + 1] += triangleSums[chunk];
+			}
+			vertexCount = vertexSums[chunkCount];
+			if (UINT32_MAX < vertexSums[chunkCount] || UINT32_MAX / 3 < triangleSums[chunkCount]) {
+				return false;
+			}
+
+			faceOffsets.resize(faceCount + 1);
+			triangleOffsets.resize(faceCount + 1);
+			executor.parallelFor(chunkCount, [&](uint32_t chunk) {
+				uint32_t vertices = (uint32_t)vertexSums[chunk];
+				uint32_t triangles = (uint32_t)triangleSums[chunk];
+				for (uint32_t face = chunk_begin(chunk); face < chunk_begin(chunk + 1); ++face) {
+					faceOffsets[face] = vertices;
+					triangleOffsets[face] = triangles;
+					vertices += faceCounts[face];
+					triangles += triangles_of(faceCounts[face]);
+				}
+			});
+			faceOffsets[faceCount] = (uint32_t)vertexSums[chunkCount];
+			triangleOffsets[faceCount] = (uint32_t)triangleSums[chunkCount];
+			return true;
+		}
+
+		/*
+		 Ear clipping in the plane the face is the most parallel to.
+		 Corners are written as face vertices relative to the face, in the winding order of the face.
+		 A face that has no ear left (self intersecting, degenerate) is fanned from there.
+		*/
+		class EarClipper {
+		public:
+			void clip(const Vector3f *P, const uint32_t *faceIndices, uint32_t n, uint32_t *corners) {
+				// Newellの方法で面の法線を求める
+				float normal[3] = { 0.0f, 0.0f, 0.0f };
+				for (uint32_t i = 0; i < n; ++i) {
+					const Vector3f &a = P[faceIndices[i]];
+					const Vector3f &b = P[faceIndices[(i + 1) % n]];
+					normal[0] += (a.y - b.y) * (a.z + b.z);
+					normal[1] += (a.z - b.z) * (a.x + b.x);
+					normal[2] += (a.x - b.x) * (a.y + b.y);
+				}
+				int axis = 0;
+				for (int i = 1; i < 3; ++i) {
+					if (std::fabs(normal[axis]) < std::fabs(normal[i])) {
+						axis = i;
+					}
+				}
+				// (u, v) は法線が正の向きに見て反時計回りになる軸の組
+				const float sign = normal[axis] < 0.0f ? -1.0f : 1.0f;
+				_u.resize(n);
+				_v.resize(n);
+				for (uint32_t i = 0; i < n; ++i) {
+					const Vector3f &p = P[faceIndices[i]];
+					switch (axis) {
+					case 0: _u[i] = p.y; _v[i] = p.z; break;
+					case 1: _u[i] = p.z; _v[i] = p.x; break;
+					default: _u[i] = p.x; _v[i] = p.y; break;
+					}
+				}
+
+				_remaining.resize(n);
+				for (uint32_t i = 0; i < n; ++i) {
+					_remaining[i] = i;
+				}
+				while (3 < _remaining.size()) {
+					uint32_t count = (uint32_t)_remaining.size();
+					bool clipped = false;
+					for (uint32_t i = 0; i < count; ++i) {
+						uint32_t a = _remaining[(i + count - 1) % count];
+						uint32_t b = _remaining[i];
+						uint32_t c = _remaining[(i + 1) % count];
+						if (isEar(a, b, c, sign)) {
+							corners[0] = a;
+							corners[1] = b;
+							corners[2] = c;
+							corners += 3;
+							_remaining.erase(_remaining.begin() + i);
+							clipped = true;
+							break;
+						}
+					}
+					if (clipped == false) {
+						break;
+					}
+				}
+				for (uint32_t i = 1; i + 1 < _remaining.size(); ++i) {
+					corners[0] = _remaining[0];
+					corners[1] = _remaining[i];
+					corners[2] = _remaining[i + 1];
+					corners += 3;
+				}
+			}
+		private:
+			float cross(uint32_t a, uint32_t b, uint32_t c) const {
+				return (_u[b] - _u[a]) * (_v[c] - _v[a]) - (_v[b] - _v[a]) * (_u[c] - _u[a]);
+			}
+			bool isEar(uint32_t a, uint32_t b, uint32_t c, float sign) const {
+				if (cross(a, b, c) * sign <= 0.0f) {
+					return false;
+				}
+				for (uint32_t p : _remaining) {
+					if (p == a || p == b || p == c) {
+						continue;
+					}
+					// 同じ位置の点 (穴へのブリッジなど) は内側とみなさない
+					if ((_u[p] == _u[a] && _v[p] == _v[a]) || (_u[p] == _u[b] && _v[p] == _v[b]) || (_u[p] == _u[c] && _v[p] == _v[c])) {
+						continue;
+					}
+					if (0.0f <= cross(a, b, p) * sign && 0.0f <= cross(b, c, p) * sign && 0.0f <= cross(c, a, p) * sign) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			std::vector<float> _u;
+			std::vector<float> _v;
+			std::vector<uint32_t> _remaining;
+		};
+
+		inline bool same_topology(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b) {
+			return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(uint32_t)) == 0);
+		}
+
+		struct TriangulationCacheContext {
+			TriangulationMethod method = TriangulationMethod_EarClip;
+			std::shared_ptr<TaskExecutor> executor;
+
+			struct Entry {
+				std::vector<uint32_t> faceCounts;
+				std::vector<uint32_t> indices;
+				std::shared_ptr<const Triangulation> triangulation;
+			};
+			std::mutex mutex;
+			std::unordered_map<std::string, std::shared_ptr<const Entry>> entries;
+			uint32_t hits = 0;
+			uint32_t misses = 0;
+		};
+	}
+
+	std::shared_ptr<Triangulation> triangulate(const PolygonMeshObject &polymesh, TriangulationMethod method, std::string &error_message, TaskExecutor *executor) {
+		std::shared_ptr<TaskExecutor> shared;
+		if (executor == nullptr) {
+			shared = TaskExecutor::shared();
+			executor = shared.get();
+		}
+		const uint32_t faceCount = (uint32_t)polymesh.faceCounts.size();
+		const uint32_t chunkCount = std::max(std::min((faceCount + kFacesPerChunk - 1) / kFacesPerChunk, (executor->workerCount() + 1) * 4), 1u);
+
+		std::shared_ptr<Triangulation> triangulation(new Triangulation());
+		uint64_t vertexCount = 0;
+		if (scan_offsets(polymesh.faceCounts, chunkCount, *executor, triangulation->faceOffsets, triangulation->triangleOffsets, vertexCount) == false) {
+			error_message = "too many triangles";
+			return std::shared_ptr<Triangulation>();
+		}
+		if (vertexCount != polymesh.indices.size()) {
+			error_message = "faceCounts and indices do not match";
+			return std::shared_ptr<Triangulation>();
+		}
+		if (method == TriangulationMethod_EarClip) {
+			for (uint32_t index : polymesh.indices) {
+				if (polymesh.P.size() <= index) {
+					error_message = "indices out of P";
+					return std::shared_ptr<Triangulation>();
+				}
+			}
+		}
+
+		uint32_t triangleCount = triangulation->triangleOffsets[faceCount];
+		triangulation->vertices.resize((std::size_t)triangleCount * 3);
+		triangulation->indices.resize((std::size_t)triangleCount * 3);
+		triangulation->triangleFaces.resize(triangleCount);
+
+		executor->parallelFor(chunkCount, [&](uint32_t chunk) {
+			EarClipper clipper;
+			uint32_t begin = (uint32_t)((uint64_t)faceCount * chunk / chunkCount);
+			uint32_t end = (uint32_t)((uint64_t)faceCount * (chunk + 1) / chunkCount);
+			for (uint32_t face = begin; face < end; ++face) {
+				uint32_t n = polymesh.faceCounts[face];
+				if (n < 3) {
+					continue;
+				}
+				uint32_t offset = triangulation->faceOffsets[face];
+				uint32_t t = triangulation->triangleOffsets[face];
+				uint32_t *corners = triangulation->vertices.data() + (std::size_t)t * 3;
+				if (n == 3 || method == TriangulationMethod_Fan) {
+					for (uint32_t i = 1; i + 1 < n; ++i) {
+						corners[(i - 1) * 3 + 0] = 0;
+						corners[(i - 1) * 3 + 1] = i;
+						corners[(i - 1) * 3 + 2] = i + 1;
+					}
+				}
+				else {
+					clipper.clip(polymesh.P.data(), polymesh.indices.data() + offset, n, corners);
+				}
+				for (uint32_t i = 0; i < (n - 2) * 3; ++i) {
+					corners[i] += offset;
+					triangulation->indices[(std::size_t)t * 3 + i] = polymesh.indices[corners[i]];
+				}
+				std::fill(triangulation->triangleFaces.begin() + t, triangulation->triangleFaces.begin() + t + (n - 2), face);
+			}
+		});
+		return triangulation;
+	}
+
+	TriangulationCache::TriangulationCache(TriangulationMethod method, std::shared_ptr<TaskExecutor> executor) {
+		std::shared_ptr<TriangulationCacheContext> context(new TriangulationCacheContext());
+		context->method = method;
+		context->executor = executor;
+		_context = context;
+	}
+	std::shared_ptr<const Triangulation> TriangulationCache::triangulate(const PolygonMeshObject &polymesh, std::string &error_message) {
+		auto context = static_cast<TriangulationCacheContext *>(_context.get());
+
+		std::shared_ptr<const TriangulationCacheContext::Entry> entry;
+		{
+			std::lock_guard<std::mutex> lock(context->mutex);
+			auto it = context->entries.find(polymesh.name);
+			if (it != context->entries.end()) {
+				entry = it->second;
+			}
+		}
+		// 比べるのはロックの外で
+		if (entry && same_topology(entry->faceCounts, polymesh.faceCounts) && same_topology(entry->indices, polymesh.indices)) {
+			std::lock_guard<std::mutex> lock(context->mutex);
+			context->hits++;
+			return entry->triangulation;
+		}
+
+		std::shared_ptr<TriangulationCacheContext::Entry> updated(new TriangulationCacheContext::Entry());
+		updated->triangulation = houdini_alembic::triangulate(polymesh, context->method, error_message, context->executor.get());
+		if (!updated->triangulation) {
+			return std::shared_ptr<const Triangulation>();
+		}
+		updated->faceCounts = polymesh.faceCounts;
+		updated->indices = polymesh.indices;
+
+		std::lock_guard<std::mutex> lock(context->mutex);
+		context->misses++;
+		context->entries[polymesh.name] = updated;
+		return updated->triangulation;
+	}
+	void TriangulationCache::clear() {
+		auto context = static_cast<TriangulationCacheContext *>(_context.get());
+		std::lock_guard<std::mutex> lock(context->mutex);
+		context->entries.clear();
+		context->hits = 0;
+		context->misses = 0;
+	}
+	uint32_t TriangulationCache::hits() const {
+		auto context = static_cast<TriangulationCacheContext *>(_context.get());
+		std::lock_guard<std::mutex> lock(context->mutex);
+		return context->hits;
+	}
+	uint32_t TriangulationCache::misses() const {
+		auto context = static_cast<TriangulationCacheContext *>(_context.get());
+		std::lock_guard<std::mutex> lock(context->mutex);
+		return context->misses;
+	}
+}
@@ -0,0 +1,698 @@
+﻿#include "houdini_alembic.hpp"
+
+#include <Alembic/Abc/All.h>
+#include <Alembic/AbcCoreOgawa/All.h>
+#include <Alembic/AbcGeom/All.h>
+
+#include <functional>
+#include <map>
+#include <unordered_map>
+
+namespace houdini_alembic {
+	using namespace Alembic::Abc;
+	using namespace Alembic::AbcGeom;
+
+	inline M44d to_m44d(const Matrix4x4f &m) {
+		M44d r;
+		for (int i = 0; i < 16; ++i) {
+			r.getValue()[i] = m.value[i];
+		}
+		return r;
+	}
+
+	// 属性ごとの変換は独立しているのでタスクに分ける
+	inline void run_parallel(const std::vector<std::function<void()>> &tasks) {
+		TaskExecutor::shared()->parallelFor((uint32_t)tasks.size(), [&tasks](uint32_t i) {
+			tasks[i]();
+		});
+	}
+
+	/*
+	 Sample counting shared by everything we write.
+	 Every property must end each frame with (frame + 1) samples, so a late property repeats its first sample,
+	 and a property without data for this frame repeats the previous one. Visibility is the exception, see WriterXform::writeVisible().
+	*/
+	template <class SetSample>
+	void set_until(uint32_t &samples, uint32_t frame, SetSample setSample) {
+		while (samples <= frame) {
+			setSample();
+			samples++;
+		}
+	}
+	template <class SetFromPrevious>
+	void hold_until(uint32_t &samples, uint32_t frame, SetFromPrevious setFromPrevious) {
+		while (0 < samples && samples <= frame) {
+			setFromPrevious();
+			samples++;
+		}
+	}
+
+	inline uint32_t vector_extent(AttributeType type) {
+		switch (type) {
+		case AttributeType_Vector2: return 2;
+		case AttributeType_Vector3: return 3;
+		case AttributeType_Vector4: return 4;
+		default: return 1;
+		}
+	}
+
+	class WriterAttribute {
+	public:
+		WriterAttribute(OCompoundProperty parent, const std::string &key, const AttributeColumn *column, GeometryScope scope, uint32_t timeSampling)
+			:_type(column->attributeType()), _scope(scope) {
+			switch (_type) {
+			case AttributeType_Int:
+				_ints = OInt32GeomParam(parent, key, false, scope, 1, timeSampling);
+				break;
+			case AttributeType_String:
+				// Houdiniと同じく文字列は重複を除いてインデックスで書く
+				_strings = OStringGeomParam(parent, key, true, scope, 1, timeSampling);
+				break;
+			default:
+				_floats = OFloatGeomParam(parent, key, false, scope, vector_extent(_type), timeSampling);
+				break;
+			}
+		}
+
+		bool accepts(const AttributeColumn *column, GeometryScope scope) const {
+			return column->attributeType() == _type && scope == _scope;
+		}
+
+		// runs in parallel with other attributes
+		void encode(const AttributeColumn *column) {
+			uint32_t rowCount = column->rowCount();
+			switch (_type) {
+			case AttributeType_Int: {
+				auto c = static_cast<const AttributeIntColumn *>(column);
+				_intBuffer.resize(rowCount);
+				for (uint32_t i = 0; i < rowCount; ++i) {
+					_intBuffer[i] = c->get(i);
+				}
+				break;
+			}
+			case AttributeType_Float: {
+				auto c = static_cast<const AttributeFloatColumn *>(column);
+				_floatBuffer.resize(rowCount);
+				for (uint32_t i = 0; i < rowCount; ++i) {
+					_floatBuffer[i] = c->get(i);
+				}
+				break;
+			}
+			case AttributeType_Vector2:
+				encode_vector(static_cast<const AttributeVector2Column *>(column), 2);
+				break;
+			case AttributeType_Vector3:
+				encode_vector(static_cast<const AttributeVector3Column *>(column), 3);
+				break;
+			case AttributeType_Vector4:
+				encode_vector(static_cast<const AttributeVector4Column *>(column), 4);
+				break;
+			case AttributeType_String: {
+				auto c = static_cast<const AttributeStringColumn *>(column);
+				_stringBuffer.clear();
+				_stringIndices.clear();
+				_indexBuffer.resize(rowCount);
+				for (uint32_t i = 0; i < rowCount; ++i) {
+					const std::string &value = c->get(i);
+					auto it = _stringIndices.find(value);
+					if (it == _stringIndices.end()) {
+						it = _stringIndices.emplace(value, (uint32_t)_stringBuffer.size()).first;
+						_stringBuffer.push_back(value);
+					}
+					_indexBuffer[i] = it->second;
+				}
+				break;
+			}
+			}
+		}
+
+		void write(uint32_t frame) {
+			set_until(_samples, frame, [&]() {
+				switch (_type) {
+				case AttributeType_Int:
+					_ints.set(OInt32GeomParam::Sample(Int32ArraySample(_intBuffer), _ints.getScope()));
+					break;
+				case AttributeType_String:
+					_strings.set(OStringGeomParam::Sample(StringArraySample(_stringBuffer), UInt32ArraySample(_indexBuffer), _strings.getScope()));
+					break;
+				default:
+					_floats.set(OFloatGeomParam::Sample(FloatArraySample(_floatBuffer), _floats.getScope()));
+					break;
+				}
+			});
+		}
+		void hold(uint32_t frame) {
+			hold_until(_samples, frame, [&]() {
+				switch (_type) {
+				case AttributeType_Int:
+					_ints.setFromPrevious();
+					break;
+				case AttributeType_String:
+					_strings.setFromPrevious();
+					break;
+				default:
+					_floats.setFromPrevious();
+					break;
+				}
+			});
+		}
+	private:
+		template <class Column>
+		void encode_vector(const Column *column, uint32_t extent) {
+			uint32_t rowCount = column->rowCount();
+			_floatBuffer.resize(rowCount * extent);
+			for (uint32_t i = 0; i < rowCount; ++i) {
+				column->get(i, _floatBuffer.data() + i * extent);
+			}
+		}
+
+		AttributeType _type;
+		GeometryScope _scope;
+		uint32_t _samples = 0;
+
+		OFloatGeomParam _floats;
+		OInt32GeomParam _ints;
+		OStringGeomParam _strings;
+
+		// フレーム間で使い回す
+		std::vector<float> _floatBuffer;
+		std::vector<int32_t> _intBuffer;
+		std::vector<std::string> _stringBuffer;
+		std::vector<uint32_t> _indexBuffer;
+		std::unordered_map<std::string, uint32_t> _stringIndices;
+	};
+
+	/*
+	 An arbGeomParams compound and the attributes written into it
+	*/
+	class WriterAttributes {
+	public:
+		void bind(OCompoundProperty arbGeomParams, uint32_t timeSampling) {
+			_arbGeomParams = arbGeomParams;
+			_timeSampling = timeSampling;
+		}
+
+		// pairs the sheet columns with attributes and queues their encoding
+		void collect(const AttributeSpreadSheet &sheet, GeometryScope scope, const std::vector<std::string> &skip, std::vector<std::function<void()>> &tasks) {
+			for (const auto &attribute : sheet.sheet) {
+				if (std::find(skip.begin(), skip.end(), attribute.key) != skip.end()) {
+					continue;
+				}
+				const AttributeColumn *column = attribute.column.get();
+
+				auto it = _attributes.find(attribute.key);
+				if (it == _attributes.end()) {
+					std::unique_ptr<WriterAttribute> w(new WriterAttribute(_arbGeomParams, attribute.key, column, scope, _timeSampling));
+					it = _attributes.emplace(attribute.key, std::move(w)).first;
+				}
+				WriterAttribute *w = it->second.get();
+				if (w->accepts(column, scope) == false) {
+					// arbGeomParamsは名前が一意なので、別スコープの同名属性や型の変わった属性は書けない
+					continue;
+				}
+				_pending.push_back(w);
+				tasks.emplace_back([w, column]() { w->encode(column); });
+			}
+		}
+		void write(uint32_t frame) {
+			for (WriterAttribute *w : _pending) {
+				w->write(frame);
+			}
+			_pending.clear();
+			hold(frame);
+		}
+		void hold(uint32_t frame) {
+			for (auto &attribute : _attributes) {
+				attribute.second->hold(frame);
+			}
+		}
+	private:
+		OCompoundProperty _arbGeomParams;
+		uint32_t _timeSampling = 0;
+		std::map<std::string, std::unique_ptr<WriterAttribute>> _attributes;
+		std::vector<WriterAttribute *> _pending;
+	};
+
+	class WriterXform {
+	public:
+		WriterXform(OObject parent, const std::string &name, uint32_t timeSampling)
+			: _xform(parent, name, timeSampling) {
+		}
+		void write(const Matrix4x4f &m, uint32_t frame) {
+			if (frame < _samples) {
+				// another object under this xform already wrote it
+				return;
+			}
+			XformSample sample;
+			sample.setMatrix(to_m44d(m));
+			set_until(_samples, frame, [&]() { _xform.getSchema().set(sample); });
+		}
+		void writeVisible(bool visible, uint32_t frame) {
+			if (!_visible) {
+				_visible = CreateVisibilityProperty(_xform, _xform.getSchema().getTimeSampling());
+			}
+			// AlembicStorageは -1 (deferred) を可視とする
+			int8_t value = visible ? kVisibilityDeferred : kVisibilityHidden;
+			if (frame < _visibleSamples) {
+				return;
+			}
+			// 現れる前のフレームには無かったので、最初のサンプルで埋めずに不可視にする
+			if (0 < frame) {
+				set_until(_visibleSamples, frame - 1, [&]() { _visible.set(kVisibilityHidden); });
+			}
+			set_until(_visibleSamples, frame, [&]() { _visible.set(value); });
+		}
+		void hold(uint32_t frame) {
+			hold_until(_samples, frame, [&]() { _xform.getSchema().setFromPrevious(); });
+			writeHiddenIfOwned(frame);
+		}
+		OXform &xform() {
+			return _xform;
+		}
+	private:
+		void writeHiddenIfOwned(uint32_t frame) {
+			if (_visible) {
+				set_until(_visibleSamples, frame, [&]() { _visible.set(kVisibilityHidden); });
+			}
+		}
+
+		OXform _xform;
+		uint32_t _samples = 0;
+		OVisibilityProperty _visible;
+		uint32_t _visibleSamples = 0;
+	};
+
+	class WriterObject {
+	public:
+		virtual ~WriterObject() {}
+
+		// encode attributes (queued to tasks), then write() them on the calling thread
+		virtual void collect(const SceneObject *object, std::vector<std::function<void()>> &tasks) = 0;
+		virtual void write(const SceneObject *object, uint32_t frame) = 0;
+		virtual void hold(uint32_t frame) = 0;
+
+		std::vector<WriterXform *> _xforms;
+	protected:
+		void writeXforms(const SceneObject *object, uint32_t frame) {
+			for (std::size_t i = 0; i < _xforms.size(); ++i) {
+				Matrix4x4f m;
+				if (i < object->xforms.size()) {
+					m = object->xforms[i];
+				}
+				else {
+					m = to_identity();
+				}
+				_xforms[i]->write(m, frame);
+			}
+			_xforms.back()->writeVisible(object->visible, frame);
+		}
+		static Matrix4x4f to_identity() {
+			Matrix4x4f m;
+			m.value.fill(0.0f);
+			m.value[0] = m.value[5] = m.value[10] = m.value[15] = 1.0f;
+			return m;
+		}
+	};
+
+	inline void fill_vertices(std::vector<uint32_t> &indices, uint32_t n) {
+		indices.resize(n);
+		for (uint32_t i = 0; i < n; ++i) {
+			indices[i] = i;
+		}
+	}
+
+	class WriterPolygonMesh : public WriterObject {
+	public:
+		WriterPolygonMesh(OObject parent, const std::string &name, uint32_t timeSampling)
+			: _polyMesh(parent, name, timeSampling) {
+			_attributes.bind(_polyMesh.getSchema().getArbGeomParams(), timeSampling);
+		}
+		void collect(const SceneObject *object, std::vector<std::function<void()>> &tasks) override {
+			auto polygon = static_cast<const PolygonMeshObject *>(object);
+
+			// N, uv (vertices) はスキーマ側に書く
+			static const TypedAttributeHandle<AttributeVector3Column> kN("N");
+			static const TypedAttributeHandle<AttributeVector2Column> kUV("uv");
+			_N = polygon->vertices.column(kN);
+			_uv = polygon->vertices.column(kUV);
+			if (_N) {
+				tasks.emplace_back([this]() {
+					_NBuffer.resize(_N->rowCount());
+					for (uint32_t i = 0; i < _N->rowCount(); ++i) {
+						_N->get(i, &_NBuffer[i].x);
+					}
+				});
+			}
+			if (_uv) {
+				tasks.emplace_back([this]() {
+					_uvBuffer.resize(_uv->rowCount());
+					for (uint32_t i = 0; i < _uv->rowCount(); ++i) {
+						_uv->get(i, &_uvBuffer[i].x);
+					}
+					fill_vertices(_uvIndices, _uv->rowCount());
+				});
+			}
+
+			std::vector<std::string> vertexSkip;
+			if (_N) {
+				vertexSkip.push_back("N");
+			}
+			if (_uv) {
+				vertexSkip.push_back("uv");
+			}
+			_attributes.collect(polygon->points, kVaryingScope, { "P" }, tasks);
+			_attributes.collect(polygon->vertices, kFacevaryingScope, vertexSkip, tasks);
+			_attributes.collect(polygon->primitives, kUniformScope, {}, tasks);
+			_attributes.collect(polygon->details, kConstantScope, {}, tasks);
+		}
+		void write(const SceneObject *object, uint32_t frame) override {
+			auto polygon = static_cast<const PolygonMeshObject *>(object);
+			writeXforms(object, frame);
+
+			OPolyMeshSchema::Sample sample(
+				P3fArraySample((const V3f *)polygon->P.data(), polygon->P.size()),
+				Int32ArraySample((const int32_t *)polygon->indices.data(), polygon->indices.size()),
+				Int32ArraySample((const int32_t *)polygon->faceCounts.data(), polygon->faceCounts.size())
+			);
+			if (_N) {
+				sample.setNormals(ON3fGeomParam::Sample(N3fArraySample(_NBuffer), kFacevaryingScope));
+			}
+			if (_uv) {
+				sample.setUVs(OV2fGeomParam::Sample(V2fArraySample(_uvBuffer), UInt32ArraySample(_uvIndices), kFacevaryingScope));
+			}
+			set_until(_samples, frame, [&]() { _polyMesh.getSchema().set(sample); });
+
+			_attributes.write(frame);
+		}
+		void hold(uint32_t frame) override {
+			hold_until(_samples, frame, [&]() { _polyMesh.getSchema().setFromPrevious(); });
+			_attributes.hold(frame);
+		}
+	private:
+		OPolyMesh _polyMesh;
+		uint32_t _samples = 0;
+		WriterAttributes _attributes;
+
+		const AttributeVector3Column *_N = nullptr;
+		const AttributeVector2Column *_uv = nullptr;
+		std::vector<N3f> _NBuffer;
+		std::vector<V2f> _uvBuffer;
+		std::vector<uint32_t> _uvIndices;
+	};
+
+	class WriterPoint : public WriterObject {
+	public:
+		WriterPoint(OObject parent, const std::string &name, uint32_t timeSampling)
+			: _points(parent, name, timeSampling) {
+			_attributes.bind(_points.getSchema().getArbGeomParams(), timeSampling);
+		}
+		void collect(const SceneObject *object, std::vector<std::function<void()>> &tasks) override {
+			auto point = static_cast<const PointObject *>(object);
+			_attributes.collect(point->points, kVaryingScope, { "P" }, tasks);
+			_attributes.collect(point->details, kConstantScope, {}, tasks);
+		}
+		void write(const SceneObject *object, uint32_t frame) override {
+			auto point = static_cast<const PointObject *>(object);
+			writeXforms(object, frame);
+
+			// 量子化して読んだ点はPの列にしかない
+			const std::vector<Vector3f> *P = &point->P;
+			static const TypedAttributeHandle<AttributeVector3Column> kP("P");
+			auto column = point->points.column(kP);
+			if (P->empty() && column) {
+				_P.resize(column->rowCount());
+				column->getRows(0, (uint32_t)_P.size(), (float *)_P.data());
+				P = &_P;
+			}
+
+			const std::vector<uint64_t> *ids = &point->pointIds;
+			if (ids->size() != P->size()) {
+				_ids.resize(P->size());
+				for (uint64_t i = 0; i < _ids.size(); ++i) {
+					_ids[i] = i;
+				}
+				ids = &_ids;
+			}
+			OPointsSchema::Sample sample(
+				P3fArraySample((const V3f *)P->data(), P->size()),
+				UInt64ArraySample(*ids)
+			);
+			set_until(_samples, frame, [&]() { _points.getSchema().set(sample); });
+
+			_attributes.write(frame);
+		}
+		void hold(uint32_t frame) override {
+			hold_until(_samples, frame, [&]() { _points.getSchema().setFromPrevious(); });
+			_attributes.hold(frame);
+		}
+	private:
+		OPoints _points;
+		uint32_t _samples = 0;
+		WriterAttributes _attributes;
+		std::vector<uint64_t> _ids;
+		std::vector<Vector3f> _P;
+	};
+
+	class WriterCurve : public WriterObject {
+	public:
+		WriterCurve(OObject parent, const std::string &name, uint32_t timeSampling)
+			: _curves(parent, name, timeSampling) {
+			_attributes.bind(_curves.getSchema().getArbGeomParams(), timeSampling);
+		}
+		void collect(const SceneObject *object, std::vector<std::function<void()>> &tasks) override {
+			auto curve = static_cast<const CurveObject *>(object);
+			_attributes.collect(curve->points, kVaryingScope, { "P" }, tasks);
+			_attributes.collect(curve->vertices, kFacevaryingScope, {}, tasks);
+			_attributes.collect(curve->primitives, kUniformScope, {}, tasks);
+			_attributes.collect(curve->details, kConstantScope, {}, tasks);
+		}
+		void write(const SceneObject *object, uint32_t frame) override {
+			auto curve = static_cast<const CurveObject *>(object);
+			writeXforms(object, frame);
+
+			_numVertices.resize(curve->curvePrimitives.size());
+			for (std::size_t i = 0; i < _numVertices.size(); ++i) {
+				_numVertices[i] = curve->curvePrimitives[i].P_end_index - curve->curvePrimitives[i].P_beg_index;
+			}
+			OCurvesSchema::Sample sample(
+				P3fArraySample((const V3f *)curve->P.data(), curve->P.size()),
+				Int32ArraySample(_numVertices),
+				kLinear,
+				kNonPeriodic
+			);
+			set_until(_samples, frame, [&]() { _curves.getSchema().set(sample); });
+
+			_attributes.write(frame);
+		}
+		void hold(uint32_t frame) override {
+			hold_until(_samples, frame, [&]() { _curves.getSchema().setFromPrevious(); });
+			_attributes.hold(frame);
+		}
+	private:
+		OCurves _curves;
+		uint32_t _samples = 0;
+		WriterAttributes _attributes;
+		std::vector<int32_t> _numVertices;
+	};
+
+	class WriterCamera : public WriterObject {
+	public:
+		WriterCamera(OObject parent, const std::string &name, uint32_t timeSampling)
+			: _camera(parent, name, timeSampling) {
+			OCompoundProperty userProperties = _camera.getSchema().getUserProperties();
+			_resx = OFloatProperty(userProperties, "resx", timeSampling);
+			_resy = OFloatProperty(userProperties, "resy", timeSampling);
+		}
+		void collect(const SceneObject *, std::vector<std::function<void()>> &) override {
+		}
+		void write(const SceneObject *object, uint32_t frame) override {
+			auto camera = static_cast<const CameraObject *>(object);
+			writeXforms(object, frame);
+
+			// AlembicStorageの読み込みの逆 (apertureはcm)
+			CameraSample sample;
+			sample.setFocalLength(camera->focalLength_mm);
+			sample.setHorizontalAperture(camera->aperture_horizontal_mm / 10.0);
+			sample.setVerticalAperture(camera->aperture_vertical_mm / 10.0);
+			sample.setNearClippingPlane(camera->nearClip);
+			sample.setFarClippingPlane(camera->farClip);
+			sample.setFocusDistance(camera->focusDistance);
+			sample.setFStop(camera->f_stop);
+
+			uint32_t samples = _samples;
+			set_until(_samples, frame, [&]() { _camera.getSchema().set(sample); });
+			set_until(samples, frame, [&]() {
+				_resx.set((float)camera->resolution_x);
+				_resy.set((float)camera->resolution_y);
+			});
+		}
+		void hold(uint32_t frame) override {
+			uint32_t samples = _samples;
+			hold_until(_samples, frame, [&]() { _camera.getSchema().setFromPrevious(); });
+			hold_until(samples, frame, [&]() {
+				_resx.setFromPrevious();
+				_resy.setFromPrevious();
+			});
+		}
+	private:
+		OCamera _camera;
+		uint32_t _samples = 0;
+		OFloatProperty _resx;
+		OFloatProperty _resy;
+	};
+
+	class WriterContext {
+	public:
+		OArchive _archive;
+		uint32_t _timeSampling = 0;
+		uint32_t _frameCount = 0;
+
+		// must be destroyed before the archive
+		std::map<std::string, std::unique_ptr<WriterXform>> _xforms;
+		std::map<std::string, std::unique_ptr<WriterObject>> _objects;
+
+		~WriterContext() {
+			// AlembicStorageはHoudiniと同じくトップの "1.samples" からフレーム数を得る
+			try {
+				OUInt32Property samples(_archive.getTop().getProperties(), "1.samples");
+				samples.set(_frameCount);
+			}
+			catch (std::exception &) {
+			}
+		}
+
+		WriterXform *xform(const std::string &path) {
+			auto it = _xforms.find(path);
+			if (it != _xforms.end()) {
+				return it->second.get();
+			}
+			std::size_t slash = path.find_last_of('/');
+			std::string parentPath = path.substr(0, slash);
+			std::string name = path.substr(slash + 1);
+
+			OObject parent = parentPath.empty() ? _archive.getTop() : xform(parentPath)->xform();
+			std::unique_ptr<WriterXform> w(new WriterXform(parent, name, _timeSampling));
+			return _xforms.emplace(path, std::move(w)).first->second.get();
+		}
+
+		WriterObject *object(const SceneObject *object, const std::string &id) {
+			auto it = _objects.find(id);
+			if (it != _objects.end()) {
+				return it->second.get();
+			}
+
+			// e.g. /geo/box -> xform /geo, xform /geo/box, shape /geo/box/boxShape
+			std::string name = object->name.empty() ? std::string("/object") : object->name;
+			if (name[0] != '/') {
+				name = "/" + name;
+			}
+			std::vector<WriterXform *> xforms;
+			for (std::size_t i = name.find('/', 1); ; i = name.find('/', i + 1)) {
+				xforms.push_back(xform(name.substr(0, i)));
+				if (i == std::string::npos) {
+					break;
+				}
+			}
+
+			OObject parent = xforms.back()->xform();
+			std::string shapeName = name.substr(name.find_last_of('/') + 1) + "Shape";
+			for (int i = 1; parent.getChildHeader(shapeName); ++i) {
+				shapeName = name.substr(name.find_last_of('/') + 1) + "Shape" + std::to_string(i);
+			}
+
+			std::unique_ptr<WriterObject> w;
+			switch (object->type()) {
+			case SceneObjectType_PolygonMesh:
+				w.reset(new WriterPolygonMesh(parent, shapeName, _timeSampling));
+				break;
+			case SceneObjectType_Point:
+				w.reset(new WriterPoint(parent, shapeName, _timeSampling));
+				break;
+			case SceneObjectType_Curve:
+				w.reset(new WriterCurve(parent, shapeName, _timeSampling));
+				break;
+			case SceneObjectType_Camera:
+				w.reset(new WriterCamera(parent, shapeName, _timeSampling));
+				break;
+			}
+			w->_xforms = xforms;
+			return _objects.emplace(id, std::move(w)).first->second.get();
+		}
+	};
+
+	bool AlembicWriter::open(const std::string &filePath, std::string &error_message, double framesPerSecond) {
+		try {
+			_context = std::shared_ptr<void>();
+
+			std::shared_ptr<WriterContext> context(new WriterContext());
+
+			// 大きな配列のキー (重複検出用のハッシュ) をこのアーカイブだけ分割して並列に計算する
+			context->_archive = OArchive(Alembic::AbcCoreOgawa::WriteArchive(true), filePath);
+
+			// Houdiniと同じく1フレーム目から
+			double timePerFrame = 1.0 / framesPerSecond;
+			context->_timeSampling = context->_archive.addTimeSampling(TimeSampling(timePerFrame, timePerFrame));
+			_context = context;
+		}
+		catch (std::exception &e) {
+			error_message = e.what();
+			return false;
+		}
+		return true;
+	}
+	bool AlembicWriter::isOpened() const {
+		return (bool)_context;
+	}
+	void AlembicWriter::close() {
+		_context = std::shared_ptr<void>();
+	}
+	uint32_t AlembicWriter::frameCount() const {
+		if (!_context) {
+			return 0;
+		}
+		return static_cast<WriterContext *>(_context.get())->_frameCount;
+	}
+	bool AlembicWriter::write(const AlembicScene &scene, std::string &error_message) {
+		if (!_context) {
+			error_message = "archive is not opened";
+			return false;
+		}
+		WriterContext *context = static_cast<WriterContext *>(_context.get());
+		uint32_t frame = context->_frameCount;
+
+		try {
+			std::vector<std::pair<WriterObject *, const SceneObject *>> written;
+			std::map<std::string, int> occurrences;
+			for (const auto &o : scene.objects) {
+				// 同名の別オブジェクトもあり得るので種類と出現順で区別する
+				std::string id = o->name + "|" + std::to_string(o->type());
+				id += "|" + std::to_string(occurrences[id]++);
+				written.emplace_back(context->object(o.get(), id), o.get());
+			}
+
+			std::vector<std::function<void()>> tasks;
+			for (auto &w : written) {
+				w.first->collect(w.second, tasks);
+			}
+			run_parallel(tasks);
+
+			// Alembicへの書き込みはシングルスレッド
+			for (auto &w : written) {
+				w.first->write(w.second, frame);
+			}
+			for (auto &o : context->_objects) {
+				o.second->hold(frame);
+			}
+			for (auto &x : context->_xforms) {
+				x.second->hold(frame);
+			}
+		}
+		catch (std::exception &e) {
+			error_message = e.what();
+			return false;
+		}
+
+		context->_frameCount++;
+		return true;
+	}
+}
@@ -426,6 +426,13 @@ void ofApp::open_alembic(std::string filePath) {
 		printf("open alembic error: %s\n", e.what());
 	}
 
+	if (_pending_cancellation) {
+		_pending_cancellation->cancel();
+	}
+	_pending = std::future<std::shared_ptr<houdini_alembic::AlembicScene>>();
+	_pending_index = -1;
+	_scene_index = -1;
+
 	std::string error_message;
 	if (_storage.open(filePath, error_message) == false) {
 		printf("AlembicStorage::open error: %s\n", error_message.c_str());
@@ -481,11 +488,29 @@ void ofApp::draw() {
 	ofSetColor(255);
 
 	if (_storage.isOpened()) {
-		std::string error_message;
+		// 読み終えたフレームがあれば差し替える
+		if (_pending.valid() && _pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+			try {
+				if (auto scene = _pending.get()) {
+					_scene = scene;
+					_scene_index = _pending_index;
+				}
+			}
+			catch (std::exception &e) {
+				printf("sample error_message: %s\n", e.what());
+				_scene_index = _pending_index;
+			}
+			_pending_index = -1;
+		}
 
-		_scene = _storage.read(sample_index, error_message);
-		if (!_scene) {
-			printf("sample error_message: %s\n", error_message.c_str());
+		// スクラブで通り過ぎたフレームは読むのをやめる
+		if (sample_index != _scene_index && sample_index != _pending_index) {
+			if (_pending_cancellation) {
+				_pending_cancellation->cancel();
+			}
+			_pending_cancellation = std::make_shared<houdini_alembic::ReadCancellation>();
+			_pending = _storage.read_async(sample_index, _pending_cancellation);
+			_pending_index = sample_index;
 		}
 	}
 
@@ -38,6 +38,12 @@ public:
 	IArchive _archive;
 	houdini_alembic::AlembicStorage _storage;
 	std::shared_ptr<houdini_alembic::AlembicScene> _scene;
+	int _scene_index = -1;
+
+	// 読み込み中のフレーム。描画はこれを待たない
+	std::future<std::shared_ptr<houdini_alembic::AlembicScene>> _pending;
+	std::shared_ptr<houdini_alembic::ReadCancellation> _pending_cancellation;
+	int _pending_index = -1;
 
 	ofMesh _camera_model;
 };
@@ -6,6 +6,37 @@
 
 #include "houdini_alembic.hpp"
 
+#include <Alembic/AbcCoreOgawa/ConvertKernels.h>
+#include <Alembic/AbcCoreOgawa/ReadUtil.h>
+#include <Alembic/AbcCoreAbstract/ArraySample.h>
+#include <Alembic/Util/Murmur3.h>
+#include <Alembic/Ogawa/All.h>
+#include <Alembic/AbcGeom/All.h>
+#include <Alembic/AbcCoreOgawa/All.h>
+
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <set>
+#include <thread>
+
+// ベンチマークでヒープ確保の回数を数える。アプリ全体の確保にかかるので、定義したときだけ置き換える
+#if defined(HOUDINI_ALEMBIC_COUNT_ALLOCATIONS)
+namespace {
+	std::atomic<uint64_t> g_allocation_count(0);
+}
+void *operator new(std::size_t size) {
+	g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+	if (void *p = std::malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+#endif
+
 void run_unit_test() {
 	static Catch::Session session;
 	session.run();
@@ -277,4 +308,2635 @@ TEST_CASE("polymesh_attributes.abc", "[polymesh_attributes]") {
 			REQUIRE(string_values->get(i) == ("index = " + std::to_string(i)));
 		}
 	}
-}
\ No newline at end of file
+}
+
+namespace {
+	void require_same_sheet(const houdini_alembic::AttributeSpreadSheet &a, const houdini_alembic::AttributeSpreadSheet &b) {
+		REQUIRE(a.columnCount() == b.columnCount());
+		for (int i = 0; i < a.columnCount(); ++i) {
+			const auto &attribute = a.sheet[i];
+			auto column = b.column(attribute.key.c_str());
+			INFO(attribute.key);
+			REQUIRE(column);
+			REQUIRE(column->attributeType() == attribute.column->attributeType());
+			REQUIRE(column->rowCount() == attribute.column->rowCount());
+			for (uint32_t j = 0; j < column->rowCount(); ++j) {
+				char expected[256];
+				char actual[256];
+				attribute.column->snprint(j, expected, sizeof(expected));
+				column->snprint(j, actual, sizeof(actual));
+				REQUIRE(std::string(expected) == std::string(actual));
+			}
+		}
+	}
+}
+
+TEST_CASE("AlembicWriter", "[writer]") {
+	using namespace houdini_alembic;
+
+	std::string error_message;
+	AlembicStorage polymeshStorage;
+	AlembicStorage pointStorage;
+	REQUIRE(polymeshStorage.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message));
+	REQUIRE(pointStorage.open(ofToDataPath("test_case/points_attributes.abc"), error_message));
+	auto polymeshScene = polymeshStorage.read(0, error_message);
+	auto pointScene = pointStorage.read(0, error_message);
+	REQUIRE(polymeshScene);
+	REQUIRE(pointScene);
+
+	// frame 0: polymesh, frame 1: polymesh + point, frame 2: point
+	AlembicScene both;
+	both.objects = polymeshScene->objects;
+	both.objects.insert(both.objects.end(), pointScene->objects.begin(), pointScene->objects.end());
+
+	std::string path = ofToDataPath("test_case/writer_roundtrip.abc");
+	{
+		AlembicWriter writer;
+		REQUIRE(writer.open(path, error_message));
+		REQUIRE(writer.write(*polymeshScene, error_message));
+		REQUIRE(writer.write(both, error_message));
+		REQUIRE(writer.write(*pointScene, error_message));
+		REQUIRE(writer.frameCount() == 3);
+		writer.close();
+	}
+
+	// 分割キーはアーカイブごとの設定で、グローバルな設定は変えない
+	REQUIRE(Alembic::AbcCoreAbstract::GetChunkedArraySampleKeys() == false);
+
+	{
+		AlembicStorage storage;
+		REQUIRE(storage.open(path, error_message));
+		REQUIRE(storage.frameCount() == 3);
+
+		auto frame0 = storage.read(0, error_message);
+		auto frame2 = storage.read(2, error_message);
+		REQUIRE(frame0);
+		REQUIRE(frame2);
+		REQUIRE(frame0->objects.size() == 2);
+		REQUIRE(frame2->objects.size() == 2);
+
+		auto polymesh = frame0->polygonMesh_FirstVisible();
+		auto source = polymeshScene->polygonMesh_FirstVisible();
+		REQUIRE(polymesh);
+		REQUIRE(polymesh->name == source->name);
+		REQUIRE(polymesh->faceCounts == source->faceCounts);
+		REQUIRE(polymesh->indices == source->indices);
+		REQUIRE(polymesh->P.size() == source->P.size());
+		require_same_sheet(source->points, polymesh->points);
+		require_same_sheet(source->vertices, polymesh->vertices);
+		require_same_sheet(source->primitives, polymesh->primitives);
+
+		// 消えたオブジェクトは不可視になる
+		REQUIRE(frame2->polygonMesh_FirstVisible() == nullptr);
+
+		auto point = frame2->point_FirstVisible();
+		auto pointSource = pointScene->point_FirstVisible();
+		REQUIRE(point);
+		REQUIRE(point->P.size() == pointSource->P.size());
+		require_same_sheet(pointSource->points, point->points);
+
+		// 後から現れたオブジェクトは現れるまで不可視
+		REQUIRE(frame0->point_FirstVisible() == nullptr);
+		auto frame1 = storage.read(1, error_message);
+		REQUIRE(frame1);
+		REQUIRE(frame1->point_FirstVisible());
+	}
+	std::remove(path.c_str());
+}
+
+namespace {
+	// 各フレームでPを少しずつ動かした連番
+	std::string write_animated_polymesh(const std::string &path, int frameCount) {
+		using namespace houdini_alembic;
+
+		std::string error_message;
+		AlembicStorage storage;
+		REQUIRE(storage.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message));
+		auto source = storage.read(0, error_message);
+		REQUIRE(source);
+
+		AlembicWriter writer;
+		REQUIRE(writer.open(path, error_message));
+		for (int frame = 0; frame < frameCount; ++frame) {
+			std::shared_ptr<PolygonMeshObject> mesh(new PolygonMeshObject(*source->objects[0].as_polygonMesh()));
+			for (auto &p : mesh->P) {
+				p.y += frame * 0.5f;
+			}
+			AlembicScene scene;
+			scene.objects.emplace_back(mesh);
+			REQUIRE(writer.write(scene, error_message));
+		}
+		return path;
+	}
+}
+
+namespace {
+	// "/a" は毎フレーム動き、"/b" は movingFrames 以降は止まる (Ogawa は止まった後のサンプルを格納しない)
+	std::string write_held_polymeshes(const std::string &path, int frameCount, int movingFrames) {
+		using namespace houdini_alembic;
+
+		std::string error_message;
+		AlembicStorage storage;
+		REQUIRE(storage.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message));
+		auto source = storage.read(0, error_message);
+		REQUIRE(source);
+
+		AlembicWriter writer;
+		REQUIRE(writer.open(path, error_message));
+		for (int frame = 0; frame < frameCount; ++frame) {
+			std::shared_ptr<PolygonMeshObject> a(new PolygonMeshObject(*source->objects[0].as_polygonMesh()));
+			std::shared_ptr<PolygonMeshObject> b(new PolygonMeshObject(*a));
+			a->name = "/a";
+			b->name = "/b";
+			for (auto &p : a->P) {
+				p.y += frame * 0.5f;
+			}
+			for (auto &p : b->P) {
+				p.x += std::min(frame, movingFrames - 1) * 0.5f;
+			}
+			AlembicScene scene;
+			scene.objects.emplace_back(a);
+			scene.objects.emplace_back(b);
+			REQUIRE(writer.write(scene, error_message));
+		}
+		return path;
+	}
+
+	// Abc の階層と並べて Ogawa のグループを辿り、配列プロパティの格納サンプルのファイル上の位置を得る
+	std::vector<uint64_t> stored_sample_positions(const std::string &path, const std::vector<std::string> &objects, const std::vector<std::string> &properties) {
+		using namespace Alembic::Abc;
+
+		Alembic::Ogawa::IArchive ogawa(path);
+		IArchive archive(Alembic::AbcCoreOgawa::ReadArchive(), path);
+		Alembic::Ogawa::IGroupPtr group = ogawa.getGroup()->getGroup(2, false, 0);
+		IObject o = archive.getTop();
+		for (const std::string &name : objects) {
+			size_t i = 0;
+			while (o.getChildHeader(i).getName() != name) {
+				++i;
+			}
+			group = group->getGroup(i + 1, false, 0);
+			o = o.getChild(i);
+		}
+		group = group->getGroup(0, false, 0);
+		ICompoundProperty compound = o.getProperties();
+		for (const std::string &name : properties) {
+			size_t i = 0;
+			while (compound.getPropertyHeader(i).getName() != name) {
+				++i;
+			}
+			group = group->getGroup(i, false, 0);
+			if (compound.getPropertyHeader(i).isCompound()) {
+				compound = ICompoundProperty(compound, name);
+			}
+		}
+
+		// サンプルごとにデータと次元の2つ
+		std::vector<uint64_t> positions;
+		for (uint64_t i = 0; i < group->getNumChildren(); i += 2) {
+			positions.push_back(group->getData(i, 0)->getPos());
+		}
+		return positions;
+	}
+}
+
+TEST_CASE("repackFrameMajor held samples", "[tools]") {
+	using namespace houdini_alembic;
+
+	std::string src = write_held_polymeshes(ofToDataPath("test_case/repack_held_src.abc"), 10, 6);
+	std::string dst = ofToDataPath("test_case/repack_held_dst.abc");
+
+	std::string error_message;
+	RepackReport report;
+	REQUIRE(repackFrameMajor(src, dst, report, error_message));
+	REQUIRE(report.frameCount == 10);
+	REQUIRE(report.seekDistanceAfter <= report.seekDistanceBefore);
+
+	// "/b" は1..5フレーム目だけ格納され、それぞれ同じフレームの "/a" の隣に並ぶ
+	std::vector<uint64_t> a = stored_sample_positions(dst, { "a", "aShape" }, { ".geom", "P" });
+	std::vector<uint64_t> b = stored_sample_positions(dst, { "b", "bShape" }, { ".geom", "P" });
+	REQUIRE(a.size() == 10);
+	REQUIRE(b.size() == 6);
+	for (int frame = 1; frame < 5; ++frame) {
+		REQUIRE(a[frame] < b[frame + 1]);
+		REQUIRE(b[frame] < a[frame + 1]);
+	}
+	REQUIRE(b[5] < a[6]);
+
+	AlembicStorage before;
+	AlembicStorage after;
+	REQUIRE(before.open(src, error_message));
+	REQUIRE(after.open(dst, error_message));
+	for (uint32_t frame = 0; frame < before.frameCount(); ++frame) {
+		auto sceneA = before.read(frame, error_message);
+		auto sceneB = after.read(frame, error_message);
+		REQUIRE(sceneA->objects.size() == 2);
+		REQUIRE(sceneB->objects.size() == 2);
+		for (int i = 0; i < 2; ++i) {
+			auto a = sceneA->objects[i].as_polygonMesh();
+			auto b = sceneB->objects[i].as_polygonMesh();
+			REQUIRE(a->name == b->name);
+			REQUIRE(a->P.size() == b->P.size());
+			REQUIRE(memcmp(a->P.data(), b->P.data(), a->P.size() * sizeof(a->P[0])) == 0);
+		}
+	}
+	before.close();
+	after.close();
+	std::remove(src.c_str());
+	std::remove(dst.c_str());
+}
+
+TEST_CASE("repackFrameMajor", "[tools]") {
+	using namespace houdini_alembic;
+
+	std::string src = write_animated_polymesh(ofToDataPath("test_case/repack_src.abc"), 4);
+	std::string dst = ofToDataPath("test_case/repack_dst.abc");
+
+	std::string error_message;
+	RepackReport report;
+	REQUIRE(repackFrameMajor(src, dst, report, error_message));
+	REQUIRE(report.frameCount == 4);
+	REQUIRE(report.seekDistanceAfter <= report.seekDistanceBefore);
+
+	{
+		AlembicStorage before;
+		AlembicStorage after;
+		REQUIRE(before.open(src, error_message));
+		REQUIRE(after.open(dst, error_message));
+		REQUIRE(after.frameCount() == before.frameCount());
+		for (uint32_t frame = 0; frame < before.frameCount(); ++frame) {
+			auto sceneA = before.read(frame, error_message);
+			auto sceneB = after.read(frame, error_message);
+			auto a = sceneA->polygonMesh_FirstVisible();
+			auto b = sceneB->polygonMesh_FirstVisible();
+			REQUIRE(a);
+			REQUIRE(b);
+			REQUIRE(a->indices == b->indices);
+			REQUIRE(a->faceCounts == b->faceCounts);
+			require_same_sheet(a->points, b->points);
+			require_same_sheet(a->vertices, b->vertices);
+			require_same_sheet(a->primitives, b->primitives);
+		}
+	}
+	std::remove(src.c_str());
+	std::remove(dst.c_str());
+}
+
+namespace {
+	// Houdiniのオブジェクト単位の書き出しのように、共有されたデータを参照ごとに書き直す
+	void unshare_ogawa_group(Alembic::Ogawa::IGroupPtr src, Alembic::Ogawa::OGroupPtr dst) {
+		std::vector<uint8_t> buffer;
+		for (uint64_t i = 0; i < src->getNumChildren(); ++i) {
+			if (src->isEmptyChildGroup(i)) {
+				dst->addEmptyGroup();
+			}
+			else if (src->isEmptyChildData(i)) {
+				dst->addEmptyData();
+			}
+			else if (src->isChildData(i)) {
+				auto data = src->getData(i, 0);
+				buffer.resize(data->getSize());
+				data->read(data->getSize(), buffer.data(), 0, 0);
+				dst->addData(buffer.size(), buffer.data());
+			}
+			else {
+				auto group = dst->addGroup();
+				unshare_ogawa_group(src->getGroup(i, false, 0), group);
+				group->freeze();
+			}
+		}
+	}
+}
+
+TEST_CASE("compactArchive", "[tools]") {
+	using namespace houdini_alembic;
+
+	std::string error_message;
+	AlembicStorage storage;
+	REQUIRE(storage.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message));
+	auto source = storage.read(0, error_message);
+	REQUIRE(source);
+
+	// 同じトポロジーのオブジェクトを2つ
+	std::string shared = ofToDataPath("test_case/compact_shared.abc");
+	{
+		std::shared_ptr<PolygonMeshObject> a(new PolygonMeshObject(*source->objects[0].as_polygonMesh()));
+		std::shared_ptr<PolygonMeshObject> b(new PolygonMeshObject(*a));
+		a->name = "/a";
+		b->name = "/b";
+		for (auto &p : b->P) {
+			p.x += 1.0f;
+		}
+		AlembicScene scene;
+		scene.objects.emplace_back(a);
+		scene.objects.emplace_back(b);
+
+		AlembicWriter writer;
+		REQUIRE(writer.open(shared, error_message));
+		REQUIRE(writer.write(scene, error_message));
+	}
+
+	std::string src = ofToDataPath("test_case/compact_src.abc");
+	{
+		Alembic::Ogawa::IArchive in(shared);
+		Alembic::Ogawa::OArchive out(src);
+		unshare_ogawa_group(in.getGroup(), out.getGroup());
+	}
+
+	std::string dst = ofToDataPath("test_case/compact_dst.abc");
+	CompactReport report;
+	REQUIRE(compactArchive(src, dst, report, error_message));
+	REQUIRE(0 < report.bytesSaved);
+
+	auto faceIndices = std::find_if(report.properties.begin(), report.properties.end(), [](const CompactReport::Property &p) {
+		return p.name == "/b/bShape/.geom/.faceIndices";
+	});
+	REQUIRE(faceIndices != report.properties.end());
+	REQUIRE(faceIndices->sharedSamples == 1);
+
+	auto file_size = [](const std::string &path) {
+		std::ifstream f(path, std::ios::binary | std::ios::ate);
+		return (uint64_t)f.tellg();
+	};
+	REQUIRE(file_size(dst) + report.bytesSaved == file_size(src));
+
+	// analyzeArchiveが見積もる重複はcompactArchiveが減らした分と一致する
+	ArchiveReport analyzed;
+	REQUIRE(analyzeArchive(src, analyzed, error_message));
+	uint64_t duplicateBytes = 0;
+	for (const ArchiveReport::Property &p : analyzed.properties) {
+		duplicateBytes += p.duplicateBytes;
+	}
+	REQUIRE(duplicateBytes == report.bytesSaved);
+
+	{
+		AlembicStorage before;
+		AlembicStorage after;
+		REQUIRE(before.open(src, error_message));
+		REQUIRE(after.open(dst, error_message));
+		auto sceneA = before.read(0, error_message);
+		auto sceneB = after.read(0, error_message);
+		REQUIRE(sceneA->objects.size() == 2);
+		REQUIRE(sceneB->objects.size() == 2);
+		for (int i = 0; i < 2; ++i) {
+			auto a = sceneA->objects[i].as_polygonMesh();
+			auto b = sceneB->objects[i].as_polygonMesh();
+			REQUIRE(a->name == b->name);
+			REQUIRE(a->indices == b->indices);
+			require_same_sheet(a->points, b->points);
+			require_same_sheet(a->vertices, b->vertices);
+			require_same_sheet(a->primitives, b->primitives);
+		}
+	}
+	std::remove(shared.c_str());
+	std::remove(src.c_str());
+	std::remove(dst.c_str());
+}
+
+namespace {
+	std::string read_text(const std::string &path) {
+		std::ifstream stream(path, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	}
+	int count_of(const std::string &text, const std::string &pattern) {
+		int count = 0;
+		for (std::size_t i = text.find(pattern); i != std::string::npos; i = text.find(pattern, i + 1)) {
+			count++;
+		}
+		return count;
+	}
+}
+
+namespace {
+	// 点の数が movingFrames まで毎フレーム増え、その後は同じサンプルが続く
+	std::string write_held_points(const std::string &path, uint32_t frameCount, uint32_t movingFrames) {
+		using namespace Alembic::AbcGeom;
+
+		OArchive archive(Alembic::AbcCoreOgawa::WriteArchive(), path);
+		uint32_t timeSampling = archive.addTimeSampling(TimeSampling(1.0 / 24.0, 1.0 / 24.0));
+		OPoints points(archive.getTop(), "points", timeSampling);
+		for (uint32_t frame = 0; frame < frameCount; ++frame) {
+			uint32_t count = 100 * (std::min(frame, movingFrames - 1) + 1);
+			std::vector<V3f> P(count);
+			std::vector<uint64_t> ids(count);
+			for (uint32_t i = 0; i < count; ++i) {
+				P[i] = V3f((float)i, 0.0f, 0.0f);
+				ids[i] = i;
+			}
+			points.getSchema().set(OPointsSchema::Sample(P3fArraySample(P), UInt64ArraySample(ids)));
+		}
+		return path;
+	}
+}
+
+TEST_CASE("analyzeArchive held samples", "[tools]") {
+	using namespace houdini_alembic;
+
+	std::string src = write_held_points(ofToDataPath("test_case/analyze_held.abc"), 10, 6);
+
+	std::string error_message;
+	ArchiveReport report;
+	REQUIRE(analyzeArchive(src, report, error_message));
+	REQUIRE(report.frames.size() == 10);
+
+	auto P = std::find_if(report.properties.begin(), report.properties.end(), [](const ArchiveReport::Property &p) {
+		return p.name == "/points/.geom/P";
+	});
+	REQUIRE(P != report.properties.end());
+	REQUIRE(P->numSamples == 10);
+	REQUIRE(P->storedSamples == 6);
+
+	// 5フレーム目までは毎フレーム大きなサンプルを読み、その後は5フレーム目と同じブロックを読む
+	for (uint32_t frame = 1; frame < 6; ++frame) {
+		REQUIRE(report.frames[frame - 1].bytes < report.frames[frame].bytes);
+	}
+	for (uint32_t frame = 6; frame < 10; ++frame) {
+		REQUIRE(report.frames[frame].bytes == report.frames[5].bytes);
+		REQUIRE(report.frames[frame].span == report.frames[5].span);
+		REQUIRE(report.frames[frame].locality == report.frames[5].locality);
+	}
+	std::remove(src.c_str());
+}
+
+TEST_CASE("analyzeArchive", "[tools]") {
+	using namespace houdini_alembic;
+
+	std::string src = write_animated_polymesh(ofToDataPath("test_case/analyze_src.abc"), 4);
+
+	std::string error_message;
+	ArchiveReport report;
+	REQUIRE(analyzeArchive(src, report, error_message));
+	REQUIRE(report.frameCount == 4);
+	REQUIRE(report.frames.size() == 4);
+	REQUIRE(0 < report.fileBytes);
+
+	auto property = [&](const std::string &suffix) {
+		auto it = std::find_if(report.properties.begin(), report.properties.end(), [&](const ArchiveReport::Property &p) {
+			return suffix.size() <= p.name.size() && p.name.compare(p.name.size() - suffix.size(), suffix.size(), suffix) == 0;
+		});
+		REQUIRE(it != report.properties.end());
+		return *it;
+	};
+
+	// Pとそれに伴うバウンディングボックスだけが動く
+	ArchiveReport::Property P = property("/.geom/P");
+	REQUIRE(P.constant == false);
+	REQUIRE(P.storedSamples == 4);
+	REQUIRE(P.pod == "float32_t[3]");
+	REQUIRE(P.convertedOnAccess == false);
+	REQUIRE(0 < P.bytesOnDisk);
+
+	ArchiveReport::Property faceCounts = property("/.geom/.faceCounts");
+	REQUIRE(faceCounts.constant);
+	REQUIRE(faceCounts.pod == "int32_t");
+
+	uint64_t total = 0;
+	for (const ArchiveReport::Property &p : report.properties) {
+		total += p.bytesOnDisk;
+	}
+	REQUIRE(total <= report.fileBytes);
+	for (std::size_t i = 1; i < report.properties.size(); ++i) {
+		REQUIRE(report.properties[i].bytesOnDisk <= report.properties[i - 1].bytesOnDisk);
+	}
+
+	// メッシュが最も大きい
+	REQUIRE(report.objects[0].name == P.object);
+	REQUIRE(property("/.geom/.selfBnds").constant == false);
+	REQUIRE(report.objects[0].animatedProperties == 2);
+	REQUIRE(report.objects[0].properties == (uint32_t)std::count_if(report.properties.begin(), report.properties.end(), [&](const ArchiveReport::Property &p) {
+		return p.object == P.object;
+	}));
+
+	for (const ArchiveReport::Frame &f : report.frames) {
+		REQUIRE(0 < f.blocks);
+		REQUIRE(f.bytes <= f.span);
+		REQUIRE(0.0 < f.locality);
+		REQUIRE(f.locality <= 1.0);
+	}
+
+	// 繋ぎ直していない連番に重複は無い
+	for (const ArchiveReport::Property &p : report.properties) {
+		REQUIRE(p.duplicateSamples == 0);
+	}
+
+	std::string json = ofToDataPath("test_case/analyze_report.json");
+	REQUIRE(writeArchiveReport(report, json, error_message));
+	std::string text = read_text(json);
+	REQUIRE(count_of(text, "\"properties\":[") == 1);
+	REQUIRE(count_of(text, "\"frame\":") == 4);
+	REQUIRE(count_of(text, "\"bytesOnDisk\":") == (int)(report.properties.size() + report.objects.size()));
+
+	std::remove(src.c_str());
+	std::remove(json.c_str());
+}
+
+TEST_CASE("scene cache", "[scene_cache]") {
+	using namespace houdini_alembic;
+
+	std::string error_message;
+	AlembicStorage polymeshStorage;
+	AlembicStorage pointStorage;
+	REQUIRE(polymeshStorage.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message));
+	REQUIRE(pointStorage.open(ofToDataPath("test_case/points_attributes.abc"), error_message));
+	auto polymeshScene = polymeshStorage.read(0, error_message);
+	auto pointScene = pointStorage.read(0, error_message);
+	REQUIRE(polymeshScene);
+	REQUIRE(pointScene);
+
+	std::shared_ptr<CameraObject> camera(new CameraObject());
+	camera->name = "/cam1";
+	camera->visible = true;
+	camera->resolution_x = 1920;
+	camera->focalLength_mm = 35.0f;
+	camera->eye = Vector3f(1.0f, 2.0f, 3.0f);
+
+	AlembicScene both;
+	both.objects = polymeshScene->objects;
+	both.objects.insert(both.objects.end(), pointScene->objects.begin(), pointScene->objects.end());
+	both.objects.emplace_back(camera);
+
+	std::string path = ofToDataPath("test_case/scene_cache.bin");
+	{
+		SceneCacheWriter writer;
+		REQUIRE(writer.open(path, error_message));
+		REQUIRE(writer.write(*polymeshScene, error_message));
+		REQUIRE(writer.write(both, error_message));
+		REQUIRE(writer.frameCount() == 2);
+		writer.close();
+	}
+
+	{
+		SceneCacheStorage storage;
+		REQUIRE(storage.open(path, error_message));
+		REQUIRE(storage.frameCount() == 2);
+		REQUIRE(storage.read(2, error_message) == nullptr);
+
+		auto frame0 = storage.read(0, error_message);
+		REQUIRE(frame0);
+		REQUIRE(frame0->objects.size() == 1);
+
+		auto frame1 = storage.read(1, error_message);
+		REQUIRE(frame1);
+		REQUIRE(frame1->objects.size() == 3);
+
+		// storageを閉じてもシーンは読める
+		storage.close();
+
+		auto polymesh = frame1->objects[0].as_polygonMesh();
+		auto source = polymeshScene->objects[0].as_polygonMesh();
+		REQUIRE(polymesh);
+		REQUIRE(polymesh->name == source->name);
+		REQUIRE(polymesh->visible == source->visible);
+		REQUIRE(polymesh->xforms.size() == source->xforms.size());
+		REQUIRE(polymesh->combinedXforms.value == source->combinedXforms.value);
+		REQUIRE(polymesh->faceCounts == source->faceCounts);
+		REQUIRE(polymesh->indices == source->indices);
+		REQUIRE(polymesh->P.size() == source->P.size());
+		require_same_sheet(source->points, polymesh->points);
+		require_same_sheet(source->vertices, polymesh->vertices);
+		require_same_sheet(source->primitives, polymesh->primitives);
+
+		auto strings = polymesh->points.column_as_string("string_points");
+		REQUIRE(strings);
+		for (uint32_t i = 0; i < strings->rowCount(); ++i) {
+			REQUIRE(strings->stringTable().string(strings->id(i)) == strings->get(i));
+		}
+
+		// 列の値はマップしたファイルのもので、フレーム間で共有される
+		MemoryUsage usage = polymesh->memoryUsage();
+		REQUIRE(polymesh->P.size() * sizeof(Vector3f) <= usage.ownedBytes);
+		REQUIRE(polymesh->points.rowCount() * sizeof(float) <= usage.sharedBytes);
+
+		auto point = frame1->objects[1].as_point();
+		auto pointSource = pointScene->objects[0].as_point();
+		REQUIRE(point);
+		REQUIRE(point->pointIds == pointSource->pointIds);
+		require_same_sheet(pointSource->points, point->points);
+
+		auto cameraRead = frame1->objects[2].as_camera();
+		REQUIRE(cameraRead);
+		REQUIRE(cameraRead->name == "/cam1");
+		REQUIRE(cameraRead->resolution_x == 1920);
+		REQUIRE(cameraRead->focalLength_mm == 35.0f);
+		REQUIRE(cameraRead->eye.z == 3.0f);
+	}
+
+	SECTION("not a cache") {
+		SceneCacheStorage storage;
+		REQUIRE(storage.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message) == false);
+	}
+	std::remove(path.c_str());
+}
+
+TEST_CASE("scene cache benchmark", "[.][benchmark]") {
+	using namespace houdini_alembic;
+
+	std::string error_message;
+	AlembicStorage alembic;
+	REQUIRE(alembic.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message));
+
+	std::string path = ofToDataPath("test_case/scene_cache_benchmark.bin");
+	{
+		SceneCacheWriter writer;
+		REQUIRE(writer.open(path, error_message));
+		REQUIRE(writer.write(*alembic.read(0, error_message), error_message));
+		writer.close();
+	}
+	SceneCacheStorage cache;
+	REQUIRE(cache.open(path, error_message));
+
+	BENCHMARK("AlembicStorage::read") {
+		alembic.read(0, error_message);
+	}
+	BENCHMARK("SceneCacheStorage::read") {
+		cache.read(0, error_message);
+	}
+	cache.close();
+	std::remove(path.c_str());
+}
+
+namespace {
+	// 元の値に +-inf, 範囲外, 0, -0 を混ぜる
+	template <class T>
+	std::vector<T> convert_test_values(int n) {
+		std::vector<T> values(n);
+		for (int i = 0; i < n; ++i) {
+			values[i] = (T)((i - n / 2) * 0.37);
+		}
+		if (4 < n) {
+			values[0] = (T)std::numeric_limits<float>::infinity();
+			values[1] = (T)-std::numeric_limits<float>::infinity();
+			values[2] = (T)1.0e+30f;
+			values[3] = (T)-0.0f;
+		}
+		return values;
+	}
+
+	template <class From, class To>
+	std::vector<To> convert_with(Alembic::AbcCoreOgawa::ConvertKernelLevel level, Alembic::Util::PlainOldDataType fromPod, Alembic::Util::PlainOldDataType toPod, const std::vector<From> &values) {
+		using namespace Alembic::AbcCoreOgawa;
+		SetConvertKernelLevel(level);
+		std::vector<To> converted(values.size());
+		REQUIRE(ConvertDataFast(fromPod, toPod, (const char *)values.data(), converted.data(), values.size() * sizeof(From)));
+
+		// in-place の拡大変換も同じ結果になる
+		if (sizeof(From) <= sizeof(To)) {
+			std::vector<To> inplace(values.size());
+			memcpy((void *)inplace.data(), (const void *)values.data(), values.size() * sizeof(From));
+			REQUIRE(ConvertDataFast(fromPod, toPod, (const char *)inplace.data(), inplace.data(), values.size() * sizeof(From)));
+			REQUIRE(memcmp(inplace.data(), converted.data(), converted.size() * sizeof(To)) == 0);
+		}
+		return converted;
+	}
+
+	// カーネルを通さない元の ConvertData テンプレート
+	template <class From, class To>
+	std::vector<To> convert_generic(Alembic::Util::PlainOldDataType fromPod, Alembic::Util::PlainOldDataType toPod, std::vector<From> values) {
+		std::vector<To> converted(values.size());
+		Alembic::AbcCoreOgawa::ConvertPodsGeneric(fromPod, toPod, (char *)values.data(), converted.data(), values.size() * sizeof(From));
+		return converted;
+	}
+
+	template <class From, class To>
+	void check_convert_kernels(Alembic::Util::PlainOldDataType fromPod, Alembic::Util::PlainOldDataType toPod) {
+		using namespace Alembic::AbcCoreOgawa;
+		for (int n : {0, 1, 7, 8, 9, 31, 1000, 1 << 19}) {
+			std::vector<From> values = convert_test_values<From>(n);
+			std::vector<To> reference = convert_generic<From, To>(fromPod, toPod, values);
+			for (int level = kConvertScalar; level <= GetSupportedConvertKernelLevel(); ++level) {
+				std::vector<To> converted = convert_with<From, To>((ConvertKernelLevel)level, fromPod, toPod, values);
+				REQUIRE(memcmp(reference.data(), converted.data(), reference.size() * sizeof(To)) == 0);
+			}
+		}
+		SetConvertKernelLevel(GetSupportedConvertKernelLevel());
+	}
+}
+
+TEST_CASE("convert kernels", "[convert]") {
+	using namespace Alembic::Util;
+
+	check_convert_kernels<float64_t, float32_t>(kFloat64POD, kFloat32POD);
+	check_convert_kernels<float32_t, float64_t>(kFloat32POD, kFloat64POD);
+	check_convert_kernels<float16_t, float32_t>(kFloat16POD, kFloat32POD);
+	check_convert_kernels<float32_t, float16_t>(kFloat32POD, kFloat16POD);
+	check_convert_kernels<float16_t, float64_t>(kFloat16POD, kFloat64POD);
+	check_convert_kernels<float64_t, float16_t>(kFloat64POD, kFloat16POD);
+	check_convert_kernels<int32_t, float32_t>(kInt32POD, kFloat32POD);
+	check_convert_kernels<int32_t, float64_t>(kInt32POD, kFloat64POD);
+
+	// 拡大変換はfloat16の範囲にクランプされる (ReadUtilと同じ)
+	std::vector<float16_t> halfs = { float16_t(std::numeric_limits<float>::infinity()), float16_t(1.0f) };
+	std::vector<float32_t> floats(halfs.size());
+	REQUIRE(Alembic::AbcCoreOgawa::ConvertDataFast(kFloat16POD, kFloat32POD, (const char *)halfs.data(), floats.data(), halfs.size() * sizeof(float16_t)));
+	REQUIRE(floats[0] == 65504.0f);
+	REQUIRE(floats[1] == 1.0f);
+}
+
+TEST_CASE("convert kernels benchmark", "[.][benchmark]") {
+	using namespace Alembic::Util;
+	using namespace Alembic::AbcCoreOgawa;
+
+	const int N = 1 << 24;
+	std::vector<float64_t> doubles = convert_test_values<float64_t>(N);
+	std::vector<float16_t> halfs = convert_test_values<float16_t>(N);
+	std::vector<float32_t> floats(N);
+
+	BENCHMARK("float64 -> float32 ConvertData") {
+		ConvertPodsGeneric(kFloat64POD, kFloat32POD, (char *)doubles.data(), floats.data(), N * sizeof(float64_t));
+	}
+	BENCHMARK("float16 -> float32 ConvertData") {
+		ConvertPodsGeneric(kFloat16POD, kFloat32POD, (char *)halfs.data(), floats.data(), N * sizeof(float16_t));
+	}
+
+	auto run = [&](const char *label, ConvertKernelLevel level, std::size_t threads) {
+		SetConvertKernelLevel(level);
+		SetConvertThreadCount(threads);
+		BENCHMARK(std::string("float64 -> float32 ") + label) {
+			ConvertDataFast(kFloat64POD, kFloat32POD, (const char *)doubles.data(), floats.data(), N * sizeof(float64_t));
+		}
+		BENCHMARK(std::string("float16 -> float32 ") + label) {
+			ConvertDataFast(kFloat16POD, kFloat32POD, (const char *)halfs.data(), floats.data(), N * sizeof(float16_t));
+		}
+	};
+	run("scalar", kConvertScalar, 1);
+	run("sse2", kConvertSSE2, 1);
+	run("avx2", kConvertAVX2, 1);
+	run("avx2 parallel", kConvertAVX2, 0);
+
+	SetConvertKernelLevel(GetSupportedConvertKernelLevel());
+	SetConvertThreadCount(0);
+}
+
+TEST_CASE("half to float", "[half]") {
+	std::vector<half> halfs(1 << 16);
+	for (int i = 0; i < halfs.size(); ++i) {
+		halfs[i].setBits((unsigned short)i);
+	}
+
+	// テーブルとビット演算は全てのhalfで一致する
+	for (int i = 0; i < halfs.size(); ++i) {
+		half::uif a, b;
+		a.f = half::toFloatBits((unsigned short)i);
+		b.f = half::toFloatLut((unsigned short)i);
+		REQUIRE(a.i == b.i);
+	}
+
+	std::vector<float> lut(halfs.size());
+	std::vector<float> converted(halfs.size());
+	halfToFloatLut(halfs.data(), lut.data(), halfs.size());
+	halfToFloat(halfs.data(), converted.data(), halfs.size());
+	for (int i = 0; i < halfs.size(); ++i) {
+		if (halfs[i].isNan()) {
+			REQUIRE(std::isnan(converted[i]));
+		} else {
+			REQUIRE(memcmp(&lut[i], &converted[i], sizeof(float)) == 0);
+		}
+	}
+
+	// F16C を使わない版は NaN のペイロードまで一致する
+	std::vector<float> bitwise(halfs.size());
+	halfToFloatBitwise(halfs.data(), bitwise.data(), halfs.size());
+	REQUIRE(memcmp(lut.data(), bitwise.data(), lut.size() * sizeof(float)) == 0);
+
+	// in-place
+	std::vector<float> inplace(halfs.size());
+	memcpy(inplace.data(), halfs.data(), halfs.size() * sizeof(half));
+	halfToFloat((const half *)inplace.data(), inplace.data(), halfs.size());
+	REQUIRE(memcmp(inplace.data(), converted.data(), converted.size() * sizeof(float)) == 0);
+}
+
+TEST_CASE("half to float benchmark", "[.][benchmark]") {
+	const int N = 1 << 26;
+	std::vector<half> halfs(N);
+	for (int i = 0; i < N; ++i) {
+		halfs[i] = half((float)((i % 20000) - 10000) * 0.01f);
+	}
+	std::vector<float> floats(N);
+
+	BENCHMARK("toFloatLut") {
+		for (int i = 0; i < N; ++i) {
+			floats[i] = half::toFloatLut(halfs[i].bits());
+		}
+	}
+	BENCHMARK("toFloatBits") {
+		for (int i = 0; i < N; ++i) {
+			floats[i] = half::toFloatBits(halfs[i].bits());
+		}
+	}
+	BENCHMARK("halfToFloatLut") {
+		halfToFloatLut(halfs.data(), floats.data(), N);
+	}
+	BENCHMARK("halfToFloat") {
+		halfToFloat(halfs.data(), floats.data(), N);
+	}
+}
+
+TEST_CASE("chunked digest", "[digest]") {
+	using namespace Alembic::Util;
+
+	for (size_t n : { (size_t)0, (size_t)15, kMurmurHash3ChunkSize, kMurmurHash3ChunkSize + 1, kMurmurHash3ChunkSize * 5 + 7 }) {
+		std::vector<uint8_t> data(n);
+		for (size_t i = 0; i < n; ++i) {
+			data[i] = (uint8_t)(i * 31 + (i >> 11));
+		}
+
+		uint64_t sequential[2];
+		MurmurHash3_x64_128(data.data(), n, 4, sequential);
+
+		uint64_t reference[2];
+		MurmurHash3_x64_128_Chunked(data.data(), n, 4, reference, 1);
+
+		// 1チャンク以下なら従来と同じ
+		if (n <= kMurmurHash3ChunkSize) {
+			REQUIRE(memcmp(sequential, reference, sizeof(reference)) == 0);
+		}
+
+		// スレッド数に依らず同じ
+		for (size_t threads : { 0, 2, 3, 16 }) {
+			uint64_t digest[2];
+			MurmurHash3_x64_128_Chunked(data.data(), n, 4, digest, threads);
+			REQUIRE(memcmp(digest, reference, sizeof(reference)) == 0);
+		}
+
+		if (n != 0) {
+			data[n - 1] ^= 1;
+			uint64_t changed[2];
+			MurmurHash3_x64_128_Chunked(data.data(), n, 4, changed, 0);
+			REQUIRE(memcmp(changed, reference, sizeof(reference)) != 0);
+		}
+	}
+}
+
+TEST_CASE("parallel for hook", "[digest]") {
+	using namespace Alembic::Util;
+
+	// チャンクはSetParallelForのプールで実行され、スレッドは作られない
+	std::atomic<int> calls(0);
+	std::atomic<int> chunks(0);
+	std::thread::id caller = std::this_thread::get_id();
+	std::atomic<bool> sameThread(true);
+	SetParallelFor([&](std::size_t count, const std::function<void(std::size_t)> &body) {
+		calls++;
+		for (std::size_t i = 0; i < count; ++i) {
+			chunks++;
+			if (std::this_thread::get_id() != caller) {
+				sameThread = false;
+			}
+			body(i);
+		}
+	});
+
+	size_t n = kMurmurHash3ChunkSize * 5 + 7;
+	std::vector<uint8_t> data(n);
+	for (size_t i = 0; i < n; ++i) {
+		data[i] = (uint8_t)(i * 31 + (i >> 11));
+	}
+	uint64_t reference[2];
+	MurmurHash3_x64_128_Chunked(data.data(), n, 4, reference, 1);
+	REQUIRE(calls == 0);
+
+	uint64_t digest[2];
+	MurmurHash3_x64_128_Chunked(data.data(), n, 4, digest, 0);
+	REQUIRE(calls == 1);
+	REQUIRE(chunks == 6);
+	REQUIRE(memcmp(digest, reference, sizeof(reference)) == 0);
+
+	calls = 0;
+	chunks = 0;
+	Alembic::AbcCoreOgawa::SetConvertThreadCount(4);
+	std::vector<float64_t> from(1 << 20);
+	for (std::size_t i = 0; i < from.size(); ++i) {
+		from[i] = (float64_t)i * 0.5;
+	}
+	std::vector<float32_t> to(from.size());
+	REQUIRE(Alembic::AbcCoreOgawa::ConvertDataFast(kFloat64POD, kFloat32POD, (const char *)from.data(), to.data(), from.size() * sizeof(float64_t)));
+	Alembic::AbcCoreOgawa::SetConvertThreadCount(0);
+	REQUIRE(calls == 1);
+	REQUIRE(chunks == 4);
+	std::size_t mismatches = 0;
+	for (std::size_t i = 0; i < from.size(); ++i) {
+		mismatches += to[i] != (float32_t)from[i];
+	}
+	REQUIRE(mismatches == 0);
+	REQUIRE(sameThread);
+
+	// 共有のプールに戻す
+	std::shared_ptr<houdini_alembic::TaskExecutor> executor = houdini_alembic::TaskExecutor::shared();
+	SetParallelFor([executor](std::size_t count, const std::function<void(std::size_t)> &body) {
+		executor->parallelFor((uint32_t)count, [&body](uint32_t i) { body(i); });
+	});
+}
+
+TEST_CASE("chunked digest benchmark", "[.][benchmark]") {
+	using namespace Alembic::AbcCoreAbstract;
+
+	// 10M points
+	std::vector<float> P(10000000 * 3);
+	for (size_t i = 0; i < P.size(); ++i) {
+		P[i] = (float)i * 0.001f;
+	}
+	ArraySample sample(P.data(), DataType(Alembic::Util::kFloat32POD, 3), Dimensions(P.size() / 3));
+
+	SetChunkedArraySampleKeys(false);
+	BENCHMARK("getKey sequential") {
+		sample.getKey();
+	}
+	SetChunkedArraySampleKeys(true, 1);
+	BENCHMARK("getKey chunked 1 thread") {
+		sample.getKey();
+	}
+	SetChunkedArraySampleKeys(true, 0);
+	BENCHMARK("getKey chunked parallel") {
+		sample.getKey();
+	}
+	SetChunkedArraySampleKeys(false);
+}
+
+TEST_CASE("scene arena", "[arena]") {
+	using namespace houdini_alembic;
+
+	SECTION("allocate") {
+		SceneArena arena(64);
+		for (int i = 0; i < 100; ++i) {
+			void *p = arena.allocate(i + 1, 16);
+			REQUIRE((uintptr_t)p % 16 == 0);
+			memset(p, 0xFF, i + 1);
+		}
+		REQUIRE(arena.bytesUsed() == 100 * 101 / 2);
+		REQUIRE(arena.bytesUsed() <= arena.bytesReserved());
+		REQUIRE(arena.blockCount() < 10);
+	}
+
+	SECTION("scene") {
+		std::string error_message;
+		std::shared_ptr<AlembicScene> scene;
+		std::shared_ptr<SceneArena> arena;
+		{
+			AlembicStorage storage;
+			REQUIRE(storage.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message));
+			scene = storage.read(0, error_message);
+			REQUIRE(scene);
+			REQUIRE(scene->arena);
+			REQUIRE(0 < scene->arena->bytesUsed());
+			arena = scene->arena;
+		}
+
+		// オブジェクトが生きている間はアリーナも生きている
+		SceneObjectPointer object = scene->objects[0];
+		PolygonMeshObject *polymesh = object.as_polygonMesh();
+		REQUIRE(polymesh);
+		scene.reset();
+		REQUIRE(arena.use_count() > 1);
+		REQUIRE(polymesh->points.column_as_vector3("P")->rowCount() == polymesh->P.size());
+
+		object = SceneObjectPointer(std::shared_ptr<SceneObject>());
+		REQUIRE(arena.use_count() == 1);
+	}
+}
+
+TEST_CASE("recycled read", "[recycle]") {
+	using namespace houdini_alembic;
+
+	std::string src = write_animated_polymesh(ofToDataPath("test_case/recycle_src.abc"), 4);
+	{
+		std::string error_message;
+		AlembicStorage storage;
+		REQUIRE(storage.open(src, error_message));
+
+		std::shared_ptr<AlembicScene> scene;
+		for (uint32_t frame = 0; frame < storage.frameCount(); ++frame) {
+			PolygonMeshObject *previous = scene ? scene->polygonMesh_FirstVisible() : nullptr;
+			scene = storage.read(frame, error_message, std::move(scene));
+			REQUIRE(scene);
+
+			auto expected = storage.read(frame, error_message);
+			auto a = expected->polygonMesh_FirstVisible();
+			auto b = scene->polygonMesh_FirstVisible();
+			REQUIRE(a);
+			REQUIRE(b);
+			if (previous) {
+				REQUIRE(b == previous);
+			}
+			REQUIRE(scene->objects.size() == expected->objects.size());
+			REQUIRE(b->name == a->name);
+			REQUIRE(b->xforms.size() == a->xforms.size());
+			REQUIRE(a->indices == b->indices);
+			REQUIRE(a->faceCounts == b->faceCounts);
+			require_same_sheet(a->points, b->points);
+			require_same_sheet(a->vertices, b->vertices);
+			require_same_sheet(a->primitives, b->primitives);
+		}
+
+		// 参照が残っているシーンは書き換えない
+		auto held = scene;
+		auto fresh = storage.read(0, error_message, scene);
+		REQUIRE(fresh != held);
+		REQUIRE(held->polygonMesh_FirstVisible() != fresh->polygonMesh_FirstVisible());
+
+		// 参照が残っているオブジェクトも書き換えない
+		SceneObjectPointer object = fresh->objects[0];
+		held.reset();
+		scene.reset();
+		auto next = storage.read(1, error_message, std::move(fresh));
+		REQUIRE(next->objects[0].get() != object.get());
+	}
+	std::remove(src.c_str());
+}
+
+TEST_CASE("string table", "[strings]") {
+	using namespace houdini_alembic;
+
+	SECTION("intern") {
+		StringTable table;
+		REQUIRE(table.intern("a") == 0);
+		REQUIRE(table.intern("b") == 1);
+		REQUIRE(table.intern("a") == 0);
+		std::string values[] = { "b", "c", "c" };
+		uint32_t ids[3];
+		table.intern(values, 3, ids);
+		REQUIRE(ids[0] == 1);
+		REQUIRE(ids[1] == 2);
+		REQUIRE(ids[2] == 2);
+		REQUIRE(table.size() == 3);
+		REQUIRE(table.string(2) == "c");
+	}
+
+	SECTION("columns") {
+		std::string error_message;
+		AlembicStorage storage;
+		REQUIRE(storage.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message));
+		auto sceneA = storage.read(0, error_message);
+		auto sceneB = storage.read(0, error_message);
+		auto a = sceneA->polygonMesh_FirstVisible();
+		auto b = sceneB->polygonMesh_FirstVisible();
+
+		const char *keys[] = { "string_points", "string_vertices", "string_primitives" };
+		const AttributeSpreadSheet *sheetsA[] = { &a->points, &a->vertices, &a->primitives };
+		const AttributeSpreadSheet *sheetsB[] = { &b->points, &b->vertices, &b->primitives };
+		for (int k = 0; k < 3; ++k) {
+			auto columnA = sheetsA[k]->column_as_string(keys[k]);
+			auto columnB = sheetsB[k]->column_as_string(keys[k]);
+			REQUIRE(columnA);
+			REQUIRE(columnB);
+			REQUIRE(&columnA->stringTable() == &columnB->stringTable());
+			for (uint32_t i = 0; i < columnA->rowCount(); ++i) {
+				REQUIRE(columnA->stringTable().string(columnA->id(i)) == columnA->get(i));
+
+				// 同じアーカイブなら別の読み込みでも同じid
+				REQUIRE(columnA->id(i) == columnB->id(i));
+			}
+		}
+
+		// 同じ文字列は同じid
+		std::map<std::string, uint32_t> ids;
+		for (int k = 0; k < 3; ++k) {
+			auto column = sheetsA[k]->column_as_string(keys[k]);
+			for (uint32_t i = 0; i < column->rowCount(); ++i) {
+				auto it = ids.emplace(column->get(i), column->id(i)).first;
+				REQUIRE(it->second == column->id(i));
+			}
+		}
+		std::set<uint32_t> unique;
+		for (auto kv : ids) {
+			unique.insert(kv.second);
+		}
+		REQUIRE(unique.size() == ids.size());
+	}
+}
+
+namespace {
+	// Houdiniが書き出さない型の属性を持つポリゴンを書く
+	std::string write_typed_attributes(const std::string &path) {
+		using namespace Alembic::AbcGeom;
+
+		OArchive archive(Alembic::AbcCoreOgawa::WriteArchive(), path);
+		OXform xform(archive.getTop(), "geo");
+		XformSample xformSample;
+		xform.getSchema().set(xformSample);
+		OPolyMesh mesh(xform, "mesh");
+		auto schema = mesh.getSchema();
+
+		std::vector<V3f> P = { V3f(0, 0, 0), V3f(1, 0, 0), V3f(1, 1, 0), V3f(0, 1, 0) };
+		std::vector<int32_t> indices = { 0, 1, 2, 3 };
+		std::vector<int32_t> counts = { 4 };
+		schema.set(OPolyMeshSchema::Sample(P3fArraySample(P), Int32ArraySample(indices), Int32ArraySample(counts)));
+
+		OCompoundProperty arb = schema.getArbGeomParams();
+
+		std::vector<half> alpha = { half(0.0f), half(0.25f), half(0.5f), half(1.0f) };
+		OHalfGeomParam(arb, "Alpha", false, kVaryingScope, 1).set(OHalfGeomParam::Sample(HalfArraySample(alpha), kVaryingScope));
+
+		std::vector<C3h> cd = { C3h(half(1), half(0), half(0)), C3h(half(0), half(1), half(0)), C3h(half(0), half(0), half(1)), C3h(half(0.5f), half(0.5f), half(0.5f)) };
+		OC3hGeomParam(arb, "Cd", false, kVaryingScope, 1).set(OC3hGeomParam::Sample(C3hArraySample(cd), kVaryingScope));
+
+		std::vector<double> density = { 0.1, 0.2, 0.3, 1.0e+300 };
+		ODoubleGeomParam(arb, "density", false, kVaryingScope, 1).set(ODoubleGeomParam::Sample(DoubleArraySample(density), kVaryingScope));
+
+		std::vector<int64_t> id64 = { 1, 2, 3, 1LL << 40 };
+		OInt64GeomParam(arb, "id64", false, kVaryingScope, 1).set(OInt64GeomParam::Sample(Int64ArraySample(id64), kVaryingScope));
+
+		std::vector<int8_t> flag = { -1, 0, 1, 127 };
+		OCharGeomParam(arb, "flag", false, kVaryingScope, 1).set(OCharGeomParam::Sample(CharArraySample(flag), kVaryingScope));
+
+		std::vector<V2f> uv2 = { V2f(0, 0), V2f(1, 0), V2f(1, 1), V2f(0, 1) };
+		OV2fGeomParam(arb, "uv2", false, kVaryingScope, 1).set(OV2fGeomParam::Sample(V2fArraySample(uv2), kVaryingScope));
+
+		std::vector<int16_t> groups = { 7, 9 };
+		std::vector<uint32_t> groupIndices = { 0, 1, 1, 0 };
+		OInt16GeomParam(arb, "group", true, kVaryingScope, 1).set(OInt16GeomParam::Sample(Int16ArraySample(groups), UInt32ArraySample(groupIndices), kVaryingScope));
+
+		std::vector<uint32_t> mask32 = { 0u, 1u, 0x80000001u, 0xFFFFFFFFu };
+		OUInt32GeomParam(arb, "mask32", false, kVaryingScope, 1).set(OUInt32GeomParam::Sample(UInt32ArraySample(mask32), kVaryingScope));
+
+		std::vector<double> weights = { 0.1, 1.0e+200 };
+		std::vector<uint32_t> weightIndices = { 1, 0, 0, 1 };
+		ODoubleGeomParam(arb, "weight", true, kVaryingScope, 1).set(ODoubleGeomParam::Sample(DoubleArraySample(weights), UInt32ArraySample(weightIndices), kVaryingScope));
+
+		std::vector<float> promoted = { 2.5f, 2.5f, 2.5f, 2.5f };
+		OFloatGeomParam(arb, "promoted", false, kVaryingScope, 1).set(OFloatGeomParam::Sample(FloatArraySample(promoted), kVaryingScope));
+
+		std::vector<float> time = { 1.5f };
+		OFloatGeomParam(arb, "time", false, kConstantScope, 1).set(OFloatGeomParam::Sample(FloatArraySample(time), kConstantScope));
+		std::vector<std::string> shot = { "sh010" };
+		OStringGeomParam(arb, "shot", false, kConstantScope, 1).set(OStringGeomParam::Sample(StringArraySample(shot), kConstantScope));
+		return path;
+	}
+}
+
+namespace {
+	// 型と値がビットまで同じこと
+	void require_same_typed_sheet(const houdini_alembic::AttributeSpreadSheet &a, const houdini_alembic::AttributeSpreadSheet &b) {
+		using namespace houdini_alembic;
+		REQUIRE(a.columnCount() == b.columnCount());
+		for (int i = 0; i < a.columnCount(); ++i) {
+			const AttributeColumn *x = a.sheet[i].column.get();
+			auto y = b.column(a.sheet[i].key.c_str());
+			INFO(a.sheet[i].key);
+			REQUIRE(y);
+			REQUIRE(y->attributeType() == x->attributeType());
+			REQUIRE(y->storageType() == x->storageType());
+			REQUIRE(y->componentCount() == x->componentCount());
+			REQUIRE(y->rowCount() == x->rowCount());
+			if (x->storage()) {
+				std::size_t bytes = Alembic::Util::PODNumBytes((Alembic::Util::PlainOldDataType)x->storageType()) * x->componentCount() * x->rowCount();
+				REQUIRE(y->storage());
+				REQUIRE(memcmp(x->storage(), y->storage(), bytes) == 0);
+			}
+			for (uint32_t j = 0; j < x->rowCount(); ++j) {
+				switch (x->attributeType()) {
+				case AttributeType_Int: {
+					int64_t u, v;
+					static_cast<const AttributeIntColumn *>(x)->get(j, &u);
+					static_cast<const AttributeIntColumn *>(y)->get(j, &v);
+					REQUIRE(u == v);
+					break;
+				}
+				case AttributeType_Float: {
+					double u, v;
+					static_cast<const AttributeFloatColumn *>(x)->get(j, &u);
+					static_cast<const AttributeFloatColumn *>(y)->get(j, &v);
+					REQUIRE(u == v);
+					break;
+				}
+				default:
+					break;
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("native attribute types", "[attributes]") {
+	using namespace houdini_alembic;
+
+	std::string path = write_typed_attributes(ofToDataPath("test_case/typed_attributes.abc"));
+	{
+		std::string error_message;
+		AlembicStorage storage;
+		REQUIRE(storage.open(path, error_message));
+		auto scene = storage.read(0, error_message);
+		REQUIRE(scene);
+		auto mesh = scene->polygonMesh_FirstVisible();
+		REQUIRE(mesh);
+		REQUIRE(mesh->P.size() == 4);
+		REQUIRE(mesh->P[2].y == 1.0f);
+
+		auto alpha = mesh->points.column_as_float("Alpha");
+		REQUIRE(alpha);
+		REQUIRE(alpha->storageType() == AttributeStorageType_Float16);
+		REQUIRE(alpha->rowCount() == 4);
+		REQUIRE(alpha->get(1) == 0.25f);
+		REQUIRE(alpha->storage());
+
+		// halfのまま持っている
+		const uint16_t *alphaBits = static_cast<const uint16_t *>(alpha->storage());
+		REQUIRE(alphaBits[3] == half(1.0f).bits());
+
+		auto cd = mesh->points.column_as_vector3("Cd");
+		REQUIRE(cd);
+		REQUIRE(cd->storageType() == AttributeStorageType_Float16);
+		REQUIRE(cd->componentCount() == 3);
+		float rgb[3];
+		cd->get(3, rgb);
+		REQUIRE(rgb[0] == 0.5f);
+		REQUIRE(rgb[2] == 0.5f);
+
+		auto density = mesh->points.column_as_float("density");
+		REQUIRE(density);
+		REQUIRE(density->storageType() == AttributeStorageType_Float64);
+		double d;
+		density->get(3, &d);
+		REQUIRE(d == 1.0e+300);
+
+		auto id64 = mesh->points.column_as_int("id64");
+		REQUIRE(id64);
+		REQUIRE(id64->storageType() == AttributeStorageType_Int64);
+		int64_t i64;
+		id64->get(3, &i64);
+		REQUIRE(i64 == (1LL << 40));
+		REQUIRE(id64->get(2) == 3);
+
+		auto flag = mesh->points.column_as_int("flag");
+		REQUIRE(flag);
+		REQUIRE(flag->storageType() == AttributeStorageType_Int8);
+		REQUIRE(flag->get(0) == -1);
+		REQUIRE(flag->get(3) == 127);
+
+		auto uv2 = mesh->points.column_as_vector2("uv2");
+		REQUIRE(uv2);
+		REQUIRE(uv2->storageType() == AttributeStorageType_Float32);
+		float xy[2];
+		uv2->get(2, xy);
+		REQUIRE(xy[0] == 1.0f);
+		REQUIRE(xy[1] == 1.0f);
+
+		auto group = mesh->points.column_as_int("group");
+		REQUIRE(group);
+		REQUIRE(group->storageType() == AttributeStorageType_Int16);
+		REQUIRE(group->storage() == nullptr);
+		REQUIRE(group->rowCount() == 4);
+		REQUIRE(group->get(0) == 7);
+		REQUIRE(group->get(1) == 9);
+		REQUIRE(group->get(3) == 7);
+
+		auto mask32 = mesh->points.column_as_int("mask32");
+		REQUIRE(mask32);
+		REQUIRE(mask32->storageType() == AttributeStorageType_UInt32);
+		int64_t m;
+		mask32->get(3, &m);
+		REQUIRE(m == 0xFFFFFFFFLL);
+
+		auto weight = mesh->points.column_as_float("weight");
+		REQUIRE(weight);
+		REQUIRE(weight->storageType() == AttributeStorageType_Float64);
+		REQUIRE(weight->storage() == nullptr);
+		double w;
+		weight->get(3, &w);
+		REQUIRE(w == 1.0e+200);
+
+		char buffer[64];
+		id64->snprint(3, buffer, sizeof(buffer));
+		REQUIRE(std::string(buffer) == "1099511627776");
+
+		// 全点で同じ値は1行だけ持つ
+		auto promoted = mesh->points.column_as_float("promoted");
+		REQUIRE(promoted);
+		REQUIRE(promoted->isBroadcast());
+		REQUIRE(promoted->rowCount() == 4);
+		REQUIRE(promoted->storage() == nullptr);
+		REQUIRE(promoted->get(3) == 2.5f);
+		REQUIRE(alpha->isBroadcast() == false);
+
+		// detail
+		REQUIRE(mesh->details.columnCount() == 2);
+		REQUIRE(mesh->points.column("time") == nullptr);
+		auto time = mesh->details.column_as_float("time");
+		REQUIRE(time);
+		REQUIRE(time->rowCount() == 1);
+		REQUIRE(time->get(0) == 1.5f);
+		auto shot = mesh->details.column_as_string("shot");
+		REQUIRE(shot);
+		REQUIRE(shot->get(0) == "sh010");
+
+		// AlembicWriterとscene cacheでもdetailは残る
+		std::string written = ofToDataPath("test_case/typed_attributes_written.abc");
+		{
+			AlembicWriter writer;
+			REQUIRE(writer.open(written, error_message));
+			REQUIRE(writer.write(*scene, error_message));
+			writer.close();
+		}
+		std::string cachePath = ofToDataPath("test_case/typed_attributes.bin");
+		{
+			SceneCacheWriter writer;
+			REQUIRE(writer.open(cachePath, error_message));
+			REQUIRE(writer.write(*scene, error_message));
+			writer.close();
+		}
+		{
+			AlembicStorage writtenStorage;
+			REQUIRE(writtenStorage.open(written, error_message));
+			auto writtenScene = writtenStorage.read(0, error_message);
+			REQUIRE(writtenScene);
+			require_same_sheet(mesh->details, writtenScene->polygonMesh_FirstVisible()->details);
+
+			SceneCacheStorage cache;
+			REQUIRE(cache.open(cachePath, error_message));
+			auto cacheScene = cache.read(0, error_message);
+			REQUIRE(cacheScene);
+			require_same_sheet(mesh->details, cacheScene->polygonMesh_FirstVisible()->details);
+
+			// scene cacheは保存された型のまま持つ
+			require_same_typed_sheet(mesh->points, cacheScene->polygonMesh_FirstVisible()->points);
+			auto cacheAlpha = cacheScene->polygonMesh_FirstVisible()->points.column_as_float("Alpha");
+			REQUIRE(cacheAlpha->storageType() == AttributeStorageType_Float16);
+			REQUIRE(static_cast<const uint16_t *>(cacheAlpha->storage())[3] == half(1.0f).bits());
+			auto cacheWeight = cacheScene->polygonMesh_FirstVisible()->points.column_as_float("weight");
+			REQUIRE(cacheWeight->storage());
+			double cw;
+			cacheWeight->get(3, &cw);
+			REQUIRE(cw == 1.0e+200);
+		}
+		std::remove(written.c_str());
+		std::remove(cachePath.c_str());
+	}
+	std::remove(path.c_str());
+}
+
+namespace {
+	// write_typed_attributes の上に重ねる、属性だけを差し替えるレイヤー
+	std::string write_attribute_override(const std::string &path) {
+		using namespace Alembic::AbcGeom;
+
+		OArchive archive(Alembic::AbcCoreOgawa::WriteArchive(), path);
+		OObject geo(archive.getTop(), "geo");
+		OObject mesh(geo, "mesh");
+		OCompoundProperty geom(mesh.getProperties(), ".geom");
+		OCompoundProperty arb(geom, ".arbGeomParams");
+
+		std::vector<double> density = { 5.0, 6.0, 7.0, 8.0 };
+		ODoubleGeomParam(arb, "density", false, kVaryingScope, 1).set(ODoubleGeomParam::Sample(DoubleArraySample(density), kVaryingScope));
+
+		std::vector<float> mask = { 0.0f, 1.0f, 0.0f, 1.0f };
+		OFloatGeomParam(arb, "mask", false, kVaryingScope, 1).set(OFloatGeomParam::Sample(FloatArraySample(mask), kVaryingScope));
+		return path;
+	}
+}
+
+TEST_CASE("layered archives", "[layer]") {
+	using namespace houdini_alembic;
+
+	std::string base = write_typed_attributes(ofToDataPath("test_case/layer_base.abc"));
+	std::string over = write_attribute_override(ofToDataPath("test_case/layer_override.abc"));
+	{
+		std::string error_message;
+		AlembicStorage storage;
+		REQUIRE(storage.open(std::vector<std::string>{ over, base }, error_message));
+		REQUIRE(storage.frameCount() == 1);
+		auto scene = storage.read(0, error_message);
+		REQUIRE(scene);
+		auto mesh = scene->polygonMesh_FirstVisible();
+		REQUIRE(mesh);
+		REQUIRE(mesh->P.size() == 4);
+		REQUIRE(mesh->P[2].y == 1.0f);
+
+		// 先のレイヤーが勝つ
+		auto density = mesh->points.column_as_float("density");
+		REQUIRE(density);
+		REQUIRE(density->get(0) == 5.0f);
+		REQUIRE(density->get(3) == 8.0f);
+
+		auto mask = mesh->points.column_as_float("mask");
+		REQUIRE(mask);
+		REQUIRE(mask->get(1) == 1.0f);
+
+		// 上書きしていない属性は下のレイヤーから読む
+		auto id64 = mesh->points.column_as_int("id64");
+		REQUIRE(id64);
+		REQUIRE(id64->get(2) == 3);
+		REQUIRE(mesh->points.column_as_float("Alpha"));
+	}
+	{
+		std::string error_message;
+		AlembicStorage storage;
+		REQUIRE(storage.open(std::vector<std::string>{ base, over }, error_message));
+		auto scene = storage.read(0, error_message);
+		REQUIRE(scene);
+		auto mesh = scene->polygonMesh_FirstVisible();
+		REQUIRE(mesh);
+		double d;
+		mesh->points.column_as_float("density")->get(3, &d);
+		REQUIRE(d == 1.0e+300);
+	}
+	{
+		std::string error_message;
+		AlembicStorage storage;
+		REQUIRE(storage.open(std::vector<std::string>(), error_message) == false);
+		REQUIRE(storage.open(std::vector<std::string>{ base, ofToDataPath("test_case/layer_missing.abc") }, error_message) == false);
+	}
+	std::remove(base.c_str());
+	std::remove(over.c_str());
+}
+
+namespace {
+	std::string write_point_cloud(const std::string &path, uint32_t count) {
+		using namespace Alembic::AbcGeom;
+
+		OArchive archive(Alembic::AbcCoreOgawa::WriteArchive(), path);
+		OXform xform(archive.getTop(), "particles");
+		XformSample xformSample;
+		xform.getSchema().set(xformSample);
+		OPoints points(xform, "points");
+
+		std::vector<V3f> P(count);
+		std::vector<V3f> v(count);
+		std::vector<uint64_t> ids(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			float t = i * 0.001f;
+			P[i] = V3f(std::sin(t) * 10.0f, t, std::cos(t * 3.0f) * 10.0f);
+			v[i] = V3f(std::cos(t), 1.0f, -std::sin(t * 3.0f) * 3.0f);
+			ids[i] = i;
+		}
+		// 最後のブロックだけ誤差に収まらない
+		if (8192 < count) {
+			P[count - 1] = V3f(1.0e+6f, 0.0f, 0.0f);
+		}
+		points.getSchema().set(OPointsSchema::Sample(P3fArraySample(P), UInt64ArraySample(ids)));
+		OV3fGeomParam(points.getSchema().getArbGeomParams(), "v", false, kVaryingScope, 1).set(OV3fGeomParam::Sample(V3fArraySample(v), kVaryingScope));
+		return path;
+	}
+}
+
+namespace {
+	// Xformごとに点群を1つ持つ
+	std::string write_point_xforms(const std::string &path, const std::vector<std::string> &names) {
+		using namespace Alembic::AbcGeom;
+
+		OArchive archive(Alembic::AbcCoreOgawa::WriteArchive(), path);
+		std::vector<V3f> P = { V3f(0, 0, 0), V3f(1, 0, 0) };
+		std::vector<uint64_t> ids = { 0, 1 };
+		for (const std::string &name : names) {
+			OXform xform(archive.getTop(), name);
+			XformSample xformSample;
+			xform.getSchema().set(xformSample);
+			OPoints points(xform, name + "_points");
+			points.getSchema().set(OPointsSchema::Sample(P3fArraySample(P), UInt64ArraySample(ids)));
+			OV3fGeomParam(points.getSchema().getArbGeomParams(), "v", false, kVaryingScope, 1).set(OV3fGeomParam::Sample(V3fArraySample(P), kVaryingScope));
+		}
+		return path;
+	}
+}
+
+TEST_CASE("file sequence", "[sequence]") {
+	using namespace houdini_alembic;
+
+	// 1001-1004は同じ階層で点の数だけが違う。1005は別の階層
+	std::vector<std::string> paths;
+	for (uint32_t i = 0; i < 5; ++i) {
+		char name[64];
+		sprintf(name, "test_case/sequence.%04d.abc", 1001 + i);
+		paths.push_back(ofToDataPath(name));
+		if (i < 4) {
+			write_point_cloud(paths.back(), 100 * (i + 1));
+		}
+		else {
+			write_typed_attributes(paths.back());
+		}
+	}
+
+	std::string error_message;
+	AlembicSequenceStorage storage;
+	storage.setPool(2, 2);
+	REQUIRE(storage.open(ofToDataPath("test_case/sequence.$F4.abc"), 1001, 1005, error_message));
+	REQUIRE(storage.frameCount() == 5);
+	for (uint32_t i = 0; i < 4; ++i) {
+		auto scene = storage.read(i, error_message);
+		REQUIRE(scene);
+		auto points = scene->point_FirstVisible();
+		REQUIRE(points);
+		REQUIRE(points->P.size() == 100 * (i + 1));
+		REQUIRE(points->points.column_as_vector3("v"));
+	}
+	{
+		auto scene = storage.read(4, error_message);
+		REQUIRE(scene);
+		REQUIRE(scene->polygonMesh_FirstVisible());
+		REQUIRE(scene->point_FirstVisible() == nullptr);
+	}
+	REQUIRE(storage.planCount() == 2);
+
+	// 戻っても、プールから追い出されたファイルを開き直して読める
+	for (uint32_t i : { 0u, 3u, 1u, 1u, 4u, 2u }) {
+		auto scene = storage.read(i, error_message);
+		REQUIRE(scene);
+		REQUIRE(scene->objects.size() == 1);
+	}
+	REQUIRE(storage.read(5, error_message) == nullptr);
+
+	// 同じ結果になる
+	{
+		AlembicStorage single;
+		REQUIRE(single.open(paths[4], error_message));
+		auto expected = single.read(0, error_message);
+		auto scene = storage.read(4, error_message);
+		REQUIRE(scene->objects.size() == expected->objects.size());
+		REQUIRE(scene->objects[0]->name == expected->objects[0]->name);
+		REQUIRE(scene->polygonMesh_FirstVisible()->points.columnCount() == expected->polygonMesh_FirstVisible()->points.columnCount());
+	}
+	storage.close();
+
+	{
+		AlembicSequenceStorage missing;
+		REQUIRE(missing.open(ofToDataPath("test_case/sequence.$F4.abc"), 1000, 1002, error_message) == false);
+		REQUIRE(missing.open(ofToDataPath("test_case/sequence.abc"), 1001, 1002, error_message) == false);
+
+		// 途中で欠けているフレームは読めないだけ
+		REQUIRE(missing.open(ofToDataPath("test_case/sequence.$F4.abc"), 1004, 1006, error_message));
+		REQUIRE(missing.read(1, error_message));
+		REQUIRE(missing.read(2, error_message) == nullptr);
+		REQUIRE(error_message.empty() == false);
+	}
+	for (auto &path : paths) {
+		std::remove(path.c_str());
+	}
+
+	// 名前が違っても同じ階層なら共有し、子の数が違えば別になる。先読みは渡したexecutorで行う
+	{
+		std::vector<std::string> shapes = {
+			write_point_xforms(ofToDataPath("test_case/shapes.0001.abc"), { "a" }),
+			write_point_xforms(ofToDataPath("test_case/shapes.0002.abc"), { "b" }),
+			write_point_xforms(ofToDataPath("test_case/shapes.0003.abc"), { "a", "b" }),
+			write_point_xforms(ofToDataPath("test_case/shapes.0004.abc"), { "c" }),
+		};
+		std::shared_ptr<TaskExecutor> executor(new TaskExecutor(2));
+		AlembicSequenceStorage shapeStorage;
+		shapeStorage.setExecutor(executor);
+		REQUIRE(shapeStorage.executor() == executor);
+		REQUIRE(shapeStorage.open(shapes, error_message));
+		uint32_t expectedObjects[] = { 1, 1, 2, 1 };
+		for (uint32_t i = 0; i < 4; ++i) {
+			auto scene = shapeStorage.read(i, error_message);
+			REQUIRE(scene);
+			REQUIRE(scene->objects.size() == expectedObjects[i]);
+		}
+		REQUIRE(shapeStorage.read(3, error_message)->objects[0]->name == "/c");
+		REQUIRE(shapeStorage.planCount() == 2);
+		shapeStorage.close();
+
+		uint64_t executed = 0;
+		for (auto &s : executor->stats()) {
+			executed += s.executed;
+		}
+		REQUIRE(0 < executed);
+		for (auto &path : shapes) {
+			std::remove(path.c_str());
+		}
+	}
+}
+
+namespace {
+	// シーンの中身を文字列にする。スレッドの中ではREQUIREできないので、後で比べる
+	std::string scene_signature(const houdini_alembic::AlembicScene &scene) {
+		using namespace houdini_alembic;
+
+		std::string signature;
+		char buffer[256];
+		auto add_sheet = [&](const AttributeSpreadSheet &sheet) {
+			for (const auto &attribute : sheet.sheet) {
+				signature += attribute.key + ":";
+				for (uint32_t i = 0; i < attribute.column->rowCount(); ++i) {
+					attribute.column->snprint(i, buffer, sizeof(buffer));
+					signature += buffer;
+					signature += ",";
+				}
+			}
+		};
+		for (const auto &o : scene.objects) {
+			signature += o->name + ";";
+			if (auto mesh = o.as_polygonMesh()) {
+				signature.append((const char *)mesh->P.data(), mesh->P.size() * sizeof(Vector3f));
+				add_sheet(mesh->points);
+				add_sheet(mesh->vertices);
+				add_sheet(mesh->primitives);
+			}
+			if (auto point = o.as_point()) {
+				add_sheet(point->points);
+			}
+			if (auto curve = o.as_curve()) {
+				add_sheet(curve->points);
+			}
+		}
+		return signature;
+	}
+}
+
+TEST_CASE("concurrent reads", "[concurrent]") {
+	using namespace houdini_alembic;
+
+	const int kFrames = 8;
+	std::string path = write_animated_polymesh(ofToDataPath("test_case/concurrent.abc"), kFrames);
+	for (bool memoryMapped : { true, false }) {
+		std::string error_message;
+		AlembicStorage storage;
+		storage.setStreams(4, memoryMapped);
+		REQUIRE(storage.open(path, error_message));
+		REQUIRE(storage.streamCount() == 4);
+		REQUIRE((int)storage.frameCount() == kFrames);
+
+		std::vector<std::string> expected;
+		for (int i = 0; i < kFrames; ++i) {
+			auto scene = storage.read(i, error_message);
+			REQUIRE(scene);
+			expected.push_back(scene_signature(*scene));
+		}
+		REQUIRE(expected[0] != expected[1]);
+
+		const int kThreads = 8;
+		const int kReads = 24;
+		std::vector<std::vector<std::pair<int, std::string>>> results(kThreads);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < kThreads; ++t) {
+			threads.emplace_back([&, t]() {
+				std::mt19937 random(t);
+				std::string message;
+				for (int i = 0; i < kReads; ++i) {
+					int frame = random() % kFrames;
+					auto scene = storage.read(frame, message);
+					results[t].emplace_back(frame, scene ? scene_signature(*scene) : message);
+				}
+			});
+		}
+		for (auto &thread : threads) {
+			thread.join();
+		}
+		for (auto &result : results) {
+			for (auto &read : result) {
+				REQUIRE(read.second == expected[read.first]);
+			}
+		}
+	}
+	std::remove(path.c_str());
+}
+
+TEST_CASE("task executor", "[executor]") {
+	using namespace houdini_alembic;
+
+	TaskExecutor executor(3);
+	REQUIRE(executor.workerCount() == 3);
+	{
+		std::vector<std::atomic<int>> visited(10000);
+		for (auto &v : visited) {
+			v = 0;
+		}
+		executor.parallelFor((uint32_t)visited.size(), [&](uint32_t i) {
+			visited[i]++;
+		});
+		for (auto &v : visited) {
+			REQUIRE(v == 1);
+		}
+	}
+
+	// 入れ子で待っても詰まらない
+	{
+		std::atomic<int> sum(0);
+		executor.parallelFor(16, [&](uint32_t i) {
+			executor.parallelFor(100, [&](uint32_t j) {
+				sum += (int)j;
+			});
+		});
+		REQUIRE(sum == 16 * 4950);
+	}
+
+	REQUIRE_THROWS_AS(executor.parallelFor(100, [&](uint32_t i) {
+		if (i == 42) {
+			throw std::runtime_error("task failed");
+		}
+	}), std::runtime_error);
+
+	std::vector<TaskExecutor::WorkerStats> stats = executor.stats();
+	REQUIRE(stats.size() == 4);
+	uint64_t executed = 0;
+	for (auto &s : stats) {
+		REQUIRE(s.stolen <= s.executed);
+		executed += s.executed;
+	}
+	REQUIRE(0 < executed);
+	executor.resetStats();
+	REQUIRE(executor.stats()[3].executed == 0);
+
+	// スレッドなしでも同じように動く
+	{
+		TaskExecutor inline_executor(0);
+		int sum = 0;
+		inline_executor.parallelFor(10, [&](uint32_t i) {
+			sum += (int)i;
+		});
+		REQUIRE(sum == 45);
+	}
+
+	// submitはワーカーで順に始まり、破棄の前に全部終わる
+	{
+		std::vector<int> order;
+		std::mutex mutex;
+		{
+			TaskExecutor queue(1);
+			for (int i = 0; i < 100; ++i) {
+				queue.submit([&order, &mutex, i]() {
+					std::lock_guard<std::mutex> lock(mutex);
+					order.push_back(i);
+				});
+			}
+		}
+		REQUIRE(order.size() == 100);
+		for (int i = 0; i < 100; ++i) {
+			REQUIRE(order[i] == i);
+		}
+
+		TaskExecutor inline_executor(0);
+		std::thread::id ran;
+		inline_executor.submit([&ran]() { ran = std::this_thread::get_id(); });
+		REQUIRE(ran == std::this_thread::get_id());
+	}
+
+	// ジョブが最後の参照を放しても詰まらない
+	{
+		std::promise<void> go;
+		std::shared_future<void> started = go.get_future().share();
+		std::promise<void> done;
+		std::future<void> finished = done.get_future();
+		std::shared_ptr<TaskExecutor> owned(new TaskExecutor(2));
+		owned->submit([owned, started, &done]() mutable {
+			started.wait();
+			owned->parallelFor(8, [](uint32_t) {});
+			owned.reset();
+			done.set_value();
+		});
+		owned.reset();
+		go.set_value();
+		REQUIRE(finished.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+	}
+
+	// 並列に組み立てても同じシーンになる
+	std::string typed = write_typed_attributes(ofToDataPath("test_case/executor_typed.abc"));
+	for (std::string path : { typed, ofToDataPath("test_case/polymesh_attributes.abc"), ofToDataPath("lines_and_curves.abc") }) {
+		std::string error_message;
+		AlembicStorage serial;
+		serial.setExecutor(std::shared_ptr<TaskExecutor>(new TaskExecutor(0)));
+		REQUIRE(serial.open(path, error_message));
+
+		AlembicStorage parallel;
+		std::shared_ptr<TaskExecutor> shared(new TaskExecutor(3));
+		parallel.setExecutor(shared);
+		REQUIRE(parallel.executor() == shared);
+		REQUIRE(parallel.open(path, error_message));
+
+		for (uint32_t i = 0; i < std::min(serial.frameCount(), 3u); ++i) {
+			auto a = serial.read(i, error_message);
+			auto b = parallel.read(i, error_message);
+			REQUIRE(a);
+			REQUIRE(b);
+			REQUIRE(scene_signature(*a) == scene_signature(*b));
+		}
+	}
+	std::remove(typed.c_str());
+}
+
+TEST_CASE("async reads", "[async]") {
+	using namespace houdini_alembic;
+
+	const int kFrames = 6;
+	std::string path = write_animated_polymesh(ofToDataPath("test_case/async.abc"), kFrames);
+	std::string error_message;
+	AlembicStorage storage;
+	storage.setExecutor(std::shared_ptr<TaskExecutor>(new TaskExecutor(2)));
+	REQUIRE(storage.open(path, error_message));
+
+	std::vector<std::string> expected;
+	for (int i = 0; i < kFrames; ++i) {
+		auto scene = storage.read(i, error_message);
+		REQUIRE(scene);
+		expected.push_back(scene_signature(*scene));
+	}
+
+	// 全フレームを一度に頼んでも、それぞれ read() と同じシーンになる
+	std::vector<std::future<std::shared_ptr<AlembicScene>>> futures;
+	for (int i = 0; i < kFrames; ++i) {
+		futures.push_back(storage.read_async(i));
+	}
+	for (int i = 0; i < kFrames; ++i) {
+		auto scene = futures[i].get();
+		REQUIRE(scene);
+		REQUIRE(scene_signature(*scene) == expected[i]);
+	}
+
+	// completion はどのスレッドからでも呼ばれうる
+	{
+		std::promise<std::string> done;
+		storage.read_async(2, [&done](std::shared_ptr<AlembicScene> scene, const std::string &message) {
+			done.set_value(scene ? scene_signature(*scene) : "error: " + message);
+		});
+		REQUIRE(done.get_future().get() == expected[2]);
+	}
+
+	// executorの2つのワーカーだけで読む。スレッドは増えない
+	{
+		std::mutex mutex;
+		std::set<std::thread::id> threads;
+		std::vector<std::future<void>> done;
+		for (int n = 0; n < 4; ++n) {
+			for (int i = 0; i < kFrames; ++i) {
+				std::shared_ptr<std::promise<void>> promise(new std::promise<void>());
+				done.push_back(promise->get_future());
+				storage.read_async(i, [&mutex, &threads, promise](std::shared_ptr<AlembicScene> scene, const std::string &message) {
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						threads.insert(std::this_thread::get_id());
+					}
+					promise->set_value();
+				});
+			}
+		}
+		for (auto &f : done) {
+			f.get();
+		}
+		REQUIRE(threads.size() <= 2);
+		REQUIRE(threads.count(std::this_thread::get_id()) == 0);
+	}
+
+	// executorの最後の参照を読み込みが持っていても終わる
+	{
+		AlembicStorage owned;
+		owned.setExecutor(std::shared_ptr<TaskExecutor>(new TaskExecutor(1)));
+		REQUIRE(owned.open(path, error_message));
+		auto future = owned.read_async(4);
+		owned.setExecutor(std::shared_ptr<TaskExecutor>());
+		owned.close();
+		auto scene = future.get();
+		REQUIRE(scene);
+		REQUIRE(scene_signature(*scene) == expected[4]);
+	}
+
+	// 取り消されたら null が返る
+	{
+		auto cancellation = std::make_shared<ReadCancellation>();
+		cancellation->cancel();
+		REQUIRE(cancellation->isCancelled());
+		REQUIRE_FALSE(storage.read_async(1, cancellation).get());
+
+		std::promise<std::string> done;
+		storage.read_async(1, [&done](std::shared_ptr<AlembicScene> scene, const std::string &message) {
+			done.set_value(scene ? std::string("scene") : message);
+		}, cancellation);
+		REQUIRE(done.get_future().get().empty());
+	}
+
+	// 読み終える前に閉じても結果は受け取れる
+	{
+		auto future = storage.read_async(3);
+		storage.close();
+		auto scene = future.get();
+		REQUIRE(scene);
+		REQUIRE(scene_signature(*scene) == expected[3]);
+	}
+
+	// 閉じたストレージからは読めない
+	REQUIRE_THROWS_AS(storage.read_async(0).get(), std::runtime_error);
+
+	std::remove(path.c_str());
+}
+
+TEST_CASE("range reads", "[range]") {
+	using namespace houdini_alembic;
+
+	const int kFrames = 5;
+	std::string path = write_animated_polymesh(ofToDataPath("test_case/range.abc"), kFrames);
+	for (std::string file : { path, ofToDataPath("lines_and_curves.abc") }) {
+		INFO(file);
+		std::string error_message;
+		AlembicStorage storage;
+		storage.setExecutor(std::shared_ptr<TaskExecutor>(new TaskExecutor(2)));
+		REQUIRE(storage.open(file, error_message));
+
+		uint32_t end = std::min<uint32_t>(storage.frameCount(), kFrames);
+		auto scenes = storage.read_range(0, end, error_message);
+		REQUIRE(scenes.size() == end);
+		for (uint32_t i = 0; i < end; ++i) {
+			auto scene = storage.read(i, error_message);
+			REQUIRE(scene);
+			REQUIRE(scenes[i]);
+			REQUIRE(scene_signature(*scenes[i]) == scene_signature(*scene));
+		}
+
+		auto tail = storage.read_range(1, end, error_message);
+		REQUIRE(tail.size() == end - 1);
+		REQUIRE(storage.read_range(2, 2, error_message).empty());
+	}
+
+	// Pだけが動くので、他の列は前のフレームと共有される
+	{
+		std::string error_message;
+		AlembicStorage storage;
+		REQUIRE(storage.open(path, error_message));
+		auto scenes = storage.read_range(0, kFrames, error_message);
+		REQUIRE(scenes.size() == kFrames);
+		for (int i = 1; i < kFrames; ++i) {
+			auto a = scenes[i - 1]->polygonMesh_FirstVisible();
+			auto b = scenes[i]->polygonMesh_FirstVisible();
+			REQUIRE(a->points.column("P") != b->points.column("P"));
+			REQUIRE(a->faceCounts == b->faceCounts);
+			REQUIRE(a->indices == b->indices);
+			REQUIRE(0 < b->vertices.columnCount());
+			for (const auto &attribute : b->vertices.sheet) {
+				INFO(attribute.key);
+				REQUIRE(a->vertices.column(attribute.key.c_str()) == attribute.column.get());
+			}
+		}
+	}
+
+	// 量子化された列は共有されても量子化し直さない
+	{
+		const uint32_t count = 5000;
+		std::string points = write_point_cloud(ofToDataPath("test_case/range_points.abc"), count);
+		std::string error_message;
+		AlembicStorage storage;
+		REQUIRE(storage.open(points, error_message));
+		storage.setPointQuantization(0.001f);
+		auto scenes = storage.read_range(0, 3, error_message);
+		REQUIRE(scenes.size() == 3);
+		auto single = storage.read(0, error_message);
+		for (auto &scene : scenes) {
+			auto a = single->point_FirstVisible();
+			auto b = scene->point_FirstVisible();
+			REQUIRE(b->points.column("P") == scenes[0]->point_FirstVisible()->points.column("P"));
+			REQUIRE(b->points.column_as_vector3("P")->storageType() == AttributeStorageType_UInt16);
+			require_same_sheet(a->points, b->points);
+		}
+		scenes.clear();
+		std::remove(points.c_str());
+	}
+
+	std::remove(path.c_str());
+}
+
+TEST_CASE("read stats", "[stats]") {
+	using namespace houdini_alembic;
+
+	const int kFrames = 4;
+	std::string path = write_animated_polymesh(ofToDataPath("test_case/stats.abc"), kFrames);
+	std::string error_message;
+	AlembicStorage storage;
+	storage.setExecutor(std::shared_ptr<TaskExecutor>(new TaskExecutor(2)));
+	REQUIRE(storage.open(path, error_message));
+	REQUIRE_FALSE(storage.statsEnabled());
+	REQUIRE(storage.read(0, error_message));
+	REQUIRE(storage.stats().frames == 0);
+
+	storage.setStatsEnabled(true);
+	REQUIRE(storage.statsEnabled());
+
+	// 別のストレージの読み込みは数えない
+	AlembicStorage other;
+	REQUIRE(other.open(path, error_message));
+	REQUIRE(other.read(1, error_message));
+	REQUIRE(storage.stats().bytesRead == 0);
+
+	std::shared_ptr<AlembicScene> scene;
+	for (int i = 0; i < kFrames; ++i) {
+		scene = storage.read(i, error_message, std::move(scene));
+		REQUIRE(scene);
+	}
+	ReadStats stats = storage.stats();
+	REQUIRE(stats.frames == kFrames);
+	REQUIRE(0 < stats.bytesRead);
+	REQUIRE(0 < stats.readCalls);
+	uint64_t histogram = 0;
+	for (uint64_t count : stats.readSizeHistogram) {
+		histogram += count;
+	}
+	REQUIRE(histogram == stats.readCalls);
+	REQUIRE(0 < stats.parseAttributesNanoseconds);
+	REQUIRE(0 < stats.extractPNanoseconds);
+	REQUIRE(stats.allocatedObjects == 1);
+	REQUIRE(stats.recycledObjects == kFrames - 1);
+	REQUIRE(stats.recycleHitRate() == Approx(0.75));
+	REQUIRE(0 < stats.parsedColumns);
+
+	std::string name = scene->objects[0]->name;
+	REQUIRE(stats.objectBytes.count(name));
+	REQUIRE(stats.attributeBytes.count(name + "/P"));
+	REQUIRE(stats.attributeBytes[name + "/P"] <= stats.objectBytes[name]);
+	REQUIRE(stats.objectBytes[name] <= stats.bytesRead);
+
+	// 変わらない列は read_range で共有される
+	storage.resetStats();
+	REQUIRE(storage.stats().bytesRead == 0);
+	REQUIRE(storage.read_range(0, kFrames, error_message).size() == kFrames);
+	stats = storage.stats();
+	REQUIRE(stats.frames == kFrames);
+	REQUIRE(0 < stats.sharedColumns);
+	REQUIRE(0.0 < stats.columnShareRate());
+
+	storage.setStatsEnabled(false);
+	REQUIRE(storage.stats().frames == 0);
+	std::remove(path.c_str());
+}
+
+TEST_CASE("memory usage", "[memory]") {
+	using namespace houdini_alembic;
+
+	// 手で組んだシーン
+	{
+		std::shared_ptr<PolygonMeshObject> mesh(new PolygonMeshObject());
+		mesh->name = std::string(100, 'm');
+		mesh->P.resize(1000);
+		mesh->indices.resize(3000);
+		AlembicScene scene;
+		scene.objects.emplace_back(mesh);
+
+		uint64_t buffers = sizeof(PolygonMeshObject) + 101 + mesh->P.capacity() * sizeof(Vector3f) + mesh->indices.capacity() * sizeof(uint32_t);
+
+		// meshがまだ外から参照されている
+		MemoryUsage held = scene.memoryUsage();
+		REQUIRE(buffers <= held.sharedBytes);
+		REQUIRE(held.ownedBytes == scene.objects.capacity() * sizeof(SceneObjectPointer));
+
+		mesh.reset();
+		MemoryUsage usage = scene.memoryUsage();
+		REQUIRE(usage.sharedBytes == 0);
+		REQUIRE(usage.totalBytes() == held.totalBytes());
+		REQUIRE(usage.ownedBytes == buffers + scene.objects.capacity() * sizeof(SceneObjectPointer));
+		REQUIRE(scene.objects[0]->memoryUsage().ownedBytes == buffers);
+
+		// 同じオブジェクトを2度参照しても1度だけ数える
+		scene.objects.emplace_back(scene.objects[0].pointer());
+		MemoryUsage twice = scene.memoryUsage();
+		REQUIRE(twice.sharedBytes == 0);
+		REQUIRE(twice.ownedBytes == buffers + scene.objects.capacity() * sizeof(SceneObjectPointer));
+	}
+
+	// 読み込んだシーン。文字列表はストレージと共有する
+	{
+		std::string error_message;
+		AlembicStorage storage;
+		REQUIRE(storage.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message));
+		auto scene = storage.read(0, error_message);
+		REQUIRE(scene);
+		auto polymesh = scene->polygonMesh_FirstVisible();
+		REQUIRE(polymesh);
+
+		auto strings = polymesh->points.column_as_string("string_points");
+		REQUIRE(strings);
+		MemoryUsage column = strings->memoryUsage();
+		REQUIRE(0 < column.ownedBytes);
+		REQUIRE(0 < column.sharedBytes);
+
+		MemoryUsage usage = scene->memoryUsage();
+		REQUIRE(polymesh->P.size() * sizeof(Vector3f) + column.ownedBytes < usage.ownedBytes);
+		REQUIRE(usage.sharedBytes == column.sharedBytes);
+		for (const auto &attribute : polymesh->vertices.sheet) {
+			REQUIRE(attribute.column->memoryUsage().totalBytes() <= usage.totalBytes());
+		}
+	}
+
+	// read_rangeで前のフレームと共有した列は、そのフレームが残っている間だけ共有
+	{
+		const int kFrames = 3;
+		std::string path = write_animated_polymesh(ofToDataPath("test_case/memory.abc"), kFrames);
+		std::string error_message;
+		AlembicStorage storage;
+		REQUIRE(storage.open(path, error_message));
+		auto scenes = storage.read_range(0, kFrames, error_message);
+		REQUIRE(scenes.size() == kFrames);
+
+		MemoryUsage last = scenes.back()->memoryUsage();
+		REQUIRE(0 < last.sharedBytes);
+
+		std::shared_ptr<AlembicScene> scene = scenes.back();
+		scenes.clear();
+		MemoryUsage alone = scene->memoryUsage();
+		REQUIRE(alone.totalBytes() == last.totalBytes());
+		REQUIRE(alone.sharedBytes < last.sharedBytes);
+		std::remove(path.c_str());
+	}
+}
+
+TEST_CASE("loader trace", "[trace]") {
+	using namespace houdini_alembic;
+
+	std::string path = write_animated_polymesh(ofToDataPath("test_case/trace.abc"), 3);
+	std::string json = ofToDataPath("test_case/trace.json");
+	std::string error_message;
+
+	REQUIRE_FALSE(LoaderTrace::isRecording());
+	LoaderTrace::clear();
+	{
+		AlembicStorage storage;
+		REQUIRE(storage.open(path, error_message));
+		REQUIRE(storage.read(0, error_message));
+		REQUIRE(LoaderTrace::write(json, error_message));
+		REQUIRE(count_of(read_text(json), "\"ph\":\"X\"") == 0);
+	}
+
+	LoaderTrace::start();
+	REQUIRE(LoaderTrace::isRecording());
+	{
+		AlembicStorage storage;
+		storage.setExecutor(std::shared_ptr<TaskExecutor>(new TaskExecutor(2)));
+		REQUIRE(storage.open(path, error_message));
+		for (uint32_t i = 0; i < 3; ++i) {
+			REQUIRE(storage.read(i, error_message));
+		}
+		TraceSpan span("application frame");
+	}
+	REQUIRE(LoaderTrace::write(json, error_message));
+	std::string text = read_text(json);
+	REQUIRE(text.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0);
+	REQUIRE(count_of(text, "\"name\":\"AlembicStorage::open\"") == 1);
+	REQUIRE(count_of(text, "\"name\":\"AlembicStorage::read\"") == 3);
+	REQUIRE(count_of(text, "\"name\":\"parse_leaf\"") == 3);
+	REQUIRE(count_of(text, "\"name\":\"application frame\"") == 1);
+	for (const char *name : { "parse_polymesh", "parse_common_property", "parse_attributes", "ReadArraySample", "IStreams::read" }) {
+		INFO(name);
+		REQUIRE(0 < count_of(text, std::string("\"name\":\"") + name + "\""));
+	}
+	REQUIRE(0 < count_of(text, "\"bytes\":"));
+
+	// リングバッファには最近のものだけが残る
+	LoaderTrace::clear();
+	LoaderTrace::start(0.2);
+	{
+		AlembicStorage storage;
+		REQUIRE(storage.open(path, error_message));
+		REQUIRE(storage.read(0, error_message));
+		std::this_thread::sleep_for(std::chrono::milliseconds(400));
+		REQUIRE(storage.read(1, error_message));
+
+		REQUIRE(LoaderTrace::write(json, error_message));
+		text = read_text(json);
+		REQUIRE(count_of(text, "\"name\":\"AlembicStorage::read\"") == 1);
+		REQUIRE(count_of(text, "\"label\":\"frame 1\"") == 1);
+		REQUIRE(count_of(text, "\"name\":\"AlembicStorage::open\"") == 0);
+
+		// 遅いフレームで書き出される。書き出しは読み込みのスレッドの外で、結果はコールバックに届く
+		std::string prefix = ofToDataPath("test_case/slow_frame_");
+		std::mutex reportedMutex;
+		std::vector<std::pair<std::string, std::string>> reported;
+		auto report = [&](const std::string &dumpPath, const std::string &dumpError) {
+			std::lock_guard<std::mutex> lock(reportedMutex);
+			reported.emplace_back(dumpPath, dumpError);
+		};
+		uint32_t dumps = LoaderTrace::slowFrameDumpCount();
+		LoaderTrace::setSlowFrameDump(1.0e-9, prefix, report);
+		REQUIRE(storage.read(2, error_message));
+		LoaderTrace::setSlowFrameDump(0.0, std::string());
+		LoaderTrace::flushSlowFrameDumps();
+		REQUIRE(LoaderTrace::slowFrameDumpCount() == dumps + 1);
+		std::string dumped = prefix + std::to_string(dumps) + ".json";
+		REQUIRE(reported.size() == 1);
+		REQUIRE(reported[0].first == dumped);
+		REQUIRE(reported[0].second.empty());
+		REQUIRE(0 < count_of(read_text(dumped), "\"label\":\"frame 2\""));
+		std::remove(dumped.c_str());
+
+		// 書けないときはエラーが届く
+		reported.clear();
+		LoaderTrace::setSlowFrameDump(1.0e-9, ofToDataPath("test_case/no_such_directory/slow_frame_"), report);
+		REQUIRE(storage.read(0, error_message));
+		LoaderTrace::setSlowFrameDump(0.0, std::string());
+		LoaderTrace::flushSlowFrameDumps();
+		REQUIRE(reported.size() == 1);
+		REQUIRE_FALSE(reported[0].second.empty());
+	}
+	LoaderTrace::stop();
+	REQUIRE_FALSE(LoaderTrace::isRecording());
+	LoaderTrace::clear();
+
+	std::remove(json.c_str());
+	std::remove(path.c_str());
+}
+
+TEST_CASE("quantized points", "[quantize]") {
+	using namespace houdini_alembic;
+
+	const uint32_t count = 10000;
+	const float maxError = 0.001f;
+	std::string path = write_point_cloud(ofToDataPath("test_case/quantized_points.abc"), count);
+	{
+		std::string error_message;
+		AlembicStorage exact;
+		AlembicStorage quantized;
+		REQUIRE(exact.open(path, error_message));
+		REQUIRE(quantized.open(path, error_message));
+		quantized.setPointQuantization(maxError);
+
+		auto sceneA = exact.read(0, error_message);
+		auto sceneB = quantized.read(0, error_message);
+		auto a = sceneA->point_FirstVisible();
+		auto b = sceneB->point_FirstVisible();
+		REQUIRE(a);
+		REQUIRE(b);
+		REQUIRE(a->P.size() == count);
+		REQUIRE(b->P.empty());
+
+		for (const char *key : { "P", "v" }) {
+			INFO(key);
+			auto columnA = a->points.column_as_vector3(key);
+			auto columnB = b->points.column_as_vector3(key);
+			REQUIRE(columnB);
+			REQUIRE(columnB->storageType() == AttributeStorageType_UInt16);
+			REQUIRE(columnB->rowCount() == count);
+
+			std::vector<float> rowsA(count * 3);
+			std::vector<float> rowsB(count * 3);
+			columnA->getRows(0, count, rowsA.data());
+			columnB->getRows(0, count, rowsB.data());
+			for (uint32_t i = 0; i < count; ++i) {
+				float xyz[3];
+				columnB->get(i, xyz);
+				for (int j = 0; j < 3; ++j) {
+					float x = rowsA[i * 3 + j];
+					float tolerance = maxError + std::abs(x) * FLT_EPSILON * 4.0f;
+					REQUIRE(std::abs(rowsB[i * 3 + j] - x) <= tolerance);
+					REQUIRE(xyz[j] == rowsB[i * 3 + j]);
+				}
+			}
+
+			// ブロックの途中から
+			std::vector<float> middle(5000 * 3);
+			columnB->getRows(3000, 5000, middle.data());
+			REQUIRE(memcmp(middle.data(), rowsB.data() + 3000 * 3, middle.size() * sizeof(float)) == 0);
+		}
+
+		// 外れ値のブロックはfloatのまま
+		float last[3];
+		b->points.column_as_vector3("P")->get(count - 1, last);
+		REQUIRE(last[0] == 1.0e+6f);
+
+		// 書き出すとPが戻る
+		std::string written = ofToDataPath("test_case/quantized_points_written.abc");
+		{
+			AlembicWriter writer;
+			REQUIRE(writer.open(written, error_message));
+			REQUIRE(writer.write(*sceneB, error_message));
+			writer.close();
+		}
+		{
+			AlembicStorage storage;
+			REQUIRE(storage.open(written, error_message));
+			auto scene = storage.read(0, error_message);
+			REQUIRE(scene->point_FirstVisible()->P.size() == count);
+		}
+		std::remove(written.c_str());
+	}
+	std::remove(path.c_str());
+}
+
+TEST_CASE("attribute handles", "[handles]") {
+	using namespace houdini_alembic;
+
+	AttributeHandle untyped("string_points");
+	TypedAttributeHandle<AttributeStringColumn> typed("string_points");
+	TypedAttributeHandle<AttributeFloatColumn> wrongType("string_points");
+	AttributeHandle missing("no_such_attribute");
+	REQUIRE(untyped.isValid());
+	REQUIRE(AttributeHandle().isValid() == false);
+	REQUIRE(untyped.key() == "string_points");
+	REQUIRE(typed.key() == "string_points");
+	REQUIRE(AttributeHandle("string_points").id() == untyped.id());
+	REQUIRE(typed.id() != untyped.id());
+	REQUIRE(wrongType.id() != typed.id());
+
+	std::string error_message;
+	AlembicStorage storage;
+	REQUIRE(storage.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message));
+	auto scene = storage.read(0, error_message);
+	REQUIRE(scene);
+	auto polymesh = scene->polygonMesh_FirstVisible();
+	REQUIRE(polymesh);
+
+	const AttributeSpreadSheet &points = polymesh->points;
+	REQUIRE(points.column(untyped) == points.column("string_points"));
+	REQUIRE(points.column(typed) == points.column_as_string("string_points"));
+	REQUIRE(points.column(typed) != nullptr);
+	REQUIRE(points.column(wrongType) == nullptr);
+	REQUIRE(points.column(missing) == nullptr);
+	REQUIRE(points.column(AttributeHandle()) == nullptr);
+
+	// 読み込み後に作ったハンドルはキーで引き、次に読んだシーンからは索引で引く
+	std::vector<const AttributeSpreadSheet *> sheets = { &polymesh->points, &polymesh->vertices, &polymesh->primitives, &polymesh->details };
+	std::vector<AttributeHandle> handles;
+	for (const AttributeSpreadSheet *sheet : sheets) {
+		for (const auto &attribute : sheet->sheet) {
+			handles.emplace_back(attribute.key);
+			REQUIRE(sheet->column(handles.back()) == attribute.column.get());
+		}
+	}
+	auto again = storage.read(0, error_message);
+	auto polymeshAgain = again->polygonMesh_FirstVisible();
+	std::vector<const AttributeSpreadSheet *> sheetsAgain = { &polymeshAgain->points, &polymeshAgain->vertices, &polymeshAgain->primitives, &polymeshAgain->details };
+	for (std::size_t k = 0; k < sheetsAgain.size(); ++k) {
+		for (const AttributeHandle &handle : handles) {
+			INFO(handle.key());
+			REQUIRE(sheetsAgain[k]->column(handle) == sheetsAgain[k]->column(handle.key().c_str()));
+		}
+	}
+
+	// 手で組んだシートは索引が無くても引ける
+	{
+		AttributeSpreadSheet sheet;
+		sheet.sheet = polymesh->points.sheet;
+		REQUIRE(sheet.column(typed) == points.column(typed));
+		REQUIRE(sheet.column(wrongType) == nullptr);
+		sheet.index();
+		REQUIRE(sheet.column(typed) == points.column(typed));
+		REQUIRE(sheet.column(untyped) == points.column(untyped));
+		REQUIRE(sheet.column(wrongType) == nullptr);
+
+		sheet.clear();
+		REQUIRE(sheet.column(typed) == nullptr);
+	}
+
+	// シーンキャッシュのシートも同じハンドルで引ける
+	{
+		std::string path = ofToDataPath("test_case/handles.cache");
+		{
+			SceneCacheWriter writer;
+			REQUIRE(writer.open(path, error_message));
+			REQUIRE(writer.write(*scene, error_message));
+			writer.close();
+		}
+		SceneCacheStorage cache;
+		REQUIRE(cache.open(path, error_message));
+		auto cached = cache.read(0, error_message);
+		REQUIRE(cached);
+		auto strings = cached->polygonMesh_FirstVisible()->points.column(typed);
+		REQUIRE(strings);
+		REQUIRE(strings->get(0) == points.column(typed)->get(0));
+		cached.reset();
+		cache.close();
+		std::remove(path.c_str());
+	}
+}
+
+namespace {
+	// 三角形の符号付き面積 (xy平面)
+	float signed_area(const houdini_alembic::PolygonMeshObject &mesh, const uint32_t *corners) {
+		const houdini_alembic::Vector3f &a = mesh.P[corners[0]];
+		const houdini_alembic::Vector3f &b = mesh.P[corners[1]];
+		const houdini_alembic::Vector3f &c = mesh.P[corners[2]];
+		return 0.5f * ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x));
+	}
+}
+
+TEST_CASE("triangulation", "[triangulate]") {
+	using namespace houdini_alembic;
+
+	// 三角形、四角形、凹んだ角の隣から始まるL字の六角形、辺だけの面
+	PolygonMeshObject mesh;
+	mesh.name = "/mesh";
+	mesh.P = {
+		{ 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 },
+		{ 2, 0, 0 }, { 3, 0, 0 }, { 3, 1, 0 }, { 2, 1, 0 },
+		{ 2, 3, 0 }, { 1, 3, 0 }, { 1, 5, 0 }, { 0, 5, 0 }, { 0, 2, 0 }, { 2, 2, 0 },
+	};
+	mesh.faceCounts = { 3, 4, 6, 2 };
+	mesh.indices = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 0, 1 };
+	const float lShapeArea = 2.0f * 1.0f + 1.0f * 2.0f;
+
+	std::string error_message;
+	for (TriangulationMethod method : { TriangulationMethod_Fan, TriangulationMethod_EarClip }) {
+		auto triangulation = triangulate(mesh, method, error_message);
+		REQUIRE(triangulation);
+		REQUIRE(triangulation->faceOffsets == std::vector<uint32_t>({ 0, 3, 7, 13, 15 }));
+		REQUIRE(triangulation->triangleOffsets == std::vector<uint32_t>({ 0, 1, 3, 7, 7 }));
+		REQUIRE(triangulation->triangleCount() == 7);
+		REQUIRE(triangulation->triangleFaces == std::vector<uint32_t>({ 0, 1, 1, 2, 2, 2, 2 }));
+		for (uint32_t i = 0; i < triangulation->indices.size(); ++i) {
+			REQUIRE(triangulation->indices[i] == mesh.indices[triangulation->vertices[i]]);
+		}
+		for (uint32_t t = 0; t < 3; ++t) {
+			REQUIRE(0.0f < signed_area(mesh, triangulation->indices.data() + t * 3));
+		}
+
+		float area = 0.0f;
+		bool flipped = false;
+		for (uint32_t t = 3; t < 7; ++t) {
+			float a = signed_area(mesh, triangulation->indices.data() + t * 3);
+			area += std::fabs(a);
+			flipped = flipped || a < 0.0f;
+		}
+		// 扇形では凹んだ角を越えて裏返った三角形ができる
+		if (method == TriangulationMethod_EarClip) {
+			REQUIRE(flipped == false);
+			REQUIRE(area == Approx(lShapeArea));
+		}
+		else {
+			REQUIRE(flipped);
+		}
+	}
+
+	// 裏向きの面も面の向きのまま分ける
+	{
+		PolygonMeshObject reversed = mesh;
+		std::reverse(reversed.indices.begin() + 7, reversed.indices.begin() + 13);
+		auto triangulation = triangulate(reversed, TriangulationMethod_EarClip, error_message);
+		REQUIRE(triangulation);
+		float area = 0.0f;
+		for (uint32_t t = 3; t < 7; ++t) {
+			float a = signed_area(reversed, triangulation->indices.data() + t * 3);
+			REQUIRE(a < 0.0f);
+			area -= a;
+		}
+		REQUIRE(area == Approx(lShapeArea));
+	}
+
+	// faceCountsとindicesが合わない
+	{
+		PolygonMeshObject broken = mesh;
+		broken.indices.pop_back();
+		error_message.clear();
+		REQUIRE(triangulate(broken, TriangulationMethod_Fan, error_message) == nullptr);
+		REQUIRE(error_message.empty() == false);
+
+		broken = mesh;
+		broken.indices[0] = (uint32_t)mesh.P.size();
+		error_message.clear();
+		REQUIRE(triangulate(broken, TriangulationMethod_EarClip, error_message) == nullptr);
+		REQUIRE(error_message.empty() == false);
+	}
+
+	// 並列に分けても1スレッドと同じ結果になる
+	{
+		PolygonMeshObject big;
+		uint32_t seed = 1;
+		auto next = [&seed]() {
+			seed = seed * 1664525u + 1013904223u;
+			return seed >> 8;
+		};
+		for (uint32_t face = 0; face < 50000; ++face) {
+			uint32_t n = 3 + next() % 6;
+			float cx = (float)(face % 300);
+			float cy = (float)(face / 300);
+			for (uint32_t i = 0; i < n; ++i) {
+				float angle = -2.0f * 3.14159265f * i / n;
+				float radius = i % 2 ? 0.25f : 0.45f;
+				big.indices.push_back((uint32_t)big.P.size());
+				big.P.push_back(Vector3f(cx + radius * std::cos(angle), cy + radius * std::sin(angle), 0.0f));
+			}
+			big.faceCounts.push_back(n);
+		}
+		TaskExecutor serial(0);
+		TaskExecutor parallel(3);
+		for (TriangulationMethod method : { TriangulationMethod_Fan, TriangulationMethod_EarClip }) {
+			auto a = triangulate(big, method, error_message, &serial);
+			auto b = triangulate(big, method, error_message, &parallel);
+			REQUIRE(a);
+			REQUIRE(b);
+			REQUIRE(a->faceOffsets == b->faceOffsets);
+			REQUIRE(a->triangleOffsets == b->triangleOffsets);
+			REQUIRE(a->vertices == b->vertices);
+			REQUIRE(a->indices == b->indices);
+			REQUIRE(a->triangleFaces == b->triangleFaces);
+		}
+	}
+
+	// トポロジーが変わらない間は前のフレームの結果を使う
+	{
+		const int kFrames = 4;
+		std::string path = write_animated_polymesh(ofToDataPath("test_case/triangulate.abc"), kFrames);
+		AlembicStorage storage;
+		REQUIRE(storage.open(path, error_message));
+
+		TriangulationCache cache;
+		std::shared_ptr<const Triangulation> first;
+		for (int frame = 0; frame < kFrames; ++frame) {
+			auto scene = storage.read(frame, error_message);
+			auto polymesh = scene->polygonMesh_FirstVisible();
+			auto triangulation = cache.triangulate(*polymesh, error_message);
+			REQUIRE(triangulation);
+			if (frame == 0) {
+				first = triangulation;
+				uint32_t triangles = 0;
+				for (uint32_t f : polymesh->faceCounts) {
+					triangles += f - 2;
+				}
+				REQUIRE(triangulation->triangleCount() == triangles);
+			}
+			REQUIRE(triangulation == first);
+		}
+		REQUIRE(cache.misses() == 1);
+		REQUIRE(cache.hits() == kFrames - 1);
+
+		auto scene = storage.read(0, error_message);
+		PolygonMeshObject changed = *scene->polygonMesh_FirstVisible();
+		std::swap(changed.indices[0], changed.indices[1]);
+		auto triangulation = cache.triangulate(changed, error_message);
+		REQUIRE(triangulation != first);
+		REQUIRE(cache.misses() == 2);
+
+		cache.clear();
+		REQUIRE(cache.hits() == 0);
+		std::remove(path.c_str());
+	}
+}
+
+TEST_CASE("quantized points benchmark", "[.][benchmark]") {
+	using namespace houdini_alembic;
+
+	const uint32_t count = 4000000;
+	std::string path = write_point_cloud(ofToDataPath("test_case/quantized_points_benchmark.abc"), count);
+	{
+		std::string error_message;
+		AlembicStorage exact;
+		AlembicStorage quantized;
+		REQUIRE(exact.open(path, error_message));
+		REQUIRE(quantized.open(path, error_message));
+		quantized.setPointQuantization(0.01f);
+
+		auto sceneA = exact.read(0, error_message);
+		auto sceneB = quantized.read(0, error_message);
+		auto a = sceneA->point_FirstVisible()->points.column_as_vector3("P");
+		auto b = sceneB->point_FirstVisible()->points.column_as_vector3("P");
+
+		std::vector<float> xyz(count * 3);
+		BENCHMARK("getRows float32") {
+			a->getRows(0, count, xyz.data());
+		}
+		BENCHMARK("getRows quantized") {
+			b->getRows(0, count, xyz.data());
+		}
+		BENCHMARK("get quantized") {
+			for (uint32_t i = 0; i < count; ++i) {
+				b->get(i, xyz.data() + i * 3);
+			}
+		}
+	}
+	std::remove(path.c_str());
+}
+
+TEST_CASE("read allocations benchmark", "[.][benchmark]") {
+	using namespace houdini_alembic;
+
+	std::string error_message;
+	AlembicStorage storage;
+	REQUIRE(storage.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message));
+	storage.read(0, error_message);
+	std::shared_ptr<AlembicScene> recycled = storage.read(0, error_message);
+
+#if defined(HOUDINI_ALEMBIC_COUNT_ALLOCATIONS)
+	// 読み込みと解放で何回ヒープを確保するか
+	uint64_t beg = g_allocation_count;
+	for (int i = 0; i < 10; ++i) {
+		auto scene = storage.read(0, error_message);
+		REQUIRE(scene);
+	}
+	uint64_t count = (g_allocation_count - beg) / 10;
+	WARN("AlembicStorage::read: " << count << " allocations per frame");
+
+	beg = g_allocation_count;
+	for (int i = 0; i < 10; ++i) {
+		recycled = storage.read(0, error_message, std::move(recycled));
+		REQUIRE(recycled);
+	}
+	count = (g_allocation_count - beg) / 10;
+	WARN("AlembicStorage::read (recycled): " << count << " allocations per frame");
+#endif
+
+	auto scene = storage.read(0, error_message);
+	WARN("arena: " << scene->arena->bytesUsed() << " bytes used, " << scene->arena->bytesReserved() << " bytes reserved, " << scene->arena->blockCount() << " blocks");
+
+	BENCHMARK("AlembicStorage::read") {
+		storage.read(0, error_message);
+	}
+	BENCHMARK("AlembicStorage::read (recycled)") {
+		recycled = storage.read(0, error_message, std::move(recycled));
+	}
+}
+
+TEST_CASE("attribute handles benchmark", "[.][benchmark]") {
+	using namespace houdini_alembic;
+
+	std::string error_message;
+	AlembicStorage storage;
+	REQUIRE(storage.open(ofToDataPath("test_case/polymesh_attributes.abc"), error_message));
+
+	// 読む前に作ったハンドルは索引に載る
+	static const TypedAttributeHandle<AttributeStringColumn> kStrings("string_points");
+	auto scene = storage.read(0, error_message);
+	const AttributeSpreadSheet &indexed = scene->polygonMesh_FirstVisible()->points;
+	REQUIRE(indexed.column(kStrings));
+
+	const int kLookups = 1000000;
+	const AttributeColumn *found = nullptr;
+	BENCHMARK("column_as_string") {
+		for (int i = 0; i < kLookups; ++i) {
+			found = indexed.column_as_string("string_points");
+		}
+	}
+	BENCHMARK("TypedAttributeHandle") {
+		for (int i = 0; i < kLookups; ++i) {
+			found = indexed.column(kStrings);
+		}
+	}
+	REQUIRE(found);
+}